@@ -5,15 +5,19 @@ cbuffer PerFrameBuffer : register(b0)
 	matrix ViewProjectionMatrix;
 }
 
-cbuffer PerObject : register(b1)
+struct PerObject
 {
 	matrix WorldMatrix;
 	float4 Color;
-}
+};
+
+// Every object of the frame, written once per frame by D3D11RenderBackend
+StructuredBuffer<PerObject> Objects : register(t0);
 
 struct VertexInput
 {
 	float2 Position : POSITION;
+	uint Object : OBJECT;
 };
 
 struct PixelInput
@@ -25,10 +29,11 @@ struct PixelInput
 PixelInput VS(VertexInput input)
 {
 	PixelInput output = (PixelInput)0;
+	PerObject object = Objects[input.Object];
 	float4 pos = float4(input.Position.x, 0.0, input.Position.y, 1.0);
-	output.Position = mul(pos, WorldMatrix);
+	output.Position = mul(pos, object.WorldMatrix);
 	output.Position = mul(output.Position, ViewProjectionMatrix);
-	output.Color = Color;
+	output.Color = object.Color;
 	
 	return output;
 }
@@ -0,0 +1,53 @@
+cbuffer CameraBuffer : register(b0)
+{
+	matrix ViewMatrix;
+	matrix ProjectionMatrix;
+	matrix ViewProjectionMatrix;
+	matrix ViewportMatrix;
+	float3 CameraPosition;
+	float padding;
+}
+
+struct VertexInput
+{
+	float3 Position : POSITION;
+	float2 TexCoord : TEXCOORD0;
+	float3 Normal : NORMAL0;
+	// One per static feature, see StaticFeatureInstance
+	float2 InstancePosition : INSTANCE_POSITION;
+	float InstanceRotation : INSTANCE_ROTATION;
+	float InstanceScale : INSTANCE_SCALE;
+	float4 InstanceColor : INSTANCE_COLOR;
+};
+
+struct PixelInput
+{
+	float4 Position: SV_POSITION;
+	float2 TexCoord: TEXCOORD0;
+	float3 Normal : NORMAL0;
+	float4 Color : COLOR;
+};
+
+PixelInput VS(VertexInput input)
+{
+	PixelInput output = (PixelInput)0;
+	// Same as scaling by (scale, 1, scale), rotating about Y and translating to (x, 1, y)
+	float s, c;
+	sincos(input.InstanceRotation, s, c);
+	float2 xz = input.Position.xz * input.InstanceScale;
+	float4 pos = float4(
+		xz.x * c + xz.y * s + input.InstancePosition.x,
+		input.Position.y + 1.0,
+		xz.y * c - xz.x * s + input.InstancePosition.y,
+		1.0);
+	output.Position = mul(pos, ViewProjectionMatrix);
+	output.TexCoord = input.TexCoord;
+	output.Normal = input.Normal;
+	output.Color = input.InstanceColor;
+	return output;
+}
+
+float4 PS(PixelInput input) : SV_TARGET
+{
+	return input.Color;
+}
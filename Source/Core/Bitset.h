@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+// Dynamically sized, densely packed set of bits indexed by mesh element (region, side, triangle...).
+// Unlike std::vector<bool> the backing words are exposed, so whole words can be scanned or cleared at once.
+class Bitset
+{
+	std::vector<uint64_t> _words;
+	size_t _size;
+
+	static size_t _WordCount(size_t size) { return (size + 63) / 64; }
+
+public:
+	Bitset() : _size(0) {}
+	explicit Bitset(size_t size) : _words(_WordCount(size), 0), _size(size) {}
+
+	void Resize(size_t size)
+	{
+		_words.resize(_WordCount(size), 0);
+		_size = size;
+	}
+
+	void Clear() { std::fill(_words.begin(), _words.end(), 0); }
+
+	bool Test(size_t i) const { return (_words[i >> 6] >> (i & 63)) & 1; }
+	void Set(size_t i) { _words[i >> 6] |= uint64_t(1) << (i & 63); }
+	void Reset(size_t i) { _words[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+
+	// Sets bit i and returns whether it was already set
+	bool TestAndSet(size_t i)
+	{
+		auto mask = uint64_t(1) << (i & 63);
+		auto& word = _words[i >> 6];
+		bool was_set = (word & mask) != 0;
+		word |= mask;
+		return was_set;
+	}
+
+	size_t Size() const { return _size; }
+	size_t WordCount() const { return _words.size(); }
+	uint64_t* Words() { return _words.data(); }
+	const uint64_t* Words() const { return _words.data(); }
+};
+
+// Fixed size set of bits that several threads can set at once. TestAndSet is a single fetch_or,
+// so when threads race for the same bit exactly one of them sees it unset.
+class AtomicBitset
+{
+	std::unique_ptr<std::atomic<uint64_t>[]> _words;
+	size_t _size;
+
+	static size_t _WordCount(size_t size) { return (size + 63) / 64; }
+
+public:
+	AtomicBitset() : _size(0) {}
+
+	// Contents are undefined until Clear()
+	void Resize(size_t size)
+	{
+		if (_WordCount(size) != _WordCount(_size))
+			_words.reset(new std::atomic<uint64_t>[_WordCount(size)]);
+		_size = size;
+	}
+
+	void Clear()
+	{
+		for (size_t i = 0; i < _WordCount(_size); i++)
+			_words[i].store(0, std::memory_order_relaxed);
+	}
+
+	bool Test(size_t i) const { return (_words[i >> 6].load(std::memory_order_relaxed) >> (i & 63)) & 1; }
+
+	// Sets bit i and returns whether it was already set
+	bool TestAndSet(size_t i)
+	{
+		auto mask = uint64_t(1) << (i & 63);
+		auto& word = _words[i >> 6];
+		// A plain load first keeps already visited bits from bouncing the cache line between cores
+		if (word.load(std::memory_order_relaxed) & mask)
+			return true;
+		return (word.fetch_or(mask, std::memory_order_relaxed) & mask) != 0;
+	}
+
+	size_t Size() const { return _size; }
+};
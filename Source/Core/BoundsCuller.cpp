@@ -0,0 +1,106 @@
+#include "BoundsCuller.h"
+#include "DebugTools.h"
+#include <emmintrin.h>
+#include <bitset>
+#include <cfloat>
+
+BoundsCuller::BoundsCuller()
+	: _slot_count(0)
+	, _visible_count(0)
+{
+}
+
+void BoundsCuller::_SetEmpty(uint32_t slot)
+{
+	_min_x[slot] = FLT_MAX;
+	_min_y[slot] = FLT_MAX;
+	_max_x[slot] = -FLT_MAX;
+	_max_y[slot] = -FLT_MAX;
+}
+
+uint32_t BoundsCuller::Add(const XMFLOAT2& min, const XMFLOAT2& max)
+{
+	uint32_t slot;
+	if (!_free_slots.empty())
+	{
+		slot = _free_slots.back();
+		_free_slots.pop_back();
+	}
+	else
+	{
+		slot = _slot_count++;
+		if (slot == _min_x.size())
+		{
+			auto padded = _min_x.size() + BOUNDS_CULLER_LANES;
+			_min_x.resize(padded, FLT_MAX);
+			_min_y.resize(padded, FLT_MAX);
+			_max_x.resize(padded, -FLT_MAX);
+			_max_y.resize(padded, -FLT_MAX);
+			_visible.Resize(padded);
+		}
+	}
+	Set(slot, min, max);
+	return slot;
+}
+
+void BoundsCuller::Set(uint32_t slot, const XMFLOAT2& min, const XMFLOAT2& max)
+{
+	ASSERT(slot < _slot_count);
+	_min_x[slot] = min.x;
+	_min_y[slot] = min.y;
+	_max_x[slot] = max.x;
+	_max_y[slot] = max.y;
+}
+
+void BoundsCuller::Remove(uint32_t slot)
+{
+	ASSERT(slot < _slot_count);
+	_SetEmpty(slot);
+	_visible.Reset(slot);
+	_free_slots.push_back(slot);
+}
+
+size_t BoundsCuller::Cull(const XMFLOAT2& view_min, const XMFLOAT2& view_max)
+{
+	auto view_min_x = _mm_set1_ps(view_min.x);
+	auto view_min_y = _mm_set1_ps(view_min.y);
+	auto view_max_x = _mm_set1_ps(view_max.x);
+	auto view_max_y = _mm_set1_ps(view_max.y);
+
+	// 16 groups of four boxes fill one 64 bit word of the result
+	auto words = _visible.Words();
+	size_t visible_count = 0;
+	uint64_t word = 0;
+	size_t padded = _min_x.size();
+	for (size_t i = 0; i < padded; i += BOUNDS_CULLER_LANES)
+	{
+		auto inside = _mm_and_ps(
+			_mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&_min_x[i]), view_max_x), _mm_cmpge_ps(_mm_loadu_ps(&_max_x[i]), view_min_x)),
+			_mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&_min_y[i]), view_max_y), _mm_cmpge_ps(_mm_loadu_ps(&_max_y[i]), view_min_y)));
+		word |= static_cast<uint64_t>(_mm_movemask_ps(inside)) << (i & 63);
+		if ((i & 63) == 64 - BOUNDS_CULLER_LANES || i + BOUNDS_CULLER_LANES == padded)
+		{
+			words[i >> 6] = word;
+			visible_count += std::bitset<64>(word).count();
+			word = 0;
+		}
+	}
+	_visible_count = visible_count;
+	return visible_count;
+}
+
+size_t BoundsCuller::CullScalar(const XMFLOAT2& view_min, const XMFLOAT2& view_max)
+{
+	_visible.Clear();
+	size_t visible_count = 0;
+	for (uint32_t i = 0; i < _slot_count; ++i)
+	{
+		if (_min_x[i] <= view_max.x && _max_x[i] >= view_min.x && _min_y[i] <= view_max.y && _max_y[i] >= view_min.y)
+		{
+			_visible.Set(i);
+			visible_count++;
+		}
+	}
+	_visible_count = visible_count;
+	return visible_count;
+}
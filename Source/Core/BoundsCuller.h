@@ -0,0 +1,45 @@
+#pragma once
+#include <Core/StdIncludes.h>
+#include "Bitset.h"
+
+// Boxes tested per SSE instruction. Slot arrays are always padded to a multiple of this.
+#define BOUNDS_CULLER_LANES 4
+
+/*
+Axis aligned boxes kept as four separate arrays (min x, min y, max x, max y) so Cull() can load
+one coordinate of four boxes with a single instruction and test them against a rectangle with
+SSE. The result is a bit per slot. Padding and removed slots hold an inverted box that never
+intersects anything; Add() reuses removed slots before appending. */
+class BoundsCuller
+{
+	std::vector<float> _min_x;
+	std::vector<float> _min_y;
+	std::vector<float> _max_x;
+	std::vector<float> _max_y;
+	std::vector<uint32_t> _free_slots;
+	// Slots handed out so far, including removed ones
+	uint32_t _slot_count;
+	Bitset _visible;
+	size_t _visible_count;
+
+	void _SetEmpty(uint32_t slot);
+
+public:
+	BoundsCuller();
+
+	uint32_t Add(const XMFLOAT2& min, const XMFLOAT2& max);
+	void Set(uint32_t slot, const XMFLOAT2& min, const XMFLOAT2& max);
+	void Remove(uint32_t slot);
+
+	// Marks every box that touches the rectangle as visible and returns how many do
+	size_t Cull(const XMFLOAT2& view_min, const XMFLOAT2& view_max);
+	// The same test one box at a time, to check and time Cull() against
+	size_t CullScalar(const XMFLOAT2& view_min, const XMFLOAT2& view_max);
+
+	// Results of the last cull
+	bool IsVisible(uint32_t slot) const { return _visible.Test(slot); }
+	size_t GetVisibleCount() const { return _visible_count; }
+	size_t GetCount() const { return _slot_count - _free_slots.size(); }
+};
+
+void RunBoundsCullingBenchmark();
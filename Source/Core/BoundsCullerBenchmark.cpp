@@ -0,0 +1,52 @@
+#include "BoundsCuller.h"
+#include "DebugTools.h"
+#include "Stopwatch.h"
+#include <random>
+
+void RunBoundsCullingBenchmark()
+{
+	// Features of up to a tile across scattered over the whole map at max zoom, with a view of
+	// a few screens panning across the middle
+	const uint32_t box_count = 1000000;
+	const int frames = 200;
+	const float map_width = 4194304.0f;
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> position(0.0f, map_width);
+	std::uniform_real_distribution<float> size(1.0f, 256.0f);
+
+	BoundsCuller culler;
+	for (uint32_t i = 0; i < box_count; ++i)
+	{
+		XMFLOAT2 min(position(random), position(random));
+		culler.Add(min, XMFLOAT2(min.x + size(random), min.y + size(random)));
+	}
+
+	auto view = [&](int frame, XMFLOAT2& view_min, XMFLOAT2& view_max)
+	{
+		view_min = XMFLOAT2(map_width * 0.25f + frame * 512.0f, map_width * 0.25f);
+		view_max = XMFLOAT2(view_min.x + 65536.0f, view_min.y + 65536.0f);
+	};
+
+	XMFLOAT2 view_min, view_max;
+	size_t scalar_visible = 0;
+	Stopwatch stopwatch;
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		view(frame, view_min, view_max);
+		scalar_visible += culler.CullScalar(view_min, view_max);
+	}
+	auto scalar_ms = stopwatch.Lap(L"Scalar AABB culling") / frames;
+
+	size_t simd_visible = 0;
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		view(frame, view_min, view_max);
+		simd_visible += culler.Cull(view_min, view_max);
+	}
+	auto simd_ms = stopwatch.Lap(L"SSE AABB culling") / frames;
+	ASSERT(simd_visible == scalar_visible);
+
+	PRINTF(L"%u boxes: scalar = %.3f ms/frame, SSE = %.3f ms/frame (%.0f boxes/us), %d visible and %d culled per frame%s\n",
+		box_count, scalar_ms, simd_ms, box_count / (simd_ms * 1000.0), static_cast<int>(simd_visible / frames),
+		static_cast<int>(box_count - simd_visible / frames), simd_visible == scalar_visible ? L"" : L" (MISMATCH)");
+}
@@ -1,9 +1,9 @@
 #pragma once
-#include "StdIncludes.h"
+#include <DirectXMath.h>
 
-inline XMFLOAT4 ConvertColor(unsigned color)
+inline DirectX::XMFLOAT4 ConvertColor(unsigned color)
 {
-	return XMFLOAT4
+	return DirectX::XMFLOAT4
 	(
 			(color >> 24 & 0xFF) / 255.f,
 			(color >> 16 & 0xFF) / 255.f,
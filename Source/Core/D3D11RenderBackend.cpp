@@ -0,0 +1,278 @@
+#include "D3D11RenderBackend.h"
+
+static const D3D11_PRIMITIVE_TOPOLOGY s_topologies[] =
+{
+	D3D11_PRIMITIVE_TOPOLOGY_POINTLIST,
+	D3D11_PRIMITIVE_TOPOLOGY_LINELIST,
+	D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST
+};
+
+D3D11RenderBackend::D3D11RenderBackend()
+	: _objects_buffer(nullptr)
+	, _objects_view(nullptr)
+	, _object_indices(nullptr)
+	, _objects_capacity(0)
+	, _camera_buffer(nullptr)
+	, _stats{}
+{
+	for (int i = 0; i < RENDER_TRANSIENT_BUFFER_COUNT; ++i)
+	{
+		_transient_buffers[i] = nullptr;
+		_transient_capacities[i] = 0;
+		_transient_cursors[i] = 0;
+		_buffers.push_back({ &_transient_buffers[i], 0, 0 });
+	}
+	_object_indices_id = static_cast<BufferID>(_buffers.size());
+	_buffers.push_back({ &_object_indices, sizeof(uint32_t), 0 });
+}
+
+D3D11RenderBackend::~D3D11RenderBackend()
+{
+	for (int i = 0; i < RENDER_TRANSIENT_BUFFER_COUNT; ++i)
+	{
+		if (_transient_buffers[i])
+			_transient_buffers[i]->Release();
+	}
+	if (_objects_view)
+		_objects_view->Release();
+	if (_objects_buffer)
+		_objects_buffer->Release();
+	if (_object_indices)
+		_object_indices->Release();
+}
+
+PipelineID D3D11RenderBackend::AddPipeline(ID3D11InputLayout* input_layout, Shader& shader)
+{
+	_pipelines.push_back({ input_layout, shader.GetVertexShader(), shader.GetPixelShader() });
+	return static_cast<PipelineID>(_pipelines.size() - 1);
+}
+
+BufferID D3D11RenderBackend::AddBuffer(ID3D11Buffer* const* buffer, UINT stride)
+{
+	ASSERT(_buffers.size() < RENDER_NO_BUFFER);
+	_buffers.push_back({ buffer, stride, 0 });
+	return static_cast<BufferID>(_buffers.size() - 1);
+}
+
+bool D3D11RenderBackend::_UploadTransient(ID3D11DeviceContext* context, const RenderCommandBuffer& commands, BufferID buffer)
+{
+	auto byte_size = commands.GetTransientByteSize(buffer);
+	if (byte_size == 0)
+		return true;
+
+	auto& capacity = _transient_capacities[buffer];
+	auto& cursor = _transient_cursors[buffer];
+	auto& gpu_buffer = _transient_buffers[buffer];
+	if (byte_size > capacity)
+	{
+		// Grow geometrically so a growing frame reallocates only a few times
+		auto new_capacity = max(static_cast<size_t>(RENDER_TRANSIENT_MIN_CAPACITY), capacity);
+		while (new_capacity < byte_size * RENDER_TRANSIENT_RING_FRAMES)
+			new_capacity *= 2;
+
+		if (gpu_buffer)
+			gpu_buffer->Release();
+		gpu_buffer = nullptr;
+		capacity = 0;
+
+		D3D11_BUFFER_DESC desc;
+		ZeroMemory(&desc, sizeof(desc));
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.ByteWidth = static_cast<UINT>(new_capacity);
+		desc.BindFlags = buffer == RENDER_TRANSIENT_INDICES ? D3D11_BIND_INDEX_BUFFER : D3D11_BIND_VERTEX_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		auto device = GraphicsWindow::GetInstance()->GetDevice();
+		if (!D3DCheck(device->CreateBuffer(&desc, nullptr, &gpu_buffer),
+			L"ID3D11Device::CreateBuffer (D3D11RenderBackend, TransientBuffer)")) return false;
+		capacity = new_capacity;
+		// A new buffer starts with a discard
+		cursor = new_capacity;
+	}
+
+	// Data the GPU may still be reading lies before the cursor, so append after it and only
+	// discard the whole ring when the frame does not fit in what is left
+	auto offset = (cursor + 15) & ~static_cast<size_t>(15);
+	auto map_type = D3D11_MAP_WRITE_NO_OVERWRITE;
+	if (offset + byte_size > capacity)
+	{
+		offset = 0;
+		map_type = D3D11_MAP_WRITE_DISCARD;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mappedRes;
+	if (!D3DCheck(context->Map(gpu_buffer, 0, map_type, 0, &mappedRes),
+		L"ID3D11DeviceContext::Map (D3D11RenderBackend::_UploadTransient)")) return false;
+	memcpy(static_cast<uint8_t*>(mappedRes.pData) + offset, commands.GetTransientData(buffer), byte_size);
+	context->Unmap(gpu_buffer, 0);
+	cursor = offset + byte_size;
+	_buffers[buffer].stride = commands.GetTransientStride(buffer);
+	_buffers[buffer].offset = static_cast<UINT>(offset);
+	return true;
+}
+
+bool D3D11RenderBackend::_ReserveObjects(size_t object_count)
+{
+	if (object_count <= _objects_capacity)
+		return true;
+
+	auto new_capacity = max(static_cast<size_t>(RENDER_OBJECTS_MIN_CAPACITY), _objects_capacity);
+	while (new_capacity < object_count)
+		new_capacity *= 2;
+
+	if (_objects_view)
+		_objects_view->Release();
+	if (_objects_buffer)
+		_objects_buffer->Release();
+	if (_object_indices)
+		_object_indices->Release();
+	_objects_view = nullptr;
+	_objects_buffer = nullptr;
+	_object_indices = nullptr;
+	_objects_capacity = 0;
+
+	auto device = GraphicsWindow::GetInstance()->GetDevice();
+	D3D11_BUFFER_DESC desc;
+	ZeroMemory(&desc, sizeof(desc));
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.ByteWidth = static_cast<UINT>(new_capacity * sizeof(RenderObject));
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	desc.StructureByteStride = sizeof(RenderObject);
+	if (!D3DCheck(device->CreateBuffer(&desc, nullptr, &_objects_buffer),
+		L"ID3D11Device::CreateBuffer (D3D11RenderBackend, ObjectsBuffer)")) return false;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC view_desc;
+	ZeroMemory(&view_desc, sizeof(view_desc));
+	view_desc.Format = DXGI_FORMAT_UNKNOWN;
+	view_desc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	view_desc.Buffer.FirstElement = 0;
+	view_desc.Buffer.NumElements = static_cast<UINT>(new_capacity);
+	if (!D3DCheck(device->CreateShaderResourceView(_objects_buffer, &view_desc, &_objects_view),
+		L"ID3D11Device::CreateShaderResourceView (D3D11RenderBackend, ObjectsBuffer)")) return false;
+
+	// The indices never change, only their count
+	std::vector<uint32_t> indices(new_capacity);
+	for (size_t i = 0; i < new_capacity; ++i)
+		indices[i] = static_cast<uint32_t>(i);
+	ZeroMemory(&desc, sizeof(desc));
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.ByteWidth = static_cast<UINT>(new_capacity * sizeof(uint32_t));
+	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	D3D11_SUBRESOURCE_DATA data;
+	ZeroMemory(&data, sizeof(data));
+	data.pSysMem = indices.data();
+	if (!D3DCheck(device->CreateBuffer(&desc, &data, &_object_indices),
+		L"ID3D11Device::CreateBuffer (D3D11RenderBackend, ObjectIndices)")) return false;
+
+	_objects_capacity = new_capacity;
+	return true;
+}
+
+bool D3D11RenderBackend::_UploadObjects(ID3D11DeviceContext* context, const RenderCommandBuffer& commands)
+{
+	auto& objects = commands.GetObjects();
+	if (objects.empty())
+		return true;
+	if (!_ReserveObjects(objects.size()))
+		return false;
+
+	// The whole frame in one map; the objects are already packed the way the shader reads them
+	D3D11_MAPPED_SUBRESOURCE mappedRes;
+	if (!D3DCheck(context->Map(_objects_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedRes),
+		L"ID3D11DeviceContext::Map (D3D11RenderBackend::_UploadObjects)")) return false;
+	memcpy(mappedRes.pData, objects.data(), objects.size() * sizeof(RenderObject));
+	context->Unmap(_objects_buffer, 0);
+	_stats.object_uploads++;
+	return true;
+}
+
+void D3D11RenderBackend::Execute(const RenderCommandBuffer& commands)
+{
+	_stats = RenderFrameStats{};
+	auto context = GraphicsWindow::GetInstance()->GetContext();
+	for (BufferID i = 0; i < RENDER_TRANSIENT_BUFFER_COUNT; ++i)
+	{
+		if (!_UploadTransient(context, commands, i))
+			return;
+		_stats.transient_bytes += commands.GetTransientByteSize(i);
+	}
+
+	if (!_UploadObjects(context, commands))
+		return;
+
+	context->VSSetConstantBuffers(0, 1, &_camera_buffer);
+	context->PSSetConstantBuffers(0, 1, &_camera_buffer);
+	context->VSSetShaderResources(0, 1, &_objects_view);
+	auto samplerState = GraphicsWindow::GetInstance()->GetStandardSamplerState();
+	context->PSSetSamplers(0, 1, &samplerState);
+
+	// Whatever was drawn since the last frame may have changed any of it
+	_state.Reset();
+	auto pipeline_id = static_cast<uint32_t>(-1);
+	for (auto& command : commands.GetCommands())
+	{
+		auto& pipeline = _pipelines[command.pipeline];
+		if (command.pipeline != pipeline_id)
+		{
+			pipeline_id = command.pipeline;
+			_stats.pipeline_changes++;
+		}
+		if (_state.SetInputLayout(pipeline.input_layout))
+			context->IASetInputLayout(pipeline.input_layout);
+		if (_state.SetTopology(command.topology))
+			context->IASetPrimitiveTopology(s_topologies[static_cast<int>(command.topology)]);
+		if (_state.SetVertexShader(pipeline.vertex_shader))
+			context->VSSetShader(pipeline.vertex_shader, nullptr, 0);
+		if (_state.SetPixelShader(pipeline.pixel_shader))
+			context->PSSetShader(pipeline.pixel_shader, nullptr, 0);
+
+		auto instance_buffer_id = command.instance_buffer;
+		auto first_instance = command.first_instance;
+		auto instance_count = command.instance_count;
+		if (command.object != RENDER_NO_OBJECT)
+		{
+			ASSERT(instance_buffer_id == RENDER_NO_BUFFER);
+			instance_buffer_id = _object_indices_id;
+			first_instance = command.object;
+			instance_count = max(command.instance_count, 1u);
+		}
+
+		auto& vertex_buffer = _buffers[command.vertex_buffer];
+		if (_state.SetVertexBuffers(command.vertex_buffer, instance_buffer_id))
+		{
+			if (instance_buffer_id != RENDER_NO_BUFFER)
+			{
+				auto& instance_buffer = _buffers[instance_buffer_id];
+				ID3D11Buffer* buffers[2] = { *vertex_buffer.buffer, *instance_buffer.buffer };
+				UINT strides[2] = { vertex_buffer.stride, instance_buffer.stride };
+				UINT offsets[2] = { vertex_buffer.offset, instance_buffer.offset };
+				context->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+			}
+			else
+			{
+				context->IASetVertexBuffers(0, 1, vertex_buffer.buffer, &vertex_buffer.stride, &vertex_buffer.offset);
+			}
+		}
+
+		if (command.index_buffer != RENDER_NO_BUFFER && _state.SetIndexBuffer(command.index_buffer))
+		{
+			auto& index_buffer = _buffers[command.index_buffer];
+			context->IASetIndexBuffer(*index_buffer.buffer, DXGI_FORMAT_R32_UINT, index_buffer.offset);
+		}
+
+		if (instance_buffer_id != RENDER_NO_BUFFER && command.index_buffer != RENDER_NO_BUFFER)
+			context->DrawIndexedInstanced(command.count, instance_count, command.first, 0, first_instance);
+		else if (instance_buffer_id != RENDER_NO_BUFFER)
+			context->DrawInstanced(command.count, instance_count, command.first, first_instance);
+		else if (command.index_buffer != RENDER_NO_BUFFER)
+			context->DrawIndexed(command.count, command.first, 0);
+		else
+			context->Draw(command.count, command.first);
+		_stats.draw_calls++;
+		_stats.elements += static_cast<uint64_t>(command.count) * max(command.instance_count, 1u);
+	}
+	_stats.state_binds = _state.GetBindCount();
+	_stats.redundant_binds = _state.GetRedundantBindCount();
+}
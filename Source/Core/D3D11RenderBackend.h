@@ -0,0 +1,83 @@
+#pragma once
+#include <Core/StdIncludes.h>
+#include <Core/GraphicsWindow.h>
+#include <Core/Shader.h>
+#include "RenderCommandBuffer.h"
+#include "RenderStateCache.h"
+
+#define RENDER_TRANSIENT_MIN_CAPACITY 1024
+// Objects the per frame object buffer starts with
+#define RENDER_OBJECTS_MIN_CAPACITY 256
+// Frames of transient data a ring holds before it wraps and has to be discarded
+#define RENDER_TRANSIENT_RING_FRAMES 3
+
+/*
+Executes a RenderCommandBuffer on the window's device context. Pipelines are an input layout
+with the vertex and pixel shader of a Shader; buffers are registered by the address of the
+owner's pointer so a buffer its owner recreates is still found. The transient buffers of a frame
+are uploaded into dynamic ring buffers owned here. Each frame is written after the previous one
+with D3D11_MAP_WRITE_NO_OVERWRITE, so the driver does not have to rename the buffer, and a ring
+is only discarded when it wraps. Rings grow geometrically when a frame outgrows them.
+
+Every RenderObject of a frame is written with one map into a structured buffer bound to t0 of the
+vertex stage, instead of mapping a constant buffer per draw. A draw with an object becomes a one
+instance draw whose first instance is the object's index: a second vertex stream holding 0, 1,
+2... turns that into a per instance OBJECT input the shader indexes the buffer with. Draws with
+an object are therefore never instanced themselves.
+
+The camera constant buffer is bound to slot 0 of both stages once per frame. Per command state goes through a RenderStateCache,
+so sorted commands that share a layout, shaders, topology or buffers do not bind them again.
+Indices are always 32 bit. */
+class D3D11RenderBackend : public RenderBackend
+{
+	struct Pipeline
+	{
+		ID3D11InputLayout* input_layout;
+		ID3D11VertexShader* vertex_shader;
+		ID3D11PixelShader* pixel_shader;
+	};
+
+	struct Buffer
+	{
+		ID3D11Buffer* const* buffer;
+		UINT stride;
+		// Byte offset of this frame's data in a transient ring
+		UINT offset;
+	};
+
+	std::vector<Pipeline> _pipelines;
+	// Indexed by BufferID. The transient entries point into _transient_buffers.
+	std::vector<Buffer> _buffers;
+	ID3D11Buffer* _transient_buffers[RENDER_TRANSIENT_BUFFER_COUNT];
+	size_t _transient_capacities[RENDER_TRANSIENT_BUFFER_COUNT];
+	// Where the next frame's data is written
+	size_t _transient_cursors[RENDER_TRANSIENT_BUFFER_COUNT];
+	// The frame's objects, and the index stream that selects one per draw
+	ID3D11Buffer* _objects_buffer;
+	ID3D11ShaderResourceView* _objects_view;
+	ID3D11Buffer* _object_indices;
+	size_t _objects_capacity;
+	BufferID _object_indices_id;
+	ID3D11Buffer* _camera_buffer;
+	RenderStateCache _state;
+	RenderFrameStats _stats;
+
+	bool _UploadTransient(ID3D11DeviceContext* context, const RenderCommandBuffer& commands, BufferID buffer);
+	bool _ReserveObjects(size_t object_count);
+	bool _UploadObjects(ID3D11DeviceContext* context, const RenderCommandBuffer& commands);
+
+public:
+	D3D11RenderBackend();
+	~D3D11RenderBackend();
+
+	D3D11RenderBackend(D3D11RenderBackend const&) = delete;
+	D3D11RenderBackend& operator=(D3D11RenderBackend const&) = delete;
+
+	PipelineID AddPipeline(ID3D11InputLayout* input_layout, Shader& shader);
+	BufferID AddBuffer(ID3D11Buffer* const* buffer, UINT stride);
+	void SetCameraBuffer(ID3D11Buffer* camera_buffer) { _camera_buffer = camera_buffer; }
+
+	virtual void Execute(const RenderCommandBuffer& commands) override;
+	// Of the last Execute()
+	const RenderFrameStats& GetStats() const { return _stats; }
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include "StdIncludes.h"
+#include "Bitset.h"
+#include "ParallelFor.h"
+
+// Frontier slices smaller than this are expanded on the calling thread
+#define FRONTIER_SEARCH_MIN_CHUNK 1024
+
+/*
+Level synchronous breadth first flood fill over a graph of integer nodes, such as the regions of
+a DualMesh. Every level of the frontier is split into one slice per worker; each worker claims the
+neighbours it reaches with an atomic test-and-set on the visited bitmap and appends the ones it
+claimed to its own buffer, which become the next level. A node is therefore expanded exactly once
+and the set of nodes reached, and the level each is reached on, do not depend on the thread count.
+
+The visited bitmap and frontier buffers are kept between runs, so a search reused for several
+flood fills (ocean, lakes, biomes) does not allocate once its buffers have grown. */
+class ParallelFrontierSearch
+{
+	AtomicBitset _visited;
+	std::vector<int> _frontier;
+	std::vector<std::vector<int>> _next_frontiers;
+	int _level_count;
+	int _visited_count;
+
+public:
+	ParallelFrontierSearch() : _level_count(0), _visited_count(0) {}
+
+	// Floods out from the seeds through every node for which can_enter(node) is true.
+	// neighbors(node) returns an iterable range of node indices. on_visit(node, level) is called
+	// once per node reached, seeds on level 0, possibly from several threads at once but never
+	// twice for the same node.
+	template<typename Neighbors, typename CanEnter, typename OnVisit>
+	void Run(const int* seeds, int seed_count, int node_count, Neighbors neighbors, CanEnter can_enter, OnVisit on_visit, int thread_count = 0)
+	{
+		if (thread_count <= 0)
+			thread_count = GetWorkerThreadCount();
+		_visited.Resize(node_count);
+		_visited.Clear();
+		_next_frontiers.resize(thread_count);
+
+		_frontier.clear();
+		for (int i = 0; i < seed_count; i++)
+		{
+			if (!_visited.TestAndSet(seeds[i]))
+			{
+				_frontier.push_back(seeds[i]);
+				on_visit(seeds[i], 0);
+			}
+		}
+
+		_visited_count = 0;
+		_level_count = 0;
+		while (!_frontier.empty())
+		{
+			_visited_count += static_cast<int>(_frontier.size());
+			const int level = ++_level_count;
+			const int frontier_size = static_cast<int>(_frontier.size());
+			const int slice_count = max(1, min(thread_count, frontier_size / FRONTIER_SEARCH_MIN_CHUNK));
+			const int slice_size = (frontier_size + slice_count - 1) / slice_count;
+
+			ParallelFor(0, slice_count, 1, [&](int slice_begin, int slice_end)
+			{
+				for (int slice = slice_begin; slice < slice_end; slice++)
+				{
+					auto& next = _next_frontiers[slice];
+					next.clear();
+					for (int i = slice * slice_size; i < min(frontier_size, (slice + 1) * slice_size); i++)
+					{
+						for (auto neighbor : neighbors(_frontier[i]))
+						{
+							if (can_enter(neighbor) && !_visited.TestAndSet(neighbor))
+							{
+								next.push_back(neighbor);
+								on_visit(neighbor, level);
+							}
+						}
+					}
+				}
+			}, thread_count);
+
+			_frontier.clear();
+			for (int slice = 0; slice < slice_count; slice++)
+				_frontier.insert(_frontier.end(), _next_frontiers[slice].begin(), _next_frontiers[slice].end());
+		}
+		// The last level expanded found nothing new
+		_level_count = max(0, _level_count - 1);
+	}
+
+	template<typename Neighbors, typename CanEnter>
+	void Run(const int* seeds, int seed_count, int node_count, Neighbors neighbors, CanEnter can_enter, int thread_count = 0)
+	{
+		Run(seeds, seed_count, node_count, neighbors, can_enter, [](int, int) {}, thread_count);
+	}
+
+	bool IsVisited(int node) const { return _visited.Test(node); }
+	// Nodes reached by the last run, seeds included
+	int GetVisitedCount() const { return _visited_count; }
+	// Highest level reached by the last run; 0 when only the seeds were visited
+	int GetLevelCount() const { return _level_count; }
+};
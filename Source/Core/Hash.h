@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 
 inline int HashInt(int key) 
 {
@@ -17,4 +18,21 @@ inline int HashTriplet(int x, int y, int z)
 	y = HashInt(y);
 	z = HashInt(z);
 	return x ^ y ^ z;
-}
\ No newline at end of file
+}
+
+// SplitMix64 finalizer; every input bit affects every output bit
+inline uint64_t HashUint64(uint64_t key)
+{
+	key ^= key >> 30;
+	key *= 0xbf58476d1ce4e5b9ULL;
+	key ^= key >> 27;
+	key *= 0x94d049bb133111ebULL;
+	key ^= key >> 31;
+	return key;
+}
+
+// Uniform double in [0, 1) built from the top 53 bits of a hash
+inline double HashToUnitDouble(uint64_t hash)
+{
+	return static_cast<double>(hash >> 11) * (1.0 / 9007199254740992.0);
+}
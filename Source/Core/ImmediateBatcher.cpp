@@ -0,0 +1,94 @@
+#include "ImmediateBatcher.h"
+
+ImmediateBatcher::ImmediateBatcher(RenderCommandBuffer& commands, RenderLayer layer)
+	: _commands(commands)
+	, _layer(layer)
+	, _pipeline(0)
+	, _batch_count(0)
+	, _last_batch(0)
+	, _stats{}
+{
+}
+
+std::vector<XMFLOAT2>& ImmediateBatcher::_GetVertices(RenderTopology topology, unsigned color)
+{
+	_stats.calls++;
+	if (_last_batch < _batch_count && _batches[_last_batch].topology == topology && _batches[_last_batch].color == color)
+		return _batches[_last_batch].vertices;
+
+	// A frame uses a handful of colours, so a linear search beats hashing
+	for (_last_batch = 0; _last_batch < _batch_count; ++_last_batch)
+	{
+		auto& batch = _batches[_last_batch];
+		if (batch.topology == topology && batch.color == color)
+			return batch.vertices;
+	}
+	if (_batch_count == _batches.size())
+		_batches.emplace_back();
+	auto& batch = _batches[_batch_count++];
+	batch.topology = topology;
+	batch.color = color;
+	batch.vertices.clear();
+	return batch.vertices;
+}
+
+void ImmediateBatcher::AddLine(const XMFLOAT2& from, const XMFLOAT2& to, unsigned color)
+{
+	auto& vertices = _GetVertices(RenderTopology::LineList, color);
+	vertices.push_back(from);
+	vertices.push_back(to);
+}
+
+void ImmediateBatcher::AddLineStrip(const XMFLOAT2* strip, size_t vertex_count, unsigned color)
+{
+	if (vertex_count < 2)
+		return;
+	auto& vertices = _GetVertices(RenderTopology::LineList, color);
+	for (size_t i = 0; i + 1 < vertex_count; ++i)
+	{
+		vertices.push_back(strip[i]);
+		vertices.push_back(strip[i + 1]);
+	}
+}
+
+void ImmediateBatcher::AddTriangle(const XMFLOAT2& a, const XMFLOAT2& b, const XMFLOAT2& c, unsigned color)
+{
+	auto& vertices = _GetVertices(RenderTopology::TriangleList, color);
+	vertices.push_back(a);
+	vertices.push_back(b);
+	vertices.push_back(c);
+}
+
+void ImmediateBatcher::AddPoints(const XMFLOAT2* points, size_t point_count, unsigned color)
+{
+	if (point_count == 0)
+		return;
+	auto& vertices = _GetVertices(RenderTopology::PointList, color);
+	vertices.insert(vertices.end(), points, points + point_count);
+}
+
+void ImmediateBatcher::Flush()
+{
+	for (size_t i = 0; i < _batch_count; ++i)
+	{
+		auto& batch = _batches[i];
+		if (batch.vertices.empty())
+			continue;
+		auto count = static_cast<uint32_t>(batch.vertices.size());
+		auto first = _commands.AppendTransient(RENDER_TRANSIENT_VERTICES, batch.vertices.data(), count, sizeof(XMFLOAT2));
+		_commands.Draw(_layer, _pipeline, batch.topology, RENDER_TRANSIENT_VERTICES, first, count,
+			_commands.AddObject(XMMatrixIdentity(), batch.color));
+		_stats.batches++;
+		_stats.vertices += count;
+		batch.vertices.clear();
+	}
+	_batch_count = 0;
+}
+
+void ImmediateBatcher::Reset()
+{
+	for (size_t i = 0; i < _batch_count; ++i)
+		_batches[i].vertices.clear();
+	_batch_count = 0;
+	_stats = Stats{};
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <Core/StdIncludes.h>
+#include "RenderCommandBuffer.h"
+
+/*
+Accumulates the immediate mode draws of a frame (lines, strips, triangles and points) into one
+batch per topology and colour. Flush() appends each batch to the transient vertices of a
+RenderCommandBuffer and records one draw for it, so a debug overlay costs a draw per colour
+instead of a draw per call. Draws of different batches are not kept in call order, which only
+matters where overlay draws of different colours overlap. Line strips are expanded into line
+lists so they batch with single lines. Batches keep their capacity across frames. */
+class ImmediateBatcher
+{
+public:
+	struct Stats
+	{
+		uint32_t calls;
+		uint32_t batches;
+		uint32_t vertices;
+	};
+
+private:
+	struct Batch
+	{
+		RenderTopology topology;
+		unsigned color;
+		std::vector<XMFLOAT2> vertices;
+	};
+
+	RenderCommandBuffer& _commands;
+	RenderLayer _layer;
+	PipelineID _pipeline;
+	// Batches in order of first use; the first _batch_count are in use this frame
+	std::vector<Batch> _batches;
+	size_t _batch_count;
+	// Most calls continue the batch of the call before
+	size_t _last_batch;
+	Stats _stats;
+
+	std::vector<XMFLOAT2>& _GetVertices(RenderTopology topology, unsigned color);
+
+public:
+	ImmediateBatcher(RenderCommandBuffer& commands, RenderLayer layer);
+
+	ImmediateBatcher(ImmediateBatcher const&) = delete;
+	ImmediateBatcher& operator=(ImmediateBatcher const&) = delete;
+
+	void SetPipeline(PipelineID pipeline) { _pipeline = pipeline; }
+
+	void AddLine(const XMFLOAT2& from, const XMFLOAT2& to, unsigned color);
+	void AddLineStrip(const XMFLOAT2* vertices, size_t vertex_count, unsigned color);
+	void AddTriangle(const XMFLOAT2& a, const XMFLOAT2& b, const XMFLOAT2& c, unsigned color);
+	void AddPoints(const XMFLOAT2* points, size_t point_count, unsigned color);
+
+	// Records a draw for every batch and empties them. Call before the command buffer is sorted.
+	void Flush();
+	// Empties the batches and clears the statistics
+	void Reset();
+
+	const Stats& GetStats() const { return _stats; }
+};
+
+void RunImmediateBatcherBenchmark();
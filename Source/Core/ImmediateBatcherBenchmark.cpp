@@ -0,0 +1,75 @@
+#include "ImmediateBatcher.h"
+#include "DebugTools.h"
+#include "Stopwatch.h"
+
+void RunImmediateBatcherBenchmark()
+{
+	// A debug overlay of coastline segments in runs of one colour, a few strips and triangles,
+	// recorded one command per call and then through the batcher
+	const int frames = 200;
+	const int line_count = 20000;
+	const int lines_per_color = 500;
+	const int strip_count = 200;
+	const int strip_vertices = 100;
+	const int triangle_count = 2000;
+	const PipelineID pipeline = 0;
+	unsigned colors[4] = { 0xFF0000FF, 0x00FF00FF, 0x0000FFFF, 0xFFFF77FF };
+	std::vector<XMFLOAT2> strip(strip_vertices);
+	for (int i = 0; i < strip_vertices; ++i)
+		strip[i] = XMFLOAT2(static_cast<float>(i), static_cast<float>(i % 7));
+
+	RenderCommandBuffer commands;
+	NullRenderBackend backend;
+	auto draw_per_call = [&](RenderTopology topology, const XMFLOAT2* vertices, uint32_t count, unsigned color)
+	{
+		auto first = commands.AppendTransient(RENDER_TRANSIENT_VERTICES, vertices, count, sizeof(XMFLOAT2));
+		commands.Draw(RenderLayer::Overlay, pipeline, topology, RENDER_TRANSIENT_VERTICES, first, count,
+			commands.AddObject(XMMatrixIdentity(), color));
+	};
+
+	Stopwatch stopwatch;
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		commands.Reset();
+		for (int i = 0; i < line_count; ++i)
+		{
+			XMFLOAT2 line[2] = { XMFLOAT2(static_cast<float>(i), 0.0f), XMFLOAT2(static_cast<float>(i + 1), 1.0f) };
+			draw_per_call(RenderTopology::LineList, line, 2, colors[(i / lines_per_color) % 4]);
+		}
+		for (int i = 0; i < strip_count; ++i)
+			draw_per_call(RenderTopology::LineStrip, strip.data(), strip_vertices, colors[0]);
+		for (int i = 0; i < triangle_count; ++i)
+		{
+			XMFLOAT2 triangle[3] = { XMFLOAT2(0.0f, 0.0f), XMFLOAT2(static_cast<float>(i), 0.0f), XMFLOAT2(0.0f, 1.0f) };
+			draw_per_call(RenderTopology::TriangleList, triangle, 3, colors[i % 2]);
+		}
+		commands.SortAndMerge();
+		backend.Execute(commands);
+	}
+	auto per_call_ms = stopwatch.Lap(L"One command per immediate call") / frames;
+	auto per_call_submitted = static_cast<int>(commands.GetSubmittedCount());
+	auto per_call_draws = backend.GetStats().draw_calls;
+
+	ImmediateBatcher batcher(commands, RenderLayer::Overlay);
+	batcher.SetPipeline(pipeline);
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		commands.Reset();
+		batcher.Reset();
+		for (int i = 0; i < line_count; ++i)
+			batcher.AddLine(XMFLOAT2(static_cast<float>(i), 0.0f), XMFLOAT2(static_cast<float>(i + 1), 1.0f), colors[(i / lines_per_color) % 4]);
+		for (int i = 0; i < strip_count; ++i)
+			batcher.AddLineStrip(strip.data(), strip.size(), colors[0]);
+		for (int i = 0; i < triangle_count; ++i)
+			batcher.AddTriangle(XMFLOAT2(0.0f, 0.0f), XMFLOAT2(static_cast<float>(i), 0.0f), XMFLOAT2(0.0f, 1.0f), colors[i % 2]);
+		batcher.Flush();
+		commands.SortAndMerge();
+		backend.Execute(commands);
+	}
+	auto batched_ms = stopwatch.Lap(L"ImmediateBatcher") / frames;
+
+	auto& stats = batcher.GetStats();
+	PRINTF(L"%u immediate calls: one command per call = %.3f ms/frame (%d commands, %d draws), batched = %.3f ms/frame "
+		L"(%u commands, %d draws, %u vertices)\n", stats.calls, per_call_ms, per_call_submitted, per_call_draws,
+		batched_ms, stats.batches, backend.GetStats().draw_calls, stats.vertices);
+}
@@ -1,8 +1,222 @@
 #include "Noise.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
 
+#if defined(_M_X64) || defined(__x86_64__)
+#define NOISE_AVX2_PATH 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC allows AVX2 intrinsics in any function, the CPU check below guards their use
+#define NOISE_TARGET_AVX2
+#else
+#define NOISE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
 
+namespace
+{
+	inline double Fade(double t)
+	{
+		return t * t * t * (t * (t * 6 - 15) + 10);
+	}
 
-//double Noise(double x, double y)
-//{
-//
-//}
\ No newline at end of file
+	inline double Lerp(double t, double a, double b)
+	{
+		return a + t * (b - a);
+	}
+
+	inline double Grad(int32_t hash, double x, double y)
+	{
+		const int32_t h = hash & 15;
+		const double u = h < 8 ? x : y;
+		const double v = h < 4 ? y : h == 12 || h == 14 ? x : 0.0;
+		return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+	}
+
+#ifdef NOISE_AVX2_PATH
+	bool DetectAvx2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+		const bool has_avx = (info[2] & (1 << 28)) != 0;
+		__cpuidex(info, 7, 0);
+		const bool has_avx2 = (info[1] & (1 << 5)) != 0;
+		return os_saves_ymm && has_avx && has_avx2;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	NOISE_TARGET_AVX2 inline __m256d Fade4(__m256d t)
+	{
+		auto t3 = _mm256_mul_pd(_mm256_mul_pd(t, t), t);
+		auto inner = _mm256_sub_pd(_mm256_mul_pd(t, _mm256_set1_pd(6.0)), _mm256_set1_pd(15.0));
+		inner = _mm256_add_pd(_mm256_mul_pd(t, inner), _mm256_set1_pd(10.0));
+		return _mm256_mul_pd(t3, inner);
+	}
+
+	NOISE_TARGET_AVX2 inline __m256d Lerp4(__m256d t, __m256d a, __m256d b)
+	{
+		return _mm256_add_pd(a, _mm256_mul_pd(t, _mm256_sub_pd(b, a)));
+	}
+
+	NOISE_TARGET_AVX2 inline __m256d Grad4(__m128i hash, __m256d x, __m256d y)
+	{
+		auto h = _mm256_cvtepi32_epi64(_mm_and_si128(hash, _mm_set1_epi32(15)));
+		auto lt8 = _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_set1_epi64x(8), h));
+		auto lt4 = _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_set1_epi64x(4), h));
+		auto is_12_or_14 = _mm256_castsi256_pd(_mm256_or_si256(
+			_mm256_cmpeq_epi64(h, _mm256_set1_epi64x(12)),
+			_mm256_cmpeq_epi64(h, _mm256_set1_epi64x(14))));
+
+		auto u = _mm256_blendv_pd(y, x, lt8);
+		// masking x yields +0.0 where the scalar path uses z = 0.0
+		auto v = _mm256_blendv_pd(_mm256_and_pd(x, is_12_or_14), y, lt4);
+
+		// negation is a flip of the sign bit, selected by bits 0 and 1 of the hash
+		auto u_sign = _mm256_slli_epi64(_mm256_and_si256(h, _mm256_set1_epi64x(1)), 63);
+		auto v_sign = _mm256_slli_epi64(_mm256_and_si256(h, _mm256_set1_epi64x(2)), 62);
+		u = _mm256_xor_pd(u, _mm256_castsi256_pd(u_sign));
+		v = _mm256_xor_pd(v, _mm256_castsi256_pd(v_sign));
+		return _mm256_add_pd(u, v);
+	}
+
+	NOISE_TARGET_AVX2 inline __m256d Noise4(const int32_t* p, __m256d x, __m256d y)
+	{
+		auto fx = _mm256_floor_pd(x);
+		auto fy = _mm256_floor_pd(y);
+		auto mask = _mm_set1_epi32(255);
+		auto one = _mm_set1_epi32(1);
+		auto X = _mm_and_si128(_mm256_cvttpd_epi32(fx), mask);
+		auto Y = _mm_and_si128(_mm256_cvttpd_epi32(fy), mask);
+
+		x = _mm256_sub_pd(x, fx);
+		y = _mm256_sub_pd(y, fy);
+		auto u = Fade4(x);
+		auto v = Fade4(y);
+
+		auto A = _mm_add_epi32(_mm_i32gather_epi32(p, X, 4), Y);
+		auto B = _mm_add_epi32(_mm_i32gather_epi32(p, _mm_add_epi32(X, one), 4), Y);
+		auto AA = _mm_i32gather_epi32(p, A, 4);
+		auto AB = _mm_i32gather_epi32(p, _mm_add_epi32(A, one), 4);
+		auto BA = _mm_i32gather_epi32(p, B, 4);
+		auto BB = _mm_i32gather_epi32(p, _mm_add_epi32(B, one), 4);
+
+		auto x1 = _mm256_sub_pd(x, _mm256_set1_pd(1.0));
+		auto y1 = _mm256_sub_pd(y, _mm256_set1_pd(1.0));
+		auto g_aa = Grad4(_mm_i32gather_epi32(p, AA, 4), x, y);
+		auto g_ba = Grad4(_mm_i32gather_epi32(p, BA, 4), x1, y);
+		auto g_ab = Grad4(_mm_i32gather_epi32(p, AB, 4), x, y1);
+		auto g_bb = Grad4(_mm_i32gather_epi32(p, BB, 4), x1, y1);
+
+		return Lerp4(v, Lerp4(u, g_aa, g_ba), Lerp4(u, g_ab, g_bb));
+	}
+
+	// Returns the number of points processed; the caller finishes the remainder with the scalar path
+	NOISE_TARGET_AVX2 size_t FbmAvx2(const int32_t* p, const double* x, const double* y, double* out, size_t count,
+		const double* amplitudes, size_t octave_count)
+	{
+		double sum_of_amplitudes = 0.0;
+		for (size_t octave = 0; octave < octave_count; octave++)
+			sum_of_amplitudes += amplitudes[octave];
+		auto divisor = _mm256_set1_pd(sum_of_amplitudes);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			auto px = _mm256_loadu_pd(x + i);
+			auto py = _mm256_loadu_pd(y + i);
+			auto sum = _mm256_setzero_pd();
+			for (size_t octave = 0; octave < octave_count; octave++)
+			{
+				auto frequency = _mm256_set1_pd(static_cast<double>(1 << octave));
+				auto n = Noise4(p, _mm256_mul_pd(px, frequency), _mm256_mul_pd(py, frequency));
+				sum = _mm256_add_pd(sum, _mm256_mul_pd(_mm256_set1_pd(amplitudes[octave]), n));
+			}
+			_mm256_storeu_pd(out + i, _mm256_div_pd(sum, divisor));
+		}
+		return i;
+	}
+
+	const bool s_has_avx2 = DetectAvx2();
+#else
+	const bool s_has_avx2 = false;
+#endif
+}
+
+BatchNoise::BatchNoise(uint32_t seed)
+{
+	// Same table as siv::PerlinNoise::reseed
+	for (int32_t i = 0; i < 256; ++i)
+	{
+		_p[i] = i;
+	}
+
+	std::shuffle(std::begin(_p), std::begin(_p) + 256, std::default_random_engine(seed));
+
+	for (size_t i = 0; i < 256; ++i)
+	{
+		_p[256 + i] = _p[i];
+	}
+}
+
+double BatchNoise::Noise(double x, double y) const
+{
+	const int32_t X = static_cast<int32_t>(std::floor(x)) & 255;
+	const int32_t Y = static_cast<int32_t>(std::floor(y)) & 255;
+
+	x -= std::floor(x);
+	y -= std::floor(y);
+
+	const double u = Fade(x);
+	const double v = Fade(y);
+
+	const int32_t A = _p[X] + Y, AA = _p[A], AB = _p[A + 1];
+	const int32_t B = _p[X + 1] + Y, BA = _p[B], BB = _p[B + 1];
+
+	return Lerp(v, Lerp(u, Grad(_p[AA], x, y),
+		Grad(_p[BA], x - 1, y)),
+		Lerp(u, Grad(_p[AB], x, y - 1),
+		Grad(_p[BB], x - 1, y - 1)));
+}
+
+void BatchNoise::FbmScalar(const double* x, const double* y, double* out, size_t count, const double* amplitudes, size_t octave_count) const
+{
+	double sum_of_amplitudes = 0.0;
+	for (size_t octave = 0; octave < octave_count; octave++)
+		sum_of_amplitudes += amplitudes[octave];
+
+	for (size_t i = 0; i < count; i++)
+	{
+		double sum = 0.0;
+		for (size_t octave = 0; octave < octave_count; octave++)
+		{
+			auto frequency = static_cast<double>(1 << octave);
+			sum += amplitudes[octave] * Noise(x[i] * frequency, y[i] * frequency);
+		}
+		out[i] = sum / sum_of_amplitudes;
+	}
+}
+
+void BatchNoise::Fbm(const double* x, const double* y, double* out, size_t count, const double* amplitudes, size_t octave_count) const
+{
+	size_t done = 0;
+#ifdef NOISE_AVX2_PATH
+	if (s_has_avx2)
+		done = FbmAvx2(_p, x, y, out, count, amplitudes, octave_count);
+#endif
+	FbmScalar(x + done, y + done, out + done, count - done, amplitudes, octave_count);
+}
+
+bool BatchNoise::IsVectorPathAvailable()
+{
+	return s_has_avx2;
+}
@@ -1,14 +1,29 @@
 #pragma once
+#include <cstdint>
+#include <cstddef>
 
-//exports.fbm_noise = function(noise, amplitudes, nx, ny) {
-//	let sum = 0, sumOfAmplitudes = 0;
-//	for (let octave = 0; octave < amplitudes.length; octave++) {
-//		let frequency = 1 << octave;
-//		sum += amplitudes[octave] * noise.noise2D(nx * frequency, ny * frequency, octave);
-//		sumOfAmplitudes += amplitudes[octave];
-//	}
-//	return sum / sumOfAmplitudes;
-//};
-
-// returns value in -1 to 1 range
-//double Noise(double x, double y);
\ No newline at end of file
+// 2D Perlin noise evaluated over batches of points stored as separate x and y arrays.
+// The permutation table is built exactly like siv::PerlinNoise, so a given seed produces
+// the same field. When the CPU supports AVX2 four points are evaluated per instruction;
+// otherwise (and for the tail of a batch) the scalar path is used. Both paths give
+// bit-identical results.
+class BatchNoise
+{
+	int32_t _p[512];
+
+public:
+	explicit BatchNoise(uint32_t seed);
+
+	// returns value in -1 to 1 range
+	double Noise(double x, double y) const;
+
+	// Fractal noise: for each point, sum(amplitudes[o] * Noise(x * 2^o, y * 2^o)) / sum(amplitudes)
+	void Fbm(const double* x, const double* y, double* out, size_t count, const double* amplitudes, size_t octave_count) const;
+
+	// Same as Fbm but never uses the vector path. Used as the reference the vector path must match.
+	void FbmScalar(const double* x, const double* y, double* out, size_t count, const double* amplitudes, size_t octave_count) const;
+
+	static bool IsVectorPathAvailable();
+};
+
+void RunNoiseBenchmark();
@@ -0,0 +1,40 @@
+#include "Noise.h"
+#include "DebugTools.h"
+#include "Stopwatch.h"
+#include <random>
+#include <vector>
+
+void RunNoiseBenchmark()
+{
+	const size_t count = 1000000;
+	const double amplitudes[] = { 0.5, 0.25, 0.125, 0.0625 };
+	std::vector<double> x(count), y(count), vector_out(count), scalar_out(count);
+	std::default_random_engine random(1);
+	std::uniform_real_distribution<double> coordinate(-1.0, 1.0);
+	for (size_t i = 0; i < count; i++)
+	{
+		x[i] = coordinate(random);
+		y[i] = coordinate(random);
+	}
+
+	BatchNoise noise(1);
+	Stopwatch stopwatch;
+	noise.FbmScalar(x.data(), y.data(), scalar_out.data(), count, amplitudes, _countof(amplitudes));
+	auto scalar_ms = stopwatch.Lap(L"Fbm scalar, 1M points, 4 octaves");
+	noise.Fbm(x.data(), y.data(), vector_out.data(), count, amplitudes, _countof(amplitudes));
+	auto vector_ms = stopwatch.Lap(L"Fbm, 1M points, 4 octaves");
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (vector_out[i] != scalar_out[i])
+			mismatches++;
+	}
+
+	PRINTF(L"Fbm scalar: %.1f Msamples/s, %s: %.1f Msamples/s, mismatches: %d\n",
+		count / scalar_ms / 1000.0,
+		BatchNoise::IsVectorPathAvailable() ? L"AVX2" : L"scalar",
+		count / vector_ms / 1000.0,
+		static_cast<int>(mismatches));
+	ASSERT(mismatches == 0);
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "StdIncludes.h"
+#include "WorkerPool.h"
+#include <thread>
+#include <atomic>
+
+namespace ParallelForDetail
+{
+	inline std::atomic<int>& WorkerThreadCountSetting()
+	{
+		static std::atomic<int> setting(0);
+		return setting;
+	}
+}
+
+// Number of threads ParallelFor and TaskGraph use when the caller does not say. Defaults to the
+// hardware thread count; benchmarks lower it to measure scaling.
+inline int GetWorkerThreadCount()
+{
+	int setting = ParallelForDetail::WorkerThreadCountSetting().load();
+	return setting > 0 ? setting : max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+// 0 restores the hardware thread count
+inline void SetWorkerThreadCount(int thread_count)
+{
+	ParallelForDetail::WorkerThreadCountSetting().store(max(0, thread_count));
+}
+
+// Splits [begin, end) into one contiguous chunk per worker and calls body(chunk_begin, chunk_end) for each.
+// Chunks after the first go to the WorkerPool; the calling thread processes the first chunk, then helps
+// with queued jobs and returns when every chunk is done.
+// Ranges smaller than min_chunk_size (or a thread_count of 1) run inline on the calling thread.
+template <typename F>
+void ParallelFor(int begin, int end, int min_chunk_size, F body, int thread_count = 0)
+{
+	const int count = end - begin;
+	if (count <= 0)
+		return;
+
+	if (thread_count <= 0)
+		thread_count = GetWorkerThreadCount();
+
+	const int chunk_count = min(thread_count, (count + min_chunk_size - 1) / min_chunk_size);
+	if (chunk_count <= 1)
+	{
+		body(begin, end);
+		return;
+	}
+
+	const int chunk_size = (count + chunk_count - 1) / chunk_count;
+	auto& pool = WorkerPool::GetInstance();
+	std::atomic<int> chunks_left(0);
+	for (int chunk_begin = begin + chunk_size; chunk_begin < end; chunk_begin += chunk_size)
+	{
+		const int chunk_end = min(chunk_begin + chunk_size, end);
+		chunks_left++;
+		pool.Submit([&body, &chunks_left, chunk_begin, chunk_end]
+		{
+			body(chunk_begin, chunk_end);
+			chunks_left--;
+		});
+	}
+
+	body(begin, min(begin + chunk_size, end));
+	pool.HelpUntil([&chunks_left] { return chunks_left.load() == 0; });
+}
@@ -0,0 +1,89 @@
+#include "RangeAllocator.h"
+#include <cassert>
+#include <iterator>
+
+RangeAllocator::RangeAllocator(uint32_t capacity)
+	: _capacity(0)
+	, _used(0)
+	, _next_id(InvalidID + 1)
+	, _compaction_count(0)
+{
+	Grow(capacity);
+}
+
+RangeAllocator::AllocationID RangeAllocator::Allocate(uint32_t count)
+{
+	assert(count > 0);
+	for (auto it = _free_blocks.begin(); it != _free_blocks.end(); ++it)
+	{
+		if (it->second < count)
+			continue;
+
+		Range range = { it->first, count };
+		if (it->second > count)
+			_free_blocks[it->first + count] = it->second - count;
+		_free_blocks.erase(it);
+
+		auto id = _next_id++;
+		_allocations[id] = range;
+		_used += count;
+		return id;
+	}
+	return InvalidID;
+}
+
+void RangeAllocator::Free(AllocationID id)
+{
+	auto found = _allocations.find(id);
+	assert(found != _allocations.end());
+	auto offset = found->second.offset;
+	auto count = found->second.count;
+	_used -= count;
+	_allocations.erase(found);
+
+	// Merge with the free blocks on either side
+	auto next = _free_blocks.lower_bound(offset);
+	if (next != _free_blocks.end() && offset + count == next->first)
+	{
+		count += next->second;
+		next = _free_blocks.erase(next);
+	}
+	if (next != _free_blocks.begin())
+	{
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == offset)
+		{
+			previous->second += count;
+			return;
+		}
+	}
+	_free_blocks[offset] = count;
+}
+
+void RangeAllocator::Grow(uint32_t capacity)
+{
+	if (capacity <= _capacity)
+		return;
+
+	auto added = capacity - _capacity;
+	auto last = _free_blocks.empty() ? _free_blocks.end() : std::prev(_free_blocks.end());
+	if (last != _free_blocks.end() && last->first + last->second == _capacity)
+		last->second += added;
+	else
+		_free_blocks[_capacity] = added;
+	_capacity = capacity;
+}
+
+RangeAllocator::Stats RangeAllocator::GetStats() const
+{
+	Stats stats = {};
+	stats.capacity = _capacity;
+	stats.used = _used;
+	stats.free = _capacity - _used;
+	stats.free_block_count = static_cast<uint32_t>(_free_blocks.size());
+	stats.allocation_count = static_cast<uint32_t>(_allocations.size());
+	stats.compaction_count = _compaction_count;
+	for (auto& block : _free_blocks)
+		stats.largest_free_block = std::max(stats.largest_free_block, block.second);
+	return stats;
+}
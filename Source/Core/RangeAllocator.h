@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+
+// Index that ends a strip in an indexed line or triangle strip draw (primitive restart)
+#define STRIP_CUT_INDEX 0xFFFFFFFFu
+
+/*
+Hands out ranges of a pool of `capacity` elements, such as the vertices of one shared vertex
+buffer. Allocation is first fit over a free list ordered by offset and freed ranges merge with
+free neighbours. Callers hold an AllocationID and look the range up when they draw, so Compact()
+can slide live ranges together without invalidating anything. Knows nothing about what the
+elements are, so it runs without a graphics device. */
+class RangeAllocator
+{
+public:
+	typedef uint32_t AllocationID;
+	static const AllocationID InvalidID = 0;
+
+	struct Range
+	{
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	struct Stats
+	{
+		uint32_t capacity;
+		uint32_t used;
+		uint32_t free;
+		uint32_t largest_free_block;
+		uint32_t free_block_count;
+		uint32_t allocation_count;
+		uint32_t compaction_count;
+		// Share of the free space that is not in the largest free block; 0 when it is all in one piece
+		float GetFragmentation() const { return free == 0 ? 0.0f : 1.0f - static_cast<float>(largest_free_block) / free; }
+	};
+
+private:
+	uint32_t _capacity;
+	uint32_t _used;
+	// offset -> count
+	std::map<uint32_t, uint32_t> _free_blocks;
+	std::unordered_map<AllocationID, Range> _allocations;
+	AllocationID _next_id;
+	uint32_t _compaction_count;
+
+public:
+	explicit RangeAllocator(uint32_t capacity = 0);
+
+	// Returns InvalidID when no free block is large enough; Compact() or Grow() and try again
+	AllocationID Allocate(uint32_t count);
+	void Free(AllocationID id);
+	const Range& GetRange(AllocationID id) const { return _allocations.at(id); }
+	bool Contains(AllocationID id) const { return _allocations.count(id) != 0; }
+
+	// Adds free space at the end of the pool
+	void Grow(uint32_t capacity);
+
+	// Slides every live range towards offset 0, leaving all free space in one block at the end.
+	// move(from, to, count) is called for each range that moves, in increasing offset order and
+	// always with to < from, so moving the elements in the same order with memmove is safe.
+	template<typename Move>
+	void Compact(Move move)
+	{
+		std::vector<std::pair<uint32_t, AllocationID>> by_offset;
+		by_offset.reserve(_allocations.size());
+		for (auto& allocation : _allocations)
+			by_offset.emplace_back(allocation.second.offset, allocation.first);
+		std::sort(by_offset.begin(), by_offset.end());
+
+		uint32_t cursor = 0;
+		for (auto& entry : by_offset)
+		{
+			auto& range = _allocations[entry.second];
+			if (range.offset != cursor)
+			{
+				move(range.offset, cursor, range.count);
+				range.offset = cursor;
+			}
+			cursor += range.count;
+		}
+
+		_free_blocks.clear();
+		if (cursor < _capacity)
+			_free_blocks[cursor] = _capacity - cursor;
+		_compaction_count++;
+	}
+
+	Stats GetStats() const;
+	uint32_t GetCapacity() const { return _capacity; }
+};
+
+// Appends the indices of one strip of `count` elements starting at `first`, followed by a cut,
+// so any number of strips can be drawn from one index buffer with one call
+inline void AppendStripIndices(std::vector<uint32_t>& indices, uint32_t first, uint32_t count)
+{
+	auto size = indices.size();
+	indices.resize(size + count + 1);
+	auto* out = &indices[size];
+	for (uint32_t i = 0; i < count; i++)
+		out[i] = first + i;
+	out[count] = STRIP_CUT_INDEX;
+}
+
+void RunRangeAllocatorBenchmark();
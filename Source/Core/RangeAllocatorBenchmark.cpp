@@ -0,0 +1,84 @@
+#include "RangeAllocator.h"
+#include "StdIncludes.h"
+#include "DebugTools.h"
+#include "Stopwatch.h"
+#include <random>
+
+void RunRangeAllocatorBenchmark()
+{
+	// Line features of 2 to 500 vertices loading and unloading as the view moves, in a pool of
+	// XMFLOAT2 vertices that compacts before it grows, as VertexPool does
+	const int resident_features = 2000;
+	const int frames = 1000;
+	const int changes_per_frame = 20;
+	std::mt19937 random(1);
+	std::uniform_int_distribution<uint32_t> vertex_count(2, 500);
+
+	RangeAllocator allocator(65536);
+	std::vector<XMFLOAT2> vertices(allocator.GetCapacity());
+	std::vector<RangeAllocator::AllocationID> live;
+	uint32_t grow_count = 0;
+	auto add = [&](uint32_t count)
+	{
+		auto id = allocator.Allocate(count);
+		if (id == RangeAllocator::InvalidID)
+		{
+			auto stats = allocator.GetStats();
+			if (stats.free >= count)
+			{
+				allocator.Compact([&](uint32_t from, uint32_t to, uint32_t n)
+				{
+					memmove(&vertices[to], &vertices[from], n * sizeof(XMFLOAT2));
+				});
+			}
+			else
+			{
+				allocator.Grow(max(stats.capacity * 2, stats.capacity + count));
+				vertices.resize(allocator.GetCapacity());
+				grow_count++;
+			}
+			id = allocator.Allocate(count);
+		}
+		ASSERT(id != RangeAllocator::InvalidID);
+		live.push_back(id);
+	};
+
+	for (int i = 0; i < resident_features; i++)
+		add(vertex_count(random));
+
+	double churn_ms = 0.0;
+	double index_ms = 0.0;
+	float fragmentation_sum = 0.0f;
+	std::vector<uint32_t> indices;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		Stopwatch stopwatch;
+		for (int change = 0; change < changes_per_frame; change++)
+		{
+			auto victim = random() % live.size();
+			allocator.Free(live[victim]);
+			live[victim] = live.back();
+			live.pop_back();
+			add(vertex_count(random));
+		}
+		auto churned_ms = stopwatch.GetElapsedMilliseconds();
+
+		// One merged strip list replaces a draw call per feature
+		indices.clear();
+		for (auto id : live)
+		{
+			auto& range = allocator.GetRange(id);
+			AppendStripIndices(indices, range.offset, range.count);
+		}
+		index_ms += stopwatch.GetElapsedMilliseconds() - churned_ms;
+		churn_ms += churned_ms;
+		fragmentation_sum += allocator.GetStats().GetFragmentation();
+	}
+
+	auto stats = allocator.GetStats();
+	PRINTF(L"%d features, %d changes per frame: allocation = %.4f ms/frame, strip indices = %.3f ms/frame, capacity = %u vertices, "
+		L"used = %u (%.1f%% overhead), free blocks = %u, mean fragmentation = %.3f, compactions = %u, grows = %u, draw calls = 1 instead of %d\n",
+		resident_features, changes_per_frame, churn_ms / frames, index_ms / frames, stats.capacity, stats.used,
+		100.0 * (stats.capacity - stats.used) / stats.used, stats.free_block_count, fragmentation_sum / frames,
+		stats.compaction_count, grow_count, static_cast<int>(live.size()));
+}
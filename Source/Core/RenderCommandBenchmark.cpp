@@ -0,0 +1,164 @@
+#include "RenderCommandBuffer.h"
+#include "StdIncludes.h"
+#include "DebugTools.h"
+#include "Stopwatch.h"
+
+void RunRenderCommandBenchmark()
+{
+	// A busy frame at high zoom: tile borders, dynamic features in a few colours, one instanced
+	// draw of static features and a debug overlay of line segments
+	const int frames = 200;
+	const int tile_count = 400;
+	const int dynamic_colors = 8;
+	const uint32_t strip_indices_per_color = 20000;
+	const uint32_t static_feature_count = 20000;
+	const int overlay_lines = 20000;
+	const int overlay_lines_per_color = 500;
+	const PipelineID square_pipeline = 0;
+	const PipelineID static_feature_pipeline = 1;
+	const BufferID square_buffer = RENDER_TRANSIENT_BUFFER_COUNT;
+	const BufferID pool_buffer = RENDER_TRANSIENT_BUFFER_COUNT + 1;
+	const BufferID cube_vertices = RENDER_TRANSIENT_BUFFER_COUNT + 2;
+	const BufferID cube_indices = RENDER_TRANSIENT_BUFFER_COUNT + 3;
+
+	std::vector<uint32_t> strip_indices(strip_indices_per_color);
+	for (uint32_t i = 0; i < strip_indices_per_color; ++i)
+		strip_indices[i] = i % 64 == 63 ? 0xFFFFFFFFu : i;
+	std::vector<uint8_t> instances(static_feature_count * 32);
+	unsigned colors[4] = { 0xFF0000FF, 0x00FF00FF, 0x0000FFFF, 0xFFFF77FF };
+
+	RenderCommandBuffer commands;
+	NullRenderBackend backend;
+	auto record = [&]()
+	{
+		commands.Reset();
+		for (int i = 0; i < tile_count; ++i)
+		{
+			auto world = XMMatrixScaling(256.0f, 0.0f, 256.0f) * XMMatrixTranslation(256.0f * (i % 20), 1.0f, 256.0f * (i / 20));
+			commands.Draw(RenderLayer::TileBorders, square_pipeline, RenderTopology::LineStrip, square_buffer, 0, 5,
+				commands.AddObject(world, 0xFFFF77FF));
+		}
+		for (int c = 0; c < dynamic_colors; ++c)
+		{
+			auto first = commands.AppendTransient(RENDER_TRANSIENT_INDICES, strip_indices.data(), strip_indices_per_color, sizeof(uint32_t));
+			commands.DrawIndexed(RenderLayer::DynamicFeatures, square_pipeline, RenderTopology::LineStrip, pool_buffer,
+				RENDER_TRANSIENT_INDICES, first, strip_indices_per_color, commands.AddObject(XMMatrixIdentity(), colors[c % 4]));
+		}
+		auto first_instance = commands.AppendTransient(RENDER_TRANSIENT_INSTANCES, instances.data(), static_feature_count, 32);
+		commands.DrawIndexedInstanced(RenderLayer::StaticFeatures, static_feature_pipeline, RenderTopology::TriangleList,
+			cube_vertices, cube_indices, 36, RENDER_TRANSIENT_INSTANCES, first_instance, static_feature_count, RENDER_NO_OBJECT);
+		for (int i = 0; i < overlay_lines; ++i)
+		{
+			XMFLOAT2 line[2] = { XMFLOAT2(static_cast<float>(i), 0.0f), XMFLOAT2(static_cast<float>(i + 1), 1.0f) };
+			auto first = commands.AppendTransient(RENDER_TRANSIENT_VERTICES, line, 2, sizeof(XMFLOAT2));
+			commands.Draw(RenderLayer::Overlay, square_pipeline, RenderTopology::LineList, RENDER_TRANSIENT_VERTICES, first, 2,
+				commands.AddObject(XMMatrixIdentity(), colors[(i / overlay_lines_per_color) % 4]));
+		}
+	};
+
+	// The same frame executed in submission order, to show what sorting saves in state changes
+	record();
+	backend.Execute(commands);
+	auto unsorted = backend.GetStats();
+
+	double record_ms = 0.0;
+	double sort_ms = 0.0;
+	double execute_ms = 0.0;
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		Stopwatch stopwatch;
+		record();
+		auto recorded_ms = stopwatch.GetElapsedMilliseconds();
+		commands.SortAndMerge();
+		auto sorted_ms = stopwatch.GetElapsedMilliseconds();
+		backend.Execute(commands);
+		execute_ms += stopwatch.GetElapsedMilliseconds() - sorted_ms;
+		sort_ms += sorted_ms - recorded_ms;
+		record_ms += recorded_ms;
+	}
+
+	auto& stats = backend.GetStats();
+	PRINTF(L"Render commands: record = %.3f ms/frame, sort and merge = %.3f ms/frame, null execute = %.3f ms/frame, "
+		L"%d submitted, %d draw calls, %d pipeline changes, %d object uploads, %llu elements, %d transient bytes\n",
+		record_ms / frames, sort_ms / frames, execute_ms / frames, static_cast<int>(commands.GetSubmittedCount()),
+		stats.draw_calls, stats.pipeline_changes, stats.object_uploads, static_cast<unsigned long long>(stats.elements),
+		static_cast<int>(stats.transient_bytes));
+	PRINTF(L"State binds: submission order = %d made, %d redundant skipped; sorted and merged = %d made, %d redundant skipped\n",
+		unsorted.state_binds, unsorted.redundant_binds, stats.state_binds, stats.redundant_binds);
+}
+
+void RunObjectUploadBenchmark()
+{
+	// Tile borders with a world matrix each and overlay lines sharing one object per colour run.
+	// The old path mapped a constant buffer with WRITE_DISCARD whenever the object changed; a
+	// discard hands out fresh memory, which is modelled as a ring of 256 byte slots. The new path
+	// copies the packed objects once.
+	const int frames = 200;
+	const int tile_count = 2000;
+	const int line_count = 20000;
+	const int lines_per_color = 100;
+	const PipelineID square_pipeline = 0;
+	const BufferID square_buffer = RENDER_TRANSIENT_BUFFER_COUNT;
+	const size_t constant_buffer_slot = 256;
+	unsigned colors[4] = { 0xFF0000FF, 0x00FF00FF, 0x0000FFFF, 0xFFFF77FF };
+
+	RenderCommandBuffer commands;
+	std::vector<uint8_t> per_draw_memory(constant_buffer_slot * 4096);
+	std::vector<uint8_t> per_frame_memory;
+	double pack_ms = 0.0;
+	double per_draw_ms = 0.0;
+	double per_frame_ms = 0.0;
+	int per_draw_maps = 0;
+	size_t ring_offset = 0;
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		Stopwatch stopwatch;
+		commands.Reset();
+		for (int i = 0; i < tile_count; ++i)
+		{
+			auto world = XMMatrixScaling(256.0f, 0.0f, 256.0f) * XMMatrixTranslation(256.0f * (i % 50), 1.0f, 256.0f * (i / 50));
+			commands.Draw(RenderLayer::TileBorders, square_pipeline, RenderTopology::LineStrip, square_buffer, 0, 5,
+				commands.AddObject(world, 0xFFFF77FF));
+		}
+		for (int i = 0; i < line_count; ++i)
+		{
+			commands.Draw(RenderLayer::Overlay, square_pipeline, RenderTopology::LineList, RENDER_TRANSIENT_VERTICES, i * 2, 2,
+				commands.AddObject(XMMatrixIdentity(), colors[(i / lines_per_color) % 4]));
+		}
+		commands.SortAndMerge();
+		auto packed_ms = stopwatch.GetElapsedMilliseconds();
+
+		per_draw_maps = 0;
+		auto& objects = commands.GetObjects();
+		auto object = RENDER_NO_OBJECT;
+		for (auto& command : commands.GetCommands())
+		{
+			if (command.object == RENDER_NO_OBJECT)
+				continue;
+			// Without an object buffer a run of objects is one draw per object again
+			for (uint32_t i = 0; i < max(command.instance_count, 1u); ++i)
+			{
+				if (command.object + i == object)
+					continue;
+				object = command.object + i;
+				if (ring_offset + constant_buffer_slot > per_draw_memory.size())
+					ring_offset = 0;
+				memcpy(&per_draw_memory[ring_offset], &objects[object], sizeof(RenderObject));
+				ring_offset += constant_buffer_slot;
+				per_draw_maps++;
+			}
+		}
+		auto per_draw_done_ms = stopwatch.GetElapsedMilliseconds();
+
+		per_frame_memory.resize(objects.size() * sizeof(RenderObject));
+		memcpy(per_frame_memory.data(), objects.data(), per_frame_memory.size());
+		per_frame_ms += stopwatch.GetElapsedMilliseconds() - per_draw_done_ms;
+		per_draw_ms += per_draw_done_ms - packed_ms;
+		pack_ms += packed_ms;
+	}
+
+	PRINTF(L"Object upload: %d objects, %d draws after merging, record and pack = %.3f ms/frame, map per draw = %.3f ms/frame (%d maps), "
+		L"one buffer per frame = %.3f ms/frame (1 map, %d bytes)\n", static_cast<int>(commands.GetObjects().size()),
+		static_cast<int>(commands.GetCommands().size()), pack_ms / frames, per_draw_ms / frames, per_draw_maps,
+		per_frame_ms / frames, static_cast<int>(per_frame_memory.size()));
+}
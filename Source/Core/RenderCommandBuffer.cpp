@@ -0,0 +1,203 @@
+#include "RenderCommandBuffer.h"
+#include "ColorConverter.h"
+#include "RenderStateCache.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace DirectX;
+
+static_assert(sizeof(RenderCommand) == 40, "RenderCommand is sorted and copied by value and should stay small");
+
+RenderCommandBuffer::RenderCommandBuffer()
+	: _submitted_count(0)
+{
+	for (int i = 0; i < RENDER_TRANSIENT_BUFFER_COUNT; ++i)
+		_transient_strides[i] = 0;
+}
+
+void RenderCommandBuffer::Reset()
+{
+	_commands.clear();
+	_objects.clear();
+	for (int i = 0; i < RENDER_TRANSIENT_BUFFER_COUNT; ++i)
+	{
+		_transient[i].clear();
+		_transient_strides[i] = 0;
+	}
+	_submitted_count = 0;
+}
+
+uint32_t RenderCommandBuffer::AddObject(const RenderObject& object)
+{
+	if (!_objects.empty() && memcmp(&_objects.back(), &object, sizeof(RenderObject)) == 0)
+		return static_cast<uint32_t>(_objects.size() - 1);
+	_objects.push_back(object);
+	return static_cast<uint32_t>(_objects.size() - 1);
+}
+
+uint32_t RenderCommandBuffer::AddObject(const XMMATRIX& world_matrix, unsigned color)
+{
+	RenderObject object {};
+	XMStoreFloat4x4(&object.world_matrix, XMMatrixTranspose(world_matrix));
+	object.color = ConvertColor(color);
+	return AddObject(object);
+}
+
+uint32_t RenderCommandBuffer::AppendTransient(BufferID buffer, const void* data, uint32_t count, uint32_t stride)
+{
+	assert(buffer < RENDER_TRANSIENT_BUFFER_COUNT);
+	assert(_transient_strides[buffer] == 0 || _transient_strides[buffer] == stride);
+	_transient_strides[buffer] = stride;
+	auto& bytes = _transient[buffer];
+	auto first = static_cast<uint32_t>(bytes.size() / stride);
+	auto data_bytes = static_cast<const uint8_t*>(data);
+	bytes.insert(bytes.end(), data_bytes, data_bytes + static_cast<size_t>(count) * stride);
+	return first;
+}
+
+void RenderCommandBuffer::_Submit(RenderLayer layer, const RenderCommand& command)
+{
+	assert(_submitted_count <= RENDER_SORT_SEQUENCE_MASK);
+	_commands.push_back(command);
+	_commands.back().sort_key = MakeRenderSortKey(layer, command.pipeline, command.vertex_buffer, static_cast<uint32_t>(_submitted_count));
+	_submitted_count++;
+}
+
+void RenderCommandBuffer::Draw(RenderLayer layer, PipelineID pipeline, RenderTopology topology, BufferID vertex_buffer,
+	uint32_t first_vertex, uint32_t vertex_count, uint32_t object)
+{
+	RenderCommand command {};
+	command.pipeline = pipeline;
+	command.topology = topology;
+	command.vertex_buffer = vertex_buffer;
+	command.index_buffer = RENDER_NO_BUFFER;
+	command.instance_buffer = RENDER_NO_BUFFER;
+	command.first = first_vertex;
+	command.count = vertex_count;
+	command.object = object;
+	_Submit(layer, command);
+}
+
+void RenderCommandBuffer::DrawIndexed(RenderLayer layer, PipelineID pipeline, RenderTopology topology, BufferID vertex_buffer,
+	BufferID index_buffer, uint32_t first_index, uint32_t index_count, uint32_t object)
+{
+	RenderCommand command {};
+	command.pipeline = pipeline;
+	command.topology = topology;
+	command.vertex_buffer = vertex_buffer;
+	command.index_buffer = index_buffer;
+	command.instance_buffer = RENDER_NO_BUFFER;
+	command.first = first_index;
+	command.count = index_count;
+	command.object = object;
+	_Submit(layer, command);
+}
+
+void RenderCommandBuffer::DrawIndexedInstanced(RenderLayer layer, PipelineID pipeline, RenderTopology topology, BufferID vertex_buffer,
+	BufferID index_buffer, uint32_t index_count, BufferID instance_buffer, uint32_t first_instance,
+	uint32_t instance_count, uint32_t object)
+{
+	RenderCommand command {};
+	command.pipeline = pipeline;
+	command.topology = topology;
+	command.vertex_buffer = vertex_buffer;
+	command.index_buffer = index_buffer;
+	command.instance_buffer = instance_buffer;
+	command.first = 0;
+	command.count = index_count;
+	command.first_instance = first_instance;
+	command.instance_count = instance_count;
+	command.object = object;
+	_Submit(layer, command);
+}
+
+bool RenderCommandBuffer::_CanMerge(const RenderCommand& a, const RenderCommand& b)
+{
+	if (a.pipeline != b.pipeline || a.topology != b.topology ||
+		a.vertex_buffer != b.vertex_buffer || a.index_buffer != b.index_buffer || a.instance_buffer != b.instance_buffer)
+		return false;
+	if (a.object != b.object)
+	{
+		// The same range drawn with consecutive objects becomes one draw instanced over them
+		return a.object != RENDER_NO_OBJECT && b.object != RENDER_NO_OBJECT && a.instance_buffer == RENDER_NO_BUFFER &&
+			a.first == b.first && a.count == b.count && b.instance_count == 0 && a.object + std::max(a.instance_count, 1u) == b.object;
+	}
+	if (a.instance_buffer != RENDER_NO_BUFFER)
+		return a.first == b.first && a.count == b.count && a.first_instance + a.instance_count == b.first_instance;
+	// A run of objects draws one range for each, so the range cannot grow
+	if (a.instance_count > 1)
+		return false;
+	// Strips would be joined into one strip, and a cut index cannot be inserted into a range
+	if (a.topology == RenderTopology::LineStrip)
+		return false;
+	return a.first + a.count == b.first;
+}
+
+void RenderCommandBuffer::SortAndMerge()
+{
+	// Keys end in the submission order, so they are unique and the order is deterministic
+	std::sort(_commands.begin(), _commands.end(), [](const RenderCommand& a, const RenderCommand& b)
+	{
+		return a.sort_key < b.sort_key;
+	});
+
+	size_t merged = 0;
+	for (size_t i = 0; i < _commands.size(); ++i)
+	{
+		if (merged > 0 && _CanMerge(_commands[merged - 1], _commands[i]))
+		{
+			auto& last = _commands[merged - 1];
+			if (last.instance_buffer != RENDER_NO_BUFFER)
+				last.instance_count += _commands[i].instance_count;
+			else if (last.object != _commands[i].object)
+				last.instance_count = std::max(last.instance_count, 1u) + 1;
+			else
+				last.count += _commands[i].count;
+			continue;
+		}
+		_commands[merged++] = _commands[i];
+	}
+	_commands.resize(merged);
+}
+
+NullRenderBackend::NullRenderBackend()
+	: _stats{}
+{
+}
+
+void NullRenderBackend::Execute(const RenderCommandBuffer& commands)
+{
+	_stats = RenderFrameStats{};
+	for (int i = 0; i < RENDER_TRANSIENT_BUFFER_COUNT; ++i)
+		_stats.transient_bytes += commands.GetTransientByteSize(static_cast<BufferID>(i));
+
+	_stats.object_uploads = commands.GetObjects().empty() ? 0 : 1;
+
+	// Stand-ins for the device objects of a pipeline and for the object index stream
+	const BufferID object_indices = RENDER_NO_BUFFER - 1;
+	auto pipeline_handle = [](PipelineID pipeline) { return reinterpret_cast<const void*>(static_cast<uintptr_t>(pipeline) + 1); };
+
+	RenderStateCache state;
+	auto pipeline = static_cast<uint32_t>(-1);
+	for (auto& command : commands.GetCommands())
+	{
+		if (command.pipeline != pipeline)
+		{
+			pipeline = command.pipeline;
+			_stats.pipeline_changes++;
+		}
+		state.SetInputLayout(pipeline_handle(command.pipeline));
+		state.SetTopology(command.topology);
+		state.SetVertexShader(pipeline_handle(command.pipeline));
+		state.SetPixelShader(pipeline_handle(command.pipeline));
+		// A draw's object is selected by its first instance through a stream of object indices
+		state.SetVertexBuffers(command.vertex_buffer, command.object != RENDER_NO_OBJECT ? object_indices : command.instance_buffer);
+		if (command.index_buffer != RENDER_NO_BUFFER)
+			state.SetIndexBuffer(command.index_buffer);
+		_stats.draw_calls++;
+		_stats.elements += static_cast<uint64_t>(command.count) * std::max(command.instance_count, 1u);
+	}
+	_stats.state_binds = state.GetBindCount();
+	_stats.redundant_binds = state.GetRedundantBindCount();
+}
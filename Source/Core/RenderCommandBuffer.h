@@ -0,0 +1,165 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+// Pipelines and buffers are referred to by small IDs that a backend maps to its own objects
+typedef uint16_t PipelineID;
+typedef uint16_t BufferID;
+
+#define RENDER_NO_BUFFER 0xFFFF
+#define RENDER_NO_OBJECT 0xFFFFFFFFu
+
+// Buffers below RENDER_TRANSIENT_BUFFER_COUNT are filled while a frame is recorded and uploaded
+// by the backend before its commands run. Every other BufferID is registered with the backend.
+#define RENDER_TRANSIENT_VERTICES 0
+#define RENDER_TRANSIENT_INDICES 1
+#define RENDER_TRANSIENT_INSTANCES 2
+#define RENDER_TRANSIENT_BUFFER_COUNT 3
+
+// Sort key layout, most significant first: layer, pipeline, vertex buffer, submission order
+#define RENDER_SORT_LAYER_SHIFT 56
+#define RENDER_SORT_PIPELINE_SHIFT 40
+#define RENDER_SORT_BUFFER_SHIFT 24
+#define RENDER_SORT_SEQUENCE_MASK 0xFFFFFFull
+
+enum class RenderTopology : uint8_t
+{
+	PointList,
+	LineList,
+	LineStrip,
+	TriangleList
+};
+
+// Layers are drawn in this order whatever was recorded first. Inside a layer, submission order
+// is only kept between draws that share a pipeline and a vertex buffer.
+enum class RenderLayer : uint8_t
+{
+	Background,
+	TileBorders,
+	DynamicFeatures,
+	StaticFeatures,
+	Overlay
+};
+
+// Per object constants, laid out as an element of the object buffer the map shaders read
+struct alignas(16) RenderObject
+{
+	DirectX::XMFLOAT4X4 world_matrix;
+	DirectX::XMFLOAT4 color;
+};
+
+struct RenderCommand
+{
+	uint64_t sort_key;
+	PipelineID pipeline;
+	RenderTopology topology;
+	uint8_t reserved;
+	BufferID vertex_buffer;
+	// RENDER_NO_BUFFER when the draw is not indexed
+	BufferID index_buffer;
+	// RENDER_NO_BUFFER when the draw is not instanced
+	BufferID instance_buffer;
+	uint16_t reserved2;
+	// First vertex, or first index when the draw is indexed
+	uint32_t first;
+	uint32_t count;
+	uint32_t first_instance;
+	// Also set on draws with an object that were merged: the range is drawn once for each of
+	// instance_count objects starting at object
+	uint32_t instance_count;
+	// Index into GetObjects(), or RENDER_NO_OBJECT
+	uint32_t object;
+};
+
+inline uint64_t MakeRenderSortKey(RenderLayer layer, PipelineID pipeline, BufferID vertex_buffer, uint32_t sequence)
+{
+	return static_cast<uint64_t>(layer) << RENDER_SORT_LAYER_SHIFT |
+		static_cast<uint64_t>(pipeline) << RENDER_SORT_PIPELINE_SHIFT |
+		static_cast<uint64_t>(vertex_buffer) << RENDER_SORT_BUFFER_SHIFT |
+		(sequence & RENDER_SORT_SEQUENCE_MASK);
+}
+
+/*
+One frame of draws recorded as plain data instead of device calls. The renderer records into
+it, SortAndMerge() orders the commands by key and joins neighbours that draw adjacent ranges
+with the same state, or the same range with consecutive objects, and a RenderBackend executes
+the result. Nothing here touches a device, so building a frame can be profiled without a GPU.
+All storage keeps its capacity across Reset() so a steady frame does not allocate. */
+class RenderCommandBuffer
+{
+	std::vector<RenderCommand> _commands;
+	std::vector<RenderObject> _objects;
+	std::vector<uint8_t> _transient[RENDER_TRANSIENT_BUFFER_COUNT];
+	uint32_t _transient_strides[RENDER_TRANSIENT_BUFFER_COUNT];
+	size_t _submitted_count;
+
+	void _Submit(RenderLayer layer, const RenderCommand& command);
+	static bool _CanMerge(const RenderCommand& a, const RenderCommand& b);
+
+public:
+	RenderCommandBuffer();
+
+	void Reset();
+
+	// Objects equal to the last one added share its index, so draws of one colour can merge
+	uint32_t AddObject(const RenderObject& object);
+	uint32_t AddObject(const DirectX::XMMATRIX& world_matrix, unsigned color);
+
+	// Appends elements to a transient buffer and returns the index of the first one. A buffer
+	// keeps the stride it was first given until Reset().
+	uint32_t AppendTransient(BufferID buffer, const void* data, uint32_t count, uint32_t stride);
+
+	void Draw(RenderLayer layer, PipelineID pipeline, RenderTopology topology, BufferID vertex_buffer,
+		uint32_t first_vertex, uint32_t vertex_count, uint32_t object);
+	void DrawIndexed(RenderLayer layer, PipelineID pipeline, RenderTopology topology, BufferID vertex_buffer,
+		BufferID index_buffer, uint32_t first_index, uint32_t index_count, uint32_t object);
+	void DrawIndexedInstanced(RenderLayer layer, PipelineID pipeline, RenderTopology topology, BufferID vertex_buffer,
+		BufferID index_buffer, uint32_t index_count, BufferID instance_buffer, uint32_t first_instance,
+		uint32_t instance_count, uint32_t object);
+
+	void SortAndMerge();
+
+	const std::vector<RenderCommand>& GetCommands() const { return _commands; }
+	const std::vector<RenderObject>& GetObjects() const { return _objects; }
+	const uint8_t* GetTransientData(BufferID buffer) const { return _transient[buffer].data(); }
+	size_t GetTransientByteSize(BufferID buffer) const { return _transient[buffer].size(); }
+	uint32_t GetTransientStride(BufferID buffer) const { return _transient_strides[buffer]; }
+	// Commands recorded since Reset(), before merging
+	size_t GetSubmittedCount() const { return _submitted_count; }
+};
+
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend() {}
+	virtual void Execute(const RenderCommandBuffer& commands) = 0;
+};
+
+struct RenderFrameStats
+{
+	int draw_calls;
+	int pipeline_changes;
+	// Maps of per object data. The objects of a frame are written with one.
+	int object_uploads;
+	uint64_t elements;
+	size_t transient_bytes;
+	// Device state calls made, and the ones skipped because the state was already bound
+	int state_binds;
+	int redundant_binds;
+};
+
+// Walks the commands the way a device backend would without binding anything, and counts what
+// the frame would have cost. Every pipeline counts as its own input layout and shaders.
+class NullRenderBackend : public RenderBackend
+{
+	RenderFrameStats _stats;
+
+public:
+	NullRenderBackend();
+	virtual void Execute(const RenderCommandBuffer& commands) override;
+	const RenderFrameStats& GetStats() const { return _stats; }
+};
+
+void RunRenderCommandBenchmark();
+void RunObjectUploadBenchmark();
@@ -0,0 +1,85 @@
+#include "RenderStateCache.h"
+
+RenderStateCache::RenderStateCache()
+{
+	Reset();
+}
+
+void RenderStateCache::Reset()
+{
+	Invalidate();
+	_binds = 0;
+	_redundant_binds = 0;
+}
+
+void RenderStateCache::Invalidate()
+{
+	_input_layout = nullptr;
+	_vertex_shader = nullptr;
+	_pixel_shader = nullptr;
+	_topology = RenderTopology::PointList;
+	_has_topology = false;
+	_vertex_buffer = RENDER_NO_BUFFER;
+	_instance_buffer = RENDER_NO_BUFFER;
+	_index_buffer = RENDER_NO_BUFFER;
+}
+
+bool RenderStateCache::_Bind(bool changed)
+{
+	if (changed)
+		_binds++;
+	else
+		_redundant_binds++;
+	return changed;
+}
+
+bool RenderStateCache::SetInputLayout(const void* input_layout)
+{
+	if (!_Bind(input_layout != _input_layout))
+		return false;
+	_input_layout = input_layout;
+	return true;
+}
+
+bool RenderStateCache::SetVertexShader(const void* vertex_shader)
+{
+	if (!_Bind(vertex_shader != _vertex_shader))
+		return false;
+	_vertex_shader = vertex_shader;
+	return true;
+}
+
+bool RenderStateCache::SetPixelShader(const void* pixel_shader)
+{
+	if (!_Bind(pixel_shader != _pixel_shader))
+		return false;
+	_pixel_shader = pixel_shader;
+	return true;
+}
+
+bool RenderStateCache::SetTopology(RenderTopology topology)
+{
+	if (!_Bind(!_has_topology || topology != _topology))
+		return false;
+	_topology = topology;
+	_has_topology = true;
+	return true;
+}
+
+bool RenderStateCache::SetVertexBuffers(BufferID vertex_buffer, BufferID instance_buffer)
+{
+	if (!_Bind(vertex_buffer != _vertex_buffer || instance_buffer != _instance_buffer))
+		return false;
+	_vertex_buffer = vertex_buffer;
+	_instance_buffer = instance_buffer;
+	return true;
+}
+
+bool RenderStateCache::SetIndexBuffer(BufferID index_buffer)
+{
+	if (!_Bind(index_buffer != _index_buffer))
+		return false;
+	_index_buffer = index_buffer;
+	return true;
+}
+
@@ -0,0 +1,47 @@
+#pragma once
+#include "RenderCommandBuffer.h"
+
+/*
+What a backend last bound to the input assembler and the shader stages. Each Set function
+returns whether the value differs from what is bound, and only then should the backend make the
+device call; binds that would change nothing are counted as redundant instead. Shaders and input
+layouts are compared by address so pipelines that share one do not rebind it. Vertex buffers are
+compared by BufferID, which is enough inside one frame because a transient buffer keeps its
+offset until the next upload. Reset() at the start of every frame, since other renderers bind
+their own state in between. Invalidate() when the bound state is lost in the middle of a frame,
+such as after a device reset, so everything is bound again without losing the counts. */
+class RenderStateCache
+{
+	const void* _input_layout;
+	const void* _vertex_shader;
+	const void* _pixel_shader;
+	RenderTopology _topology;
+	bool _has_topology;
+	BufferID _vertex_buffer;
+	BufferID _instance_buffer;
+	BufferID _index_buffer;
+	int _binds;
+	int _redundant_binds;
+
+	bool _Bind(bool changed);
+
+public:
+	RenderStateCache();
+
+	// Forgets what is bound and zeroes the counts
+	void Reset();
+	// Forgets what is bound, so the next Set of each state binds it
+	void Invalidate();
+
+	bool SetInputLayout(const void* input_layout);
+	bool SetVertexShader(const void* vertex_shader);
+	bool SetPixelShader(const void* pixel_shader);
+	bool SetTopology(RenderTopology topology);
+	// Both streams are bound with one call, so they are cached together
+	bool SetVertexBuffers(BufferID vertex_buffer, BufferID instance_buffer);
+	bool SetIndexBuffer(BufferID index_buffer);
+
+	// Since the last Reset()
+	int GetBindCount() const { return _binds; }
+	int GetRedundantBindCount() const { return _redundant_binds; }
+};
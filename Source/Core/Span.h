@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+
+// Non-owning view over a contiguous run of elements.
+// Used to hand out slices of flat arrays without copying them into a new vector.
+template <typename T>
+struct Span
+{
+	T* data;
+	size_t count;
+
+	Span() : data(nullptr), count(0) {}
+	Span(T* data, size_t count) : data(data), count(count) {}
+
+	T* begin() const { return data; }
+	T* end() const { return data + count; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	T& operator[](size_t i) const { return data[i]; }
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include "DebugTools.h"
+#include <chrono>
+
+// Wall clock timer for instrumenting long running work such as world generation.
+// Lap() prints the time spent since the previous lap and returns it in milliseconds.
+class Stopwatch
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	Clock::time_point _start;
+	Clock::time_point _lap;
+
+	static double _Milliseconds(Clock::time_point from, Clock::time_point to)
+	{
+		return std::chrono::duration<double, std::milli>(to - from).count();
+	}
+
+public:
+	Stopwatch()
+		: _start(Clock::now())
+		, _lap(_start)
+	{
+	}
+
+	double GetElapsedMilliseconds() const
+	{
+		return _Milliseconds(_start, Clock::now());
+	}
+
+	double Lap(const wchar_t* label)
+	{
+		auto now = Clock::now();
+		auto elapsed = _Milliseconds(_lap, now);
+		_lap = now;
+		PRINTF(L"[TIMING] %s: %.3f ms\n", label, elapsed);
+		return elapsed;
+	}
+};
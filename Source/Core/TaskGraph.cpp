@@ -0,0 +1,95 @@
+#include "TaskGraph.h"
+#include "DebugTools.h"
+#include "ParallelFor.h"
+#include "Stopwatch.h"
+#include "WorkerPool.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+TaskGraph::TaskGraph()
+	: _total_milliseconds(0.0)
+{
+}
+
+TaskGraph::StageID TaskGraph::AddStage(const wchar_t* name, std::function<void()> work, std::initializer_list<StageID> dependencies)
+{
+	const StageID id = static_cast<StageID>(_stages.size());
+	_stages.push_back({ name, std::move(work), {}, 0, 0.0 });
+	for (auto dependency : dependencies)
+	{
+		ASSERT(dependency >= 0 && dependency < id);
+		_stages[dependency].dependents.push_back(id);
+		_stages[id].dependency_count++;
+	}
+	return id;
+}
+
+void TaskGraph::Run(int thread_count)
+{
+	if (thread_count <= 0)
+		thread_count = GetWorkerThreadCount();
+
+	const int stage_count = static_cast<int>(_stages.size());
+	std::vector<int> waiting_on(stage_count);
+	std::deque<StageID> ready;
+	for (StageID id = 0; id < stage_count; id++)
+	{
+		waiting_on[id] = _stages[id].dependency_count;
+		if (waiting_on[id] == 0)
+			ready.push_back(id);
+	}
+
+	auto& pool = WorkerPool::GetInstance();
+	std::mutex mutex;
+	int running = 0;
+	std::atomic<int> finished(0);
+	Stopwatch stopwatch;
+
+	// Hands ready stages to the pool while fewer than thread_count are running; called with
+	// mutex held. The stages themselves fan out further with ParallelFor on the same pool.
+	std::function<void()> dispatch = [&]()
+	{
+		while (!ready.empty() && running < thread_count)
+		{
+			const StageID id = ready.front();
+			ready.pop_front();
+			running++;
+			pool.Submit([&, id]
+			{
+				Stopwatch stage_stopwatch;
+				_stages[id].work();
+				const double milliseconds = stage_stopwatch.GetElapsedMilliseconds();
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					_stages[id].milliseconds = milliseconds;
+					running--;
+					for (auto dependent : _stages[id].dependents)
+					{
+						if (--waiting_on[dependent] == 0)
+							ready.push_back(dependent);
+					}
+					dispatch();
+				}
+				// Last, since the caller returns and unwinds these locals once every stage is counted
+				finished++;
+			});
+		}
+	};
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		dispatch();
+	}
+	pool.HelpUntil([&] { return finished.load() == stage_count; });
+
+	_total_milliseconds = stopwatch.GetElapsedMilliseconds();
+}
+
+void TaskGraph::PrintTimings() const
+{
+	for (auto& stage : _stages)
+		PRINTF(L"[TIMING] %s: %.3f ms\n", stage.name, stage.milliseconds);
+	PRINTF(L"[TIMING] Stage graph wall time: %.3f ms\n", _total_milliseconds);
+}
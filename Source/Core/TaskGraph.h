@@ -0,0 +1,40 @@
+#pragma once
+#include "StdIncludes.h"
+#include <functional>
+#include <initializer_list>
+
+// A set of named stages and the stages each one waits for. Run() starts a stage as soon as
+// everything it depends on has finished, so independent stages run side by side on the
+// WorkerPool, and records how long each stage took. Stages that are data parallel split their
+// own work, usually with ParallelFor. A stage can only depend on stages added before it, so
+// the graph never has a cycle.
+class TaskGraph
+{
+public:
+	typedef int StageID;
+
+private:
+	struct Stage
+	{
+		const wchar_t* name;
+		std::function<void()> work;
+		std::vector<StageID> dependents;
+		int dependency_count;
+		double milliseconds;
+	};
+	std::vector<Stage> _stages;
+	double _total_milliseconds;
+
+public:
+	TaskGraph();
+
+	StageID AddStage(const wchar_t* name, std::function<void()> work, std::initializer_list<StageID> dependencies = {});
+	// Runs every stage once on up to thread_count threads, including the calling thread.
+	// 0 uses GetWorkerThreadCount().
+	void Run(int thread_count = 0);
+
+	double GetStageMilliseconds(StageID stage) const { return _stages[stage].milliseconds; }
+	double GetTotalMilliseconds() const { return _total_milliseconds; }
+	// One [TIMING] line per stage in the order they were added, then the wall time of the run
+	void PrintTimings() const;
+};
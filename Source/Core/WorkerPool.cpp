@@ -0,0 +1,71 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool()
+	: _stopping(false)
+{
+	// The thread that submits work helps run it, so one fewer than the hardware has
+	const int thread_count = max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+	_threads.reserve(thread_count);
+	for (int i = 0; i < thread_count; i++)
+		_threads.emplace_back(&WorkerPool::_WorkerLoop, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_changed.notify_all();
+	for (auto& thread : _threads)
+		thread.join();
+}
+
+WorkerPool& WorkerPool::GetInstance()
+{
+	static WorkerPool instance;
+	return instance;
+}
+
+void WorkerPool::_WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true)
+	{
+		_changed.wait(lock, [this] { return !_jobs.empty() || _stopping; });
+		if (_jobs.empty())
+			return;
+		_RunJob(lock);
+	}
+}
+
+void WorkerPool::_RunJob(std::unique_lock<std::mutex>& lock)
+{
+	auto job = std::move(_jobs.front());
+	_jobs.pop_front();
+	lock.unlock();
+	job();
+	lock.lock();
+	_changed.notify_all();
+}
+
+void WorkerPool::Submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back(std::move(job));
+	}
+	_changed.notify_one();
+}
+
+void WorkerPool::HelpUntil(const std::function<bool()>& done)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (!done())
+	{
+		if (_jobs.empty())
+			_changed.wait(lock, [&] { return !_jobs.empty() || done(); });
+		else
+			_RunJob(lock);
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "StdIncludes.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Threads started once and kept for the life of the program. ParallelFor and TaskGraph hand
+// their work to this pool rather than starting threads of their own. A caller waiting on work
+// it submitted runs queued jobs in the meantime (HelpUntil), so a TaskGraph stage that calls
+// ParallelFor neither deadlocks nor adds threads: at most one pool thread per hardware thread
+// plus the waiting callers ever run jobs.
+class WorkerPool
+{
+	std::vector<std::thread> _threads;
+	std::deque<std::function<void()>> _jobs;
+	std::mutex _mutex;
+	// Signalled when a job is queued and when a job finishes
+	std::condition_variable _changed;
+	bool _stopping;
+
+	WorkerPool();
+	~WorkerPool();
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	void _WorkerLoop();
+	// Runs one job and wakes every waiter so they can recheck what they wait for.
+	// Called with lock held; returns with it held.
+	void _RunJob(std::unique_lock<std::mutex>& lock);
+
+public:
+	static WorkerPool& GetInstance();
+
+	int GetThreadCount() const { return static_cast<int>(_threads.size()); }
+	void Submit(std::function<void()> job);
+	// Runs queued jobs on the calling thread until done() returns true. done() must become
+	// true through a job finishing, since that is what wakes an idle waiter.
+	void HelpUntil(const std::function<bool()>& done);
+};
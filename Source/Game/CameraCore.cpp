@@ -0,0 +1,203 @@
+#include "CameraCore.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+CameraCore::CameraCore()
+	: _position(6.0f, 20.0f, 6.0f)
+	, _yaw(0.0f)
+	, _pitch(0.0f)
+	, _viewport_width(1.0f)
+	, _viewport_height(1.0f)
+	, _dirty(true)
+{
+	SetLens(0.25f * XM_PI, 1.0f, 1.0f, 100000.0f);
+}
+
+void CameraCore::SetPosition(const XMFLOAT3& position)
+{
+	_position = position;
+	_dirty = true;
+}
+
+void CameraCore::Yaw(float radians)
+{
+	_yaw += radians;
+	_dirty = true;
+}
+
+void CameraCore::Pitch(float radians)
+{
+	_pitch += radians;
+	_dirty = true;
+}
+
+void CameraCore::SetLens(float fov_y, float aspect, float near_z, float far_z)
+{
+	XMStoreFloat4x4(&_projection, XMMatrixPerspectiveFovLH(fov_y, aspect, near_z, far_z));
+	_dirty = true;
+}
+
+void CameraCore::SetViewport(float width, float height)
+{
+	// Only used to map viewport points to the lens, so no matrix depends on it
+	_viewport_width = width;
+	_viewport_height = height;
+}
+
+void CameraCore::_Update() const
+{
+	if (!_dirty)
+		return;
+
+	XMVECTOR look = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+	XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+	XMVECTOR right = XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+
+	auto yaw_matrix = XMMatrixRotationAxis(up, _yaw);
+	look = XMVector3Transform(look, yaw_matrix);
+	right = XMVector3Transform(right, yaw_matrix);
+
+	auto pitch_matrix = XMMatrixRotationAxis(right, _pitch);
+	look = XMVector3Transform(look, pitch_matrix);
+	up = XMVector3Transform(up, pitch_matrix);
+
+	XMStoreFloat3(&_right, right);
+	XMStoreFloat3(&_up, up);
+	XMStoreFloat3(&_look, look);
+
+	auto position = XMLoadFloat3(&_position);
+	float right_dot, up_dot, look_dot;
+	XMStoreFloat(&right_dot, XMVector3Dot(position, right));
+	XMStoreFloat(&up_dot, XMVector3Dot(position, up));
+	XMStoreFloat(&look_dot, XMVector3Dot(position, look));
+
+	_view = XMFLOAT4X4(
+		_right.x, _up.x, _look.x, 0.0f,
+		_right.y, _up.y, _look.y, 0.0f,
+		_right.z, _up.z, _look.z, 0.0f,
+		-right_dot, -up_dot, -look_dot, 1.0f);
+
+	// The rows of the inverse are the axes the view projects onto and the position
+	_inverse_view = XMFLOAT4X4(
+		_right.x, _right.y, _right.z, 0.0f,
+		_up.x, _up.y, _up.z, 0.0f,
+		_look.x, _look.y, _look.z, 0.0f,
+		_position.x, _position.y, _position.z, 1.0f);
+
+	XMStoreFloat4x4(&_view_projection, XMLoadFloat4x4(&_view) * XMLoadFloat4x4(&_projection));
+	_dirty = false;
+}
+
+const XMFLOAT3& CameraCore::GetRight() const
+{
+	_Update();
+	return _right;
+}
+
+const XMFLOAT3& CameraCore::GetUp() const
+{
+	_Update();
+	return _up;
+}
+
+const XMFLOAT3& CameraCore::GetLook() const
+{
+	_Update();
+	return _look;
+}
+
+const XMFLOAT4X4& CameraCore::GetView() const
+{
+	_Update();
+	return _view;
+}
+
+const XMFLOAT4X4& CameraCore::GetInverseView() const
+{
+	_Update();
+	return _inverse_view;
+}
+
+const XMFLOAT4X4& CameraCore::GetViewProjection() const
+{
+	_Update();
+	return _view_projection;
+}
+
+void CameraCore::ComputeRay(const XMFLOAT2& screen_point, XMFLOAT3& origin, XMFLOAT3& direction) const
+{
+	_Update();
+	auto vx = (2.0f * screen_point.x / _viewport_width - 1.0f) / _projection._11;
+	auto vy = (-2.0f * screen_point.y / _viewport_height + 1.0f) / _projection._22;
+
+	// (vx, vy, 1) in view space moved to world space by the rotation rows of the inverse view
+	auto d = XMLoadFloat3(&_right) * vx + XMLoadFloat3(&_up) * vy + XMLoadFloat3(&_look);
+	origin = _position;
+	XMStoreFloat3(&direction, XMVector3Normalize(d));
+}
+
+void CameraCore::UnprojectToPlane(const XMFLOAT2* screen_points, size_t count, float plane_y, XMFLOAT2* plane_points) const
+{
+	_Update();
+	// vx and vy of ComputeRay as one multiply and add per axis
+	auto scale_x = _mm_set1_ps(2.0f / (_viewport_width * _projection._11));
+	auto bias_x = _mm_set1_ps(-1.0f / _projection._11);
+	auto scale_y = _mm_set1_ps(-2.0f / (_viewport_height * _projection._22));
+	auto bias_y = _mm_set1_ps(1.0f / _projection._22);
+	auto right_x = _mm_set1_ps(_right.x);
+	auto right_y = _mm_set1_ps(_right.y);
+	auto right_z = _mm_set1_ps(_right.z);
+	auto up_x = _mm_set1_ps(_up.x);
+	auto up_y = _mm_set1_ps(_up.y);
+	auto up_z = _mm_set1_ps(_up.z);
+	auto look_x = _mm_set1_ps(_look.x);
+	auto look_y = _mm_set1_ps(_look.y);
+	auto look_z = _mm_set1_ps(_look.z);
+	auto origin_x = _mm_set1_ps(_position.x);
+	auto origin_z = _mm_set1_ps(_position.z);
+	auto height = _mm_set1_ps(plane_y - _position.y);
+	auto zero = _mm_setzero_ps();
+	auto limit = _mm_set1_ps(FLT_MAX);
+	auto nan = _mm_set1_ps(NAN);
+
+	// Four interleaved points in, four interleaved (x, z) out
+	auto unproject = [&](const float* in, float* out)
+	{
+		auto first = _mm_loadu_ps(in);
+		auto second = _mm_loadu_ps(in + 4);
+		auto vx = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0)), scale_x), bias_x);
+		auto vy = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1)), scale_y), bias_y);
+
+		// The direction is left unnormalized since only the point where it meets the plane is needed
+		auto dx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, right_x), _mm_mul_ps(vy, up_x)), look_x);
+		auto dy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, right_y), _mm_mul_ps(vy, up_y)), look_y);
+		auto dz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, right_z), _mm_mul_ps(vy, up_z)), look_z);
+
+		// Behind the camera, parallel (infinite) and 0 / 0 (NaN) all fail this
+		auto t = _mm_div_ps(height, dy);
+		auto hit = _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmple_ps(t, limit));
+		auto x = _mm_add_ps(origin_x, _mm_mul_ps(t, dx));
+		auto z = _mm_add_ps(origin_z, _mm_mul_ps(t, dz));
+		x = _mm_or_ps(_mm_and_ps(hit, x), _mm_andnot_ps(hit, nan));
+		z = _mm_or_ps(_mm_and_ps(hit, z), _mm_andnot_ps(hit, nan));
+		_mm_storeu_ps(out, _mm_unpacklo_ps(x, z));
+		_mm_storeu_ps(out + 4, _mm_unpackhi_ps(x, z));
+	};
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		unproject(&screen_points[i].x, &plane_points[i].x);
+
+	if (i < count)
+	{
+		XMFLOAT2 in[4] = {};
+		XMFLOAT2 out[4];
+		std::copy(screen_points + i, screen_points + count, in);
+		unproject(&in[0].x, &out[0].x);
+		std::copy(out, out + (count - i), plane_points + i);
+	}
+}
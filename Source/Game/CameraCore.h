@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <DirectXMath.h>
+
+/*
+Camera math without a device or a window: position, yaw and pitch, the lens, the viewport size,
+and the matrices derived from them. The view matrix, its inverse and the view projection matrix
+are rebuilt on first use after something they depend on changed, so picking several points per
+mouse event inverts nothing. The view is a rotation and a translation, so its inverse is built
+from the camera's axes and position instead of with a general inverse. Camera adds the GPU
+constant buffer and the behaviours on top of this. */
+class CameraCore
+{
+	DirectX::XMFLOAT3 _position;
+	float _yaw;
+	float _pitch;
+	float _viewport_width;
+	float _viewport_height;
+	DirectX::XMFLOAT4X4 _projection;
+	// Derived from the above by _Update()
+	mutable DirectX::XMFLOAT3 _right;
+	mutable DirectX::XMFLOAT3 _up;
+	mutable DirectX::XMFLOAT3 _look;
+	mutable DirectX::XMFLOAT4X4 _view;
+	mutable DirectX::XMFLOAT4X4 _inverse_view;
+	mutable DirectX::XMFLOAT4X4 _view_projection;
+	mutable bool _dirty;
+
+	void _Update() const;
+
+public:
+	CameraCore();
+
+	void SetPosition(const DirectX::XMFLOAT3& position);
+	const DirectX::XMFLOAT3& GetPosition() const { return _position; }
+	void Yaw(float radians);
+	void Pitch(float radians);
+	void SetLens(float fov_y, float aspect, float near_z, float far_z);
+	void SetViewport(float width, float height);
+	float GetViewportWidth() const { return _viewport_width; }
+	float GetViewportHeight() const { return _viewport_height; }
+
+	const DirectX::XMFLOAT3& GetRight() const;
+	const DirectX::XMFLOAT3& GetUp() const;
+	const DirectX::XMFLOAT3& GetLook() const;
+	const DirectX::XMFLOAT4X4& GetView() const;
+	const DirectX::XMFLOAT4X4& GetInverseView() const;
+	const DirectX::XMFLOAT4X4& GetProjection() const { return _projection; }
+	const DirectX::XMFLOAT4X4& GetViewProjection() const;
+
+	// The ray through a point of the viewport, in world space with a unit direction
+	void ComputeRay(const DirectX::XMFLOAT2& screen_point, DirectX::XMFLOAT3& origin, DirectX::XMFLOAT3& direction) const;
+
+	// Where the rays through many viewport points hit the horizontal plane y = plane_y, as (x, z).
+	// Four points are done at a time with SSE. A ray that is parallel to the plane or meets it
+	// behind the camera gives NaN.
+	void UnprojectToPlane(const DirectX::XMFLOAT2* screen_points, size_t count, float plane_y, DirectX::XMFLOAT2* plane_points) const;
+};
+
+void RunCameraPickingBenchmark();
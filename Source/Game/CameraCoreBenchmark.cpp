@@ -0,0 +1,77 @@
+#include "CameraCore.h"
+#include <Core/StdIncludes.h>
+#include <Core/Stopwatch.h>
+#include <TileEngine/Tile.h>
+
+void RunCameraPickingBenchmark()
+{
+	// The map camera of Main looking straight down from its start position, picking points all over
+	// a 1080p viewport
+	const int pick_count = 1000000;
+	const float width = 1920.0f;
+	const float height = 1080.0f;
+	CameraCore camera;
+	camera.SetLens(0.25f * XM_PI, width / height, 1.0f, 100000.0f);
+	camera.SetViewport(width, height);
+	camera.SetPosition(XMFLOAT3(MAP_ABSOLUTE_CENTER, 1000.0f, MAP_ABSOLUTE_CENTER));
+	camera.Pitch(XMConvertToRadians(90.0f));
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> x(0.0f, width);
+	std::uniform_real_distribution<float> y(0.0f, height);
+	std::vector<XMFLOAT2> screen_points(pick_count);
+	for (auto& point : screen_points)
+		point = XMFLOAT2(x(random), y(random));
+
+	auto to_plane = [](const XMFLOAT3& origin, const XMFLOAT3& direction)
+	{
+		auto t = -origin.y / direction.y;
+		return XMFLOAT2(origin.x + t * direction.x, origin.z + t * direction.z);
+	};
+
+	// What Camera::ComputeRayFromScreenPoint did: invert the view matrix on every pick
+	std::vector<XMFLOAT2> inverted(pick_count);
+	auto& projection = camera.GetProjection();
+	Stopwatch stopwatch;
+	for (int i = 0; i < pick_count; ++i)
+	{
+		auto vx = (2.0f * screen_points[i].x / width - 1.0f) / projection._11;
+		auto vy = (-2.0f * screen_points[i].y / height + 1.0f) / projection._22;
+		auto view = XMLoadFloat4x4(&camera.GetView());
+		auto determinant = XMMatrixDeterminant(view);
+		auto inverse_view = XMMatrixInverse(&determinant, view);
+		XMFLOAT3 origin, direction;
+		XMStoreFloat3(&origin, XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), inverse_view));
+		XMStoreFloat3(&direction, XMVector3Normalize(XMVector3TransformNormal(XMVectorSet(vx, vy, 1.0f, 0.0f), inverse_view)));
+		inverted[i] = to_plane(origin, direction);
+	}
+	auto inverted_ms = stopwatch.Lap(L"Picking with an inverse per pick");
+
+	std::vector<XMFLOAT2> cached(pick_count);
+	for (int i = 0; i < pick_count; ++i)
+	{
+		XMFLOAT3 origin, direction;
+		camera.ComputeRay(screen_points[i], origin, direction);
+		cached[i] = to_plane(origin, direction);
+	}
+	auto cached_ms = stopwatch.Lap(L"Picking with the cached inverse");
+
+	std::vector<XMFLOAT2> batched(pick_count);
+	camera.UnprojectToPlane(screen_points.data(), screen_points.size(), 0.0f, batched.data());
+	auto batched_ms = stopwatch.Lap(L"Picking in SSE batches");
+
+	// All three should land on the same map pixel
+	float cached_error = 0.0f;
+	float batched_error = 0.0f;
+	for (int i = 0; i < pick_count; ++i)
+	{
+		cached_error = max(cached_error, max(fabsf(cached[i].x - inverted[i].x), fabsf(cached[i].y - inverted[i].y)));
+		batched_error = max(batched_error, max(fabsf(batched[i].x - inverted[i].x), fabsf(batched[i].y - inverted[i].y)));
+	}
+
+	auto picks_per_second = [&](double ms) { return pick_count / (ms / 1000.0) / 1000000.0; };
+	PRINTF(L"%d picks in millions per second: inverse per pick %.1f, cached inverse %.1f, SSE batches %.1f "
+		L"(largest difference to the inverse per pick: cached %.3f, batched %.3f map pixels)\n", pick_count,
+		picks_per_second(inverted_ms), picks_per_second(cached_ms), picks_per_second(batched_ms),
+		cached_error, batched_error);
+}
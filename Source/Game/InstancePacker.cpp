@@ -0,0 +1,17 @@
+#include "InstancePacker.h"
+#include <Core/ColorConverter.h>
+
+static_assert(sizeof(StaticFeatureInstance) == 32, "StaticFeatureInstance must match the instanced input layout");
+
+void InstancePacker::Pack(const StaticFeature* features, size_t features_count)
+{
+	_instances.resize(features_count);
+	for (size_t i = 0; i < features_count; ++i)
+	{
+		auto& instance = _instances[i];
+		instance.position = features[i].position;
+		instance.rotation = features[i].rotation;
+		instance.scale = features[i].scale * STATIC_FEATURE_MODEL_SCALE;
+		instance.color = ConvertColor(features[i].color);
+	}
+}
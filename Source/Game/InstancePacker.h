@@ -0,0 +1,34 @@
+#pragma once
+#include <Core/StdIncludes.h>
+#include <TileEngine/Models/StaticFeature.h>
+
+// Width of a static feature's model at scale 1, in max zoom pixels
+#define STATIC_FEATURE_MODEL_SCALE 50.0f
+
+// Per instance data read by StaticFeatureInstanced.fx. The layout matches the INSTANCE_*
+// elements of the instanced input layout in MapRenderer, so it must stay tightly packed.
+struct StaticFeatureInstance
+{
+	XMFLOAT2 position;
+	float rotation;
+	float scale;
+	XMFLOAT4 color;
+};
+
+/*
+Turns the static feature draw list into the instance array uploaded for one instanced draw.
+Packing touches no graphics objects, so it can be run and timed without a device. The array
+keeps its capacity between frames and only grows when the draw list does. */
+class InstancePacker
+{
+	std::vector<StaticFeatureInstance> _instances;
+
+public:
+	void Pack(const StaticFeature* features, size_t features_count);
+
+	const StaticFeatureInstance* GetData() const { return _instances.data(); }
+	size_t GetCount() const { return _instances.size(); }
+	size_t GetByteSize() const { return _instances.size() * sizeof(StaticFeatureInstance); }
+};
+
+void RunInstancePackerBenchmark();
@@ -0,0 +1,45 @@
+#include "InstancePacker.h"
+#include <Core/ColorConverter.h>
+#include <Core/Stopwatch.h>
+
+void RunInstancePackerBenchmark()
+{
+	const size_t features_count = 100000;
+	const int frame_count = 100;
+	std::vector<StaticFeature> features(features_count);
+	for (size_t i = 0; i < features_count; ++i)
+	{
+		features[i].position = XMFLOAT2(static_cast<float>(i % 1000) * 64.0f, static_cast<float>(i / 1000) * 64.0f);
+		features[i].color = 0x33FF33FF;
+	}
+
+	// What the per feature path computed on the CPU before every Map and DrawIndexed
+	Stopwatch stopwatch;
+	XMFLOAT4X4 world_matrix;
+	XMFLOAT4 color;
+	float checksum = 0.0f;
+	for (int frame = 0; frame < frame_count; ++frame)
+	{
+		for (auto& feature : features)
+		{
+			color = ConvertColor(feature.color);
+			auto world_mat = XMMatrixIdentity() *
+				XMMatrixScaling(STATIC_FEATURE_MODEL_SCALE, 1.0f, STATIC_FEATURE_MODEL_SCALE) *
+				XMMatrixTranslation(feature.position.x, 1.0f, feature.position.y);
+			XMStoreFloat4x4(&world_matrix, XMMatrixTranspose(world_mat));
+			checksum += world_matrix._14 + color.w;
+		}
+	}
+	auto matrices_ms = stopwatch.Lap(L"Per feature world matrices") / frame_count;
+
+	InstancePacker packer;
+	for (int frame = 0; frame < frame_count; ++frame)
+	{
+		packer.Pack(features.data(), features.size());
+		checksum += packer.GetData()[frame].position.x;
+	}
+	auto pack_ms = stopwatch.Lap(L"InstancePacker::Pack") / frame_count;
+
+	PRINTF(L"%d static features: world matrices = %.3f ms/frame, packing = %.3f ms/frame (%d bytes uploaded), checksum = %f\n",
+		static_cast<int>(features_count), matrices_ms, pack_ms, static_cast<int>(packer.GetByteSize()), checksum);
+}
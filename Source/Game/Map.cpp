@@ -9,13 +9,22 @@ bool IsValid(const MapPoint& map_point)
 {
 	return !isnan(map_point.x);
 }
+// The land mesh is kept next to the save game so startup maps it instead of triangulating again.
+// The mesh and the save game db each take their own time(NULL) seed, so deleting one of the two
+// files does not regenerate the other: delete both to start a new map.
+#define MAP_MESH_FILENAME "Data/SaveGame.mesh"
+
 namespace
 {
-	const BoundingBox map_bbox_zoom_0
+	LandGenerator LoadOrGenerateLand()
 	{
-		{ MAP_ABSOLUTE_CENTER, 0.0f, MAP_ABSOLUTE_CENTER }, // Center of bbox
-		{ MAP_ABSOLUTE_CENTER, 0.0f, MAP_ABSOLUTE_CENTER } // Extents of bbox from center
-	};
+		if (auto mesh = DualMesh::Load(MAP_MESH_FILENAME))
+			return LandGenerator(std::move(*mesh));
+
+		LandGenerator generator(time(NULL), { 256.0, 256.0 }, 8);
+		generator.GetMesh().Save(MAP_MESH_FILENAME);
+		return generator;
+	}
 }
 
 Map::Map(std::shared_ptr<Camera> camera, const char* const db_filename)
@@ -24,7 +33,7 @@ Map::Map(std::shared_ptr<Camera> camera, const char* const db_filename)
 	, _zoom(0, 0)
 	, _cam(camera)
 	, _visible_tiles_frozen(false)
-	, _generator(time(NULL), { 256.0, 256.0 }, 8)
+	, _generator(LoadOrGenerateLand())
 	, _scale_test(1)
 	, _coastlines(_generator.GetCoastlines())
 {
@@ -57,6 +66,15 @@ void Map::_RefreshTiles()
 	_visible_area.extent.y = top_right.y - _center_screen.y;
 
 	_tile_engine->Refresh(_visible_area, _zoom.major_part);
+
+	// The border overlay only changes with the set of visible tiles
+	auto& visible_tiles = _tile_engine->GetVisibleTiles();
+	if (visible_tiles != _tile_border_tiles)
+	{
+		_tile_border_tiles = visible_tiles;
+		TileBorders::Build(_tile_border_tiles, _tile_border_lines);
+		_renderer->SetTileBorders(_tile_border_lines);
+	}
 }
 
 auto Map::ZoomInPoint(const MapPoint& point) -> MapPoint
@@ -114,23 +132,21 @@ auto Map::GetZoom() const -> ZoomLevel
 
 MapPoint Map::ScreenPointToMapPoint(const XMFLOAT2& screen_point)
 {
-	XMFLOAT3 origin, direction;
-	_cam->ComputeRayFromScreenPoint(screen_point, origin, direction);
-	if (isnan(direction.x))
-	{
-		return InvalidMapPoint;
-	}
-	XMVECTOR o = XMLoadFloat3(&origin);
-	XMVECTOR d = XMLoadFloat3(&direction);
-	float distance;
-	if (map_bbox_zoom_0.Intersects(o, d, distance))
+	MapPoint result;
+	ScreenPointsToMapPoints(&screen_point, 1, &result);
+	return result;
+}
+
+void Map::ScreenPointsToMapPoints(const XMFLOAT2* screen_points, size_t count, MapPoint* map_points)
+{
+	// The map is the plane y = 0, and only the square of zoom level 0 around the center is on it
+	_cam->GetCore().UnprojectToPlane(screen_points, count, 0.0f, map_points);
+	for (size_t i = 0; i < count; ++i)
 	{
-		auto intersection_point = o + d * distance;
-		XMFLOAT3 result;
-		XMStoreFloat3(&result, intersection_point);
-		return MapPoint(result.x, result.z);
+		auto& point = map_points[i];
+		if (!(point.x >= 0.0f && point.x <= 2.0f * MAP_ABSOLUTE_CENTER && point.y >= 0.0f && point.y <= 2.0f * MAP_ABSOLUTE_CENTER))
+			point = InvalidMapPoint;
 	}
-	return InvalidMapPoint;
 }
 
 MapPoint Map::GetCursor(bool refresh)
@@ -163,7 +179,13 @@ typedef GraphicsWindow::Event::Type EventType;
 
 void Map::HandleEvent(const GraphicsWindow::Event & event)
 {
-	if (event.type == EventType::MouseWheelDown)
+	if (event.type == EventType::WindowResize)
+	{
+		// The camera has taken the new viewport, so the centre and the visible tiles moved
+		GetCenterScreen(true);
+		_RefreshTiles();
+	}
+	else if (event.type == EventType::MouseWheelDown)
 	{
 		ZoomOut();
 	}
@@ -206,7 +228,9 @@ void Map::HandleEvent(const GraphicsWindow::Event & event)
 	}
 	else if (event.code == GraphicsWindow::Event::Code::Home && event.type == GraphicsWindow::Event::Type::KeyRelease)
 	{
+		// Assigning first unmaps the old mesh file so it can be overwritten
 		_generator = LandGenerator(time(NULL), { 256.0, 256.0 }, 8);
+		_generator.GetMesh().Save(MAP_MESH_FILENAME);
 		_coastlines = _generator.GetCoastlines();
 	}
 }
@@ -214,21 +238,11 @@ void Map::HandleEvent(const GraphicsWindow::Event & event)
 void Map::_DrawTiles()
 {
 	// draw tile borders
-	auto& tile_ids = _tile_engine->GetVisibleTiles();
-	for (auto& id : tile_ids)
-	{
-		Tile tile(id);
-		_renderer->DrawTile(tile, 0xFFFF77FF);
-		//if (tile.Contains(_cursor))
-		//{
-		//	auto pos = tile.GetPosition();
-		//	_renderer->DrawSquare(pos.x, pos.y, 10.0f, 0.f, 0xFF0000FF);
-		//}
-	}
+	_renderer->DrawTileBorders(0xFFFF77FF);
 	_tile_engine->PrepareDrawLists();
 	if (_tile_engine->DynamicFeatureDrawListCount() > 0)
 	{
-		_renderer->DrawDynamicFeaturesBulk(_tile_engine->GetDynamicFeatureDrawList(), _zoom.major_part);
+		_renderer->DrawDynamicFeaturesBulk(_tile_engine->GetDynamicFeatureDrawList(), _tile_engine->GetVertexPool(), _zoom.major_part);
 	}
 	if (_tile_engine->StaticFeatureDrawListCount() > 0)
 	{
@@ -257,6 +271,7 @@ void Map::RenderScene()
 
 	_DrawTiles();
 	//_renderer->DrawMapBounds();
+	_renderer->Flush();
 }
 
 //auto edges = mesh.GetRegionEdges(i);
@@ -264,7 +279,7 @@ void Map::RenderScene()
 //{
 //	auto v0 = mesh.region_vertices[s_to_t(e)];
 
-//	auto noisy_edges = _generator.GetNoisyEdges(e);
+//	auto noisy_edges = _generator.GetNoisyEdge(e, _generator.GetNoisyEdgeLod(1.0));
 //	//auto center = mesh.vertices[i].Shrink();
 //	if (noisy_edges.size() > 0)
 //	{
@@ -2,6 +2,7 @@
 #include <Core/StdIncludes.h>
 #include <Core/GraphicsWindow.h>
 #include <TileEngine/TileEngine.h>
+#include <TileEngine/TileBorders.h>
 #include "MapRenderer.h"
 #include "Camera.h"
 #include <map>
@@ -96,6 +97,9 @@ private:
 	BoundingRect _visible_area;
 	//std::map<TileID, TileVectorData> _data_cache;
 	bool _visible_tiles_frozen;
+	// Tiles the border overlay was last built for, and its line list
+	std::set<TileID> _tile_border_tiles;
+	std::vector<XMFLOAT2> _tile_border_lines;
 	void _RefreshTiles();
 	void _DrawTiles();
 	int _scale_test;
@@ -117,5 +121,7 @@ public:
 	void Tick(float delta_time);
 	void HandleEvent(const GraphicsWindow::Event& event);
 	XMFLOAT2 ScreenPointToMapPoint(const XMFLOAT2& screen_point);
+	// The same for many points at once; points off the map give InvalidMapPoint
+	void ScreenPointsToMapPoints(const XMFLOAT2* screen_points, size_t count, MapPoint* map_points);
 
 };
\ No newline at end of file
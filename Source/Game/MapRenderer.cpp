@@ -1,10 +1,8 @@
 #include "MapRenderer.h"
-#include <Core/ColorConverter.h>
 #include <TileEngine/Tile.h>
 #include <cmath>
 
 #define MAP_BOUNDS_VERTEX_COUNT 5
-#define IMMEDIATE_BUFFER_VERTEX_COUNT 1000
 
 
 MapRenderer::MapRenderer(std::shared_ptr<Camera> camera)
@@ -13,11 +11,16 @@ MapRenderer::MapRenderer(std::shared_ptr<Camera> camera)
 	, m_squareShader(LR"(Data/Square.fx)", Shader::Vertex | Shader::Pixel)
 	, m_squareInputLayout(nullptr)
 	, _map_bounds_shader(LR"(Data/MapBounds.fx)", Shader::Vertex | Shader::Pixel)
-	, m_perObjectBuffer(nullptr)
 	, _map_bounds_buffer(nullptr)
 	, _map_bounds_input_layout(nullptr)
-	, _static_feature_shader(LR"(Data/StaticFeature.fx)", Shader::Vertex | Shader::Pixel)
+	, _tile_border_buffer(nullptr)
+	, _tile_border_vertex_count(0)
+	, _static_feature_shader(LR"(Data/StaticFeatureInstanced.fx)", Shader::Vertex | Shader::Pixel)
 	, _static_feature_input_layout(nullptr)
+	, _vertex_pool_vertices(RENDER_NO_BUFFER)
+	, _immediate(_commands, RenderLayer::Overlay)
+	, _immediate_stats{}
+	, _dynamic_feature_draw_calls(0)
 	, _cam(camera)
 {
 
@@ -40,7 +43,14 @@ MapRenderer::MapRenderer(std::shared_ptr<Camera> camera)
 		{ "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 }
 	};
 
-	if (!D3DCheck(device->CreateInputLayout(layout2, _countof(layout2), m_squareShader.GetByteCode(Shader::Vertex)->GetBufferPointer(),
+	// The backend binds an index stream in slot 1 whose first instance selects the draw's object
+	D3D11_INPUT_ELEMENT_DESC square_layout[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "OBJECT", 0, DXGI_FORMAT_R32_UINT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 }
+	};
+
+	if (!D3DCheck(device->CreateInputLayout(square_layout, _countof(square_layout), m_squareShader.GetByteCode(Shader::Vertex)->GetBufferPointer(),
 		m_squareShader.GetByteCode(Shader::Vertex)->GetBufferSize(), &m_squareInputLayout),
 		L"ID3D11Device::CreateInputLayout (MapRenderer, square)")) return;
 
@@ -52,16 +62,6 @@ MapRenderer::MapRenderer(std::shared_ptr<Camera> camera)
 
 	_map_bounds_shader.ReleaseByteCode();
 
-	D3D11_BUFFER_DESC desc;
-
-	ZeroMemory(&desc, sizeof(desc));
-	desc.Usage = D3D11_USAGE_DYNAMIC;
-	desc.ByteWidth = sizeof(ModelPerObjectBuffer);
-	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	if (!D3DCheck(device->CreateBuffer(&desc, nullptr, &m_perObjectBuffer),
-		L"ID3D11Device::CreateBuffer (MapRenderer, SquarePerObjectBuffer)")) return;
-
 	float w = (pow(2, TILE_MAX_ZOOM) * TILE_PIXEL_WIDTH);
 	Square::Vertex verts[MAP_BOUNDS_VERTEX_COUNT];
 	verts[0].x = 0.f;
@@ -97,6 +97,11 @@ MapRenderer::MapRenderer(std::shared_ptr<Camera> camera)
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 		{ "NORMAL", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		// StaticFeatureInstance, advanced once per instance
+		{ "INSTANCE_POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCE_ROTATION", 0, DXGI_FORMAT_R32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCE_SCALE", 0, DXGI_FORMAT_R32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCE_COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
 	};
 
 	if (!D3DCheck(device->CreateInputLayout(layout3, _countof(layout3), _static_feature_shader.GetByteCode(Shader::Vertex)->GetBufferPointer(),
@@ -104,13 +109,19 @@ MapRenderer::MapRenderer(std::shared_ptr<Camera> camera)
 		L"ID3D11Device::CreateInputLayout (StaticFeature)")) return;
 	_static_feature_shader.ReleaseByteCode();
 
-	ZeroMemory(&desc, sizeof(desc));
-	desc.Usage = D3D11_USAGE_DYNAMIC;
-	desc.ByteWidth = sizeof(XMFLOAT2) * IMMEDIATE_BUFFER_VERTEX_COUNT;
-	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	if (!D3DCheck(device->CreateBuffer(&desc, nullptr, &_immediate_mode_buffer),
-		L"ID3D11Device::CreateBuffer (MapRenderer, ImmediateModeBuffer)")) return;
+	_grid_pipeline = _backend.AddPipeline(m_gridInputLayout, m_gridShader);
+	_square_pipeline = _backend.AddPipeline(m_squareInputLayout, m_squareShader);
+	_map_bounds_pipeline = _backend.AddPipeline(_map_bounds_input_layout, _map_bounds_shader);
+	_static_feature_pipeline = _backend.AddPipeline(_static_feature_input_layout, _static_feature_shader);
+	_immediate.SetPipeline(_square_pipeline);
+
+	auto& cube = _models_manager.GetCube();
+	_grid_vertices = _backend.AddBuffer(m_grid.GetVertexBufferAddr(), sizeof(WorldGrid::Vertex));
+	_square_vertices = _backend.AddBuffer(m_square.GetVertexBufferAddr(), sizeof(Square::Vertex));
+	_map_bounds_vertices = _backend.AddBuffer(&_map_bounds_buffer, sizeof(Square::Vertex));
+	_tile_border_vertices = _backend.AddBuffer(&_tile_border_buffer, sizeof(XMFLOAT2));
+	_cube_vertices = _backend.AddBuffer(cube.GetVertexBufferAddr(), sizeof(Cube::Vertex));
+	_cube_indices = _backend.AddBuffer(cube.GetIndexBufferAddr(), sizeof(uint32_t));
 }
 
 MapRenderer::~MapRenderer()
@@ -121,14 +132,46 @@ MapRenderer::~MapRenderer()
 		m_gridInputLayout->Release();
 	if (m_squareInputLayout)
 		m_squareInputLayout->Release();
-	if (m_perObjectBuffer)
-		m_perObjectBuffer->Release();
 	if (_map_bounds_buffer)
 		_map_bounds_buffer->Release();
 	if (_map_bounds_input_layout)
 		_map_bounds_input_layout->Release();
-	if (_immediate_mode_buffer)
-		_immediate_mode_buffer->Release();
+	if (_tile_border_buffer)
+		_tile_border_buffer->Release();
+}
+
+void MapRenderer::SetTileBorders(const std::vector<XMFLOAT2>& lines)
+{
+	if (_tile_border_buffer)
+		_tile_border_buffer->Release();
+	_tile_border_buffer = nullptr;
+	_tile_border_vertex_count = 0;
+	if (lines.empty())
+		return;
+
+	D3D11_BUFFER_DESC vertexBufferDesc;
+	ZeroMemory(&vertexBufferDesc, sizeof(vertexBufferDesc));
+	vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	vertexBufferDesc.ByteWidth = static_cast<UINT>(sizeof(XMFLOAT2) * lines.size());
+	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+	D3D11_SUBRESOURCE_DATA vertexSubresource;
+	ZeroMemory(&vertexSubresource, sizeof(vertexSubresource));
+	vertexSubresource.pSysMem = lines.data();
+
+	auto device = GraphicsWindow::GetInstance()->GetDevice();
+	if (!D3DCheck(device->CreateBuffer(&vertexBufferDesc, &vertexSubresource, &_tile_border_buffer),
+		L"ID3D11Device::CreateBuffer (_tile_border_buffer, VertexBuffer)")) return;
+	_tile_border_vertex_count = static_cast<uint32_t>(lines.size());
+}
+
+void MapRenderer::DrawTileBorders(unsigned color)
+{
+	if (_tile_border_vertex_count == 0)
+		return;
+	// Drawn just above the map like the squares DrawTile draws
+	_commands.Draw(RenderLayer::TileBorders, _square_pipeline, RenderTopology::LineList, _tile_border_vertices,
+		0, _tile_border_vertex_count, _commands.AddObject(XMMatrixTranslation(0.0f, 1.0f, 0.0f), color));
 }
 
 void MapRenderer::DrawTile(const Tile& tile, unsigned color)
@@ -152,143 +195,27 @@ void MapRenderer::DrawTile(const Tile& tile, unsigned color)
 
 void MapRenderer::DrawGrid()
 {
-	auto context = GraphicsWindow::GetInstance()->GetContext();
-
-	context->IASetInputLayout(m_gridInputLayout);
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
-
-	UINT stride = sizeof(WorldGrid::Vertex);
-	UINT offset = 0;
-
-	context->VSSetShader(m_gridShader.GetVertexShader(), nullptr, 0);
-	context->PSSetShader(m_gridShader.GetPixelShader(), nullptr, 0);
-
-	auto cameraBuffer = _cam->GetConstantBuffer();
-	context->VSSetConstantBuffers(0, 1, &cameraBuffer);
-
-	context->IASetVertexBuffers(0, 1, m_grid.GetVertexBufferAddr(), &stride, &offset);
-
-	context->Draw(m_grid.GetVertexCount(), 0);
-}
-
-void MapRenderer::_UploadPerObjectBuffer(ID3D11DeviceContext* context, const ModelPerObjectBuffer& perObject)
-{
-	// Update per resize buffer
-	D3D11_MAPPED_SUBRESOURCE mappedRes;
-	if (!D3DCheck(context->Map(m_perObjectBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedRes),
-		L"ID3D11DeviceContext::Map (MapRenderer::UploadPerObjectBuffer)")) return;
-	memcpy_s(mappedRes.pData, mappedRes.RowPitch, &perObject, sizeof(perObject));
-	context->Unmap(m_perObjectBuffer, 0);
+	_commands.Draw(RenderLayer::Background, _grid_pipeline, RenderTopology::LineList, _grid_vertices,
+		0, m_grid.GetVertexCount(), RENDER_NO_OBJECT);
 }
 
 void MapRenderer::DrawPoints(const std::vector<XMFLOAT2>& points, unsigned color)
 {
-	ASSERT(points.size() <= IMMEDIATE_BUFFER_VERTEX_COUNT);
-	auto context = GraphicsWindow::GetInstance()->GetContext();
-	// Update per resize buffer
-	D3D11_MAPPED_SUBRESOURCE mappedRes;
-	if (!D3DCheck(context->Map(_immediate_mode_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedRes),
-		L"ID3D11DeviceContext::Map (MapRenderer::UploadPerObjectBuffer)")) return;
-	memcpy_s(mappedRes.pData, mappedRes.RowPitch, &points[0], sizeof(XMFLOAT2) * points.size());
-	context->Unmap(_immediate_mode_buffer, 0);
-
-	__declspec(align(16)) ModelPerObjectBuffer object {};
-	object.color = ConvertColor(color);
-	auto world_mat = XMMatrixIdentity();
-	XMStoreFloat4x4(&object.world_matrix, XMMatrixTranspose(world_mat));
-
-	_UploadPerObjectBuffer(context, object);
-	context->IASetInputLayout(m_squareInputLayout);
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
-
-	UINT stride = sizeof(XMFLOAT2);
-	UINT offset = 0;
-
-	context->VSSetShader(m_squareShader.GetVertexShader(), nullptr, 0);
-	context->PSSetShader(m_squareShader.GetPixelShader(), nullptr, 0);
-
-	auto cameraBuffer = _cam->GetConstantBuffer();
-	context->VSSetConstantBuffers(0, 1, &cameraBuffer);
-	context->VSSetConstantBuffers(1, 1, &m_perObjectBuffer);
-	context->IASetVertexBuffers(0, 1, &_immediate_mode_buffer, &stride, &offset);
-
-	context->Draw(points.size(), 0);
+	_immediate.AddPoints(points.data(), points.size(), color);
 }
 
 void MapRenderer::DrawLineStrip(const std::vector<XMFLOAT2>& verts, unsigned color)
 {
-	//ASSERT(points.size() <= IMMEDIATE_BUFFER_VERTEX_COUNT);
-	auto context = GraphicsWindow::GetInstance()->GetContext();
-	// Update per resize buffer
-	D3D11_MAPPED_SUBRESOURCE mappedRes;
-	if (!D3DCheck(context->Map(_immediate_mode_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedRes),
-		L"ID3D11DeviceContext::Map (MapRenderer::UploadPerObjectBuffer)")) return;
-	memcpy_s(mappedRes.pData, mappedRes.RowPitch, &verts[0], sizeof(XMFLOAT2) * verts.size());
-	context->Unmap(_immediate_mode_buffer, 0);
-
-	__declspec(align(16)) ModelPerObjectBuffer object {};
-	object.color = ConvertColor(color);
-	auto world_mat = XMMatrixIdentity();
-	XMStoreFloat4x4(&object.world_matrix, XMMatrixTranspose(world_mat));
-
-	_UploadPerObjectBuffer(context, object);
-	context->IASetInputLayout(m_squareInputLayout);
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP);
-
-	UINT stride = sizeof(XMFLOAT2);
-	UINT offset = 0;
-
-	context->VSSetShader(m_squareShader.GetVertexShader(), nullptr, 0);
-	context->PSSetShader(m_squareShader.GetPixelShader(), nullptr, 0);
-
-	auto cameraBuffer = _cam->GetConstantBuffer();
-	context->VSSetConstantBuffers(0, 1, &cameraBuffer);
-	context->VSSetConstantBuffers(1, 1, &m_perObjectBuffer);
-	context->IASetVertexBuffers(0, 1, &_immediate_mode_buffer, &stride, &offset);
-
-	context->Draw(verts.size(), 0);
+	_immediate.AddLineStrip(verts.data(), verts.size(), color);
 }
 
 void MapRenderer::DrawLine(const XMFLOAT2& from, const XMFLOAT2& to, unsigned color)
 {
-	//ASSERT(points.size() <= IMMEDIATE_BUFFER_VERTEX_COUNT);
-	auto context = GraphicsWindow::GetInstance()->GetContext();
-	// Update per resize buffer
-	D3D11_MAPPED_SUBRESOURCE mappedRes;
-	std::vector<XMFLOAT2> data{ from, to };
-	if (!D3DCheck(context->Map(_immediate_mode_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedRes),
-		L"ID3D11DeviceContext::Map (MapRenderer::UploadPerObjectBuffer)")) return;
-	memcpy_s(mappedRes.pData, mappedRes.RowPitch, &data[0], sizeof(XMFLOAT2) * data.size());
-	context->Unmap(_immediate_mode_buffer, 0);
-
-	__declspec(align(16)) ModelPerObjectBuffer object {};
-	object.color = ConvertColor(color);
-	auto world_mat = XMMatrixIdentity();
-	XMStoreFloat4x4(&object.world_matrix, XMMatrixTranspose(world_mat));
-
-	_UploadPerObjectBuffer(context, object);
-	context->IASetInputLayout(m_squareInputLayout);
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
-
-	UINT stride = sizeof(XMFLOAT2);
-	UINT offset = 0;
-
-	context->VSSetShader(m_squareShader.GetVertexShader(), nullptr, 0);
-	context->PSSetShader(m_squareShader.GetPixelShader(), nullptr, 0);
-
-	auto cameraBuffer = _cam->GetConstantBuffer();
-	context->VSSetConstantBuffers(0, 1, &cameraBuffer);
-	context->VSSetConstantBuffers(1, 1, &m_perObjectBuffer);
-	context->IASetVertexBuffers(0, 1, &_immediate_mode_buffer, &stride, &offset);
-
-	context->Draw(2, 0);
+	_immediate.AddLine(from, to, color);
 }
 
 void MapRenderer::DrawSquare(float x, float y, float width, float rotation, unsigned color)
 {
-	auto context = GraphicsWindow::GetInstance()->GetContext();
-	__declspec(align(16)) ModelPerObjectBuffer object{};
-	object.color = ConvertColor(color);
 	//auto translation_mat = XMMatrixTranslation(position.x, 0.0f, position.y);
 	//auto scale_mat = XMMatrixScaling(width, 0.0f, width);
 	//auto rotation_mat = XMMatrixRotationY(rotation);
@@ -297,151 +224,82 @@ void MapRenderer::DrawSquare(float x, float y, float width, float rotation, unsi
 					 XMMatrixScaling(width, 0.0f, width) * 
 					 XMMatrixTranslation(x, 1.0f,y);
 
-	XMStoreFloat4x4(&object.world_matrix, XMMatrixTranspose(world_mat));
-	
-	_UploadPerObjectBuffer(context, object);
-	context->IASetInputLayout(m_squareInputLayout);
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP);
-
-	UINT stride = sizeof(Square::Vertex);
-	UINT offset = 0;
-
-	context->VSSetShader(m_squareShader.GetVertexShader(), nullptr, 0);
-	context->PSSetShader(m_squareShader.GetPixelShader(), nullptr, 0);
-
-	auto cameraBuffer = _cam->GetConstantBuffer();
-	context->VSSetConstantBuffers(0, 1, &cameraBuffer);
-	context->VSSetConstantBuffers(1, 1, &m_perObjectBuffer);
-	context->IASetVertexBuffers(0, 1, m_square.GetVertexBufferAddr(), &stride, &offset);
-
-	auto vertex_count = m_square.GetVertexCount();
-	context->Draw(vertex_count, 0);
+	_commands.Draw(RenderLayer::TileBorders, _square_pipeline, RenderTopology::LineStrip, _square_vertices,
+		0, m_square.GetVertexCount(), _commands.AddObject(world_mat, color));
 }
 
 void MapRenderer::DrawTriangle(const XMFLOAT2& a, const XMFLOAT2& b, const XMFLOAT2& c, unsigned color)
 {
-	//ASSERT(points.size() <= IMMEDIATE_BUFFER_VERTEX_COUNT);
-	auto context = GraphicsWindow::GetInstance()->GetContext();
-	// Update per resize buffer
-	D3D11_MAPPED_SUBRESOURCE mappedRes;
-	std::vector<XMFLOAT2> data{ a, b, c };
-	if (!D3DCheck(context->Map(_immediate_mode_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedRes),
-		L"ID3D11DeviceContext::Map (MapRenderer::UploadPerObjectBuffer)")) return;
-	memcpy_s(mappedRes.pData, mappedRes.RowPitch, &data[0], sizeof(XMFLOAT2) * data.size());
-	context->Unmap(_immediate_mode_buffer, 0);
-
-	__declspec(align(16)) ModelPerObjectBuffer object {};
-	object.color = ConvertColor(color);
-	auto world_mat = XMMatrixIdentity();
-	XMStoreFloat4x4(&object.world_matrix, XMMatrixTranspose(world_mat));
-
-	_UploadPerObjectBuffer(context, object);
-	context->IASetInputLayout(m_squareInputLayout);
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-	UINT stride = sizeof(XMFLOAT2);
-	UINT offset = 0;
-
-	context->VSSetShader(m_squareShader.GetVertexShader(), nullptr, 0);
-	context->PSSetShader(m_squareShader.GetPixelShader(), nullptr, 0);
-
-	auto cameraBuffer = _cam->GetConstantBuffer();
-	context->VSSetConstantBuffers(0, 1, &cameraBuffer);
-	context->VSSetConstantBuffers(1, 1, &m_perObjectBuffer);
-	context->IASetVertexBuffers(0, 1, &_immediate_mode_buffer, &stride, &offset);
-
-	context->Draw(3, 0);
-
+	_immediate.AddTriangle(a, b, c, color);
 }
 
 
 void MapRenderer::DrawMapBounds()
 {
-	auto context = GraphicsWindow::GetInstance()->GetContext();
-	context->IASetInputLayout(_map_bounds_input_layout); // same layout, might as well re-use
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP);
-	UINT stride = sizeof(Square::Vertex);
-	UINT offset = 0;
-	context->VSSetShader(_map_bounds_shader.GetVertexShader(), nullptr, 0);
-	context->PSSetShader(_map_bounds_shader.GetPixelShader(), nullptr, 0);
-	auto cameraBuffer = _cam->GetConstantBuffer();
-	context->VSSetConstantBuffers(0, 1, &cameraBuffer);
-	context->IASetVertexBuffers(0, 1, &_map_bounds_buffer, &stride, &offset);
-	context->Draw(MAP_BOUNDS_VERTEX_COUNT, 0);
+	_commands.Draw(RenderLayer::Background, _map_bounds_pipeline, RenderTopology::LineStrip, _map_bounds_vertices,
+		0, MAP_BOUNDS_VERTEX_COUNT, RENDER_NO_OBJECT);
 }
 
-void MapRenderer::DrawDynamicFeaturesBulk(std::vector<DynamicFeatureView>& draw_list, uint8_t zoom_level)
+void MapRenderer::DrawDynamicFeaturesBulk(std::vector<DynamicFeatureView>& draw_list, VertexPool& vertex_pool, uint8_t zoom_level)
 {
+	_dynamic_feature_draw_calls = 0;
 	auto context = GraphicsWindow::GetInstance()->GetContext();
-	context->IASetInputLayout(m_squareInputLayout);
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP);
-	__declspec(align(16)) ModelPerObjectBuffer object {};
-	UINT stride = sizeof(Square::Vertex);
-	UINT offset = 0;
-	context->VSSetShader(m_squareShader.GetVertexShader(), nullptr, 0);
-	context->PSSetShader(m_squareShader.GetPixelShader(), nullptr, 0);
-
-	auto cameraBuffer = _cam->GetConstantBuffer();
-	context->VSSetConstantBuffers(0, 1, &cameraBuffer);
+	if (!vertex_pool.Upload(GraphicsWindow::GetInstance()->GetDevice(), context))
+		return;
+	// The tile engine has one pool for the renderer's lifetime
+	if (_vertex_pool_vertices == RENDER_NO_BUFFER)
+		_vertex_pool_vertices = _backend.AddBuffer(vertex_pool.GetBufferAddr(), sizeof(XMFLOAT2));
 
+	// Pool vertices already include each feature's position, so one transform scales them all
 	float scale = div2(1.0f, TILE_MAX_ZOOM - zoom_level);
+	auto world_mat = XMMatrixIdentity() *
+		XMMatrixScaling(scale, 0.0f, scale) *
+		XMMatrixTranslation(MAP_ABSOLUTE_CENTER, 1.0f, MAP_ABSOLUTE_CENTER);
 
-	for (auto& entry: draw_list)
+	// The draw list is sorted by colour. Each run of one colour becomes one strip list.
+	size_t run_begin = 0;
+	while (run_begin < draw_list.size())
 	{
-		object.color = ConvertColor(entry.parent->color);
-		auto world_mat = XMMatrixIdentity() *
-			XMMatrixScaling(scale, 0.0f, scale) *
-			XMMatrixTranslation(entry.parent->position.x, 1.0f, entry.parent->position.y);
-
-		XMStoreFloat4x4(&object.world_matrix, XMMatrixTranspose(world_mat));
-
-		_UploadPerObjectBuffer(context, object);
-
-		context->VSSetConstantBuffers(1, 1, &m_perObjectBuffer);
-		context->IASetVertexBuffers(0, 1, &(entry.vertex_buffer), &stride, &offset);
-
-		context->Draw(entry.vertex_count, 0);
+		auto color = draw_list[run_begin].parent->color;
+		_strip_indices.clear();
+		auto run_end = run_begin;
+		for (; run_end < draw_list.size() && draw_list[run_end].parent->color == color; ++run_end)
+		{
+			vertex_pool.AppendStripIndices(_strip_indices, draw_list[run_end].allocation);
+		}
+		run_begin = run_end;
+		if (_strip_indices.empty())
+			continue;
+
+		auto count = static_cast<uint32_t>(_strip_indices.size());
+		auto first = _commands.AppendTransient(RENDER_TRANSIENT_INDICES, _strip_indices.data(), count, sizeof(uint32_t));
+		_commands.DrawIndexed(RenderLayer::DynamicFeatures, _square_pipeline, RenderTopology::LineStrip, _vertex_pool_vertices,
+			RENDER_TRANSIENT_INDICES, first, count, _commands.AddObject(world_mat, color));
+		_dynamic_feature_draw_calls++;
 	}
 }
 
 void MapRenderer::DrawStaticFeaturesBulk(StaticFeature* features, size_t features_count)
 {
-	auto context = GraphicsWindow::GetInstance()->GetContext();
-	context->IASetInputLayout(_static_feature_input_layout);
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	UINT stride = sizeof(Cube::Vertex);
-	UINT offset = 0;
-	context->VSSetShader(_static_feature_shader.GetVertexShader(), nullptr, 0);
-	context->PSSetShader(_static_feature_shader.GetPixelShader(), nullptr, 0);
-	auto cameraBuffer = _cam->GetConstantBuffer();
-	context->VSSetConstantBuffers(0, 1, &cameraBuffer);
-	context->PSSetConstantBuffers(0, 1, &cameraBuffer);
-
-	auto samplerState = GraphicsWindow::GetInstance()->GetStandardSamplerState();
-	context->PSSetSamplers(0, 1, &samplerState);
-
-	 auto& cube = _models_manager.GetCube();
-	context->IASetVertexBuffers(0, 1, cube.GetVertexBufferAddr(), &stride, &offset);
-	context->IASetIndexBuffer(cube.GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
-
-	__declspec(align(16)) ModelPerObjectBuffer object;
-	for (size_t i = 0; i < features_count; ++i)
-	{
-		object.color = ConvertColor(features[i].color);
-		//TODO: Add in rotation
-		
-		auto world_mat = 
-			XMMatrixIdentity() *
-			//XMMatrixScaling(features[i].scale, 0.0f, features[i].scale) *
-			XMMatrixScaling(50.0f, 1.0f, 50.0f) *
-			XMMatrixTranslation(features[i].position.x, 1.0f, features[i].position.y);
-
-		XMStoreFloat4x4(&object.world_matrix, XMMatrixTranspose(world_mat));
-		_UploadPerObjectBuffer(context, object);
-		context->VSSetConstantBuffers(1, 1, &m_perObjectBuffer);
-		context->PSSetConstantBuffers(1, 1, &m_perObjectBuffer);
-		context->DrawIndexed(cube.GetVertexCount(), 0, 0);
-	}
-
+	// One upload of every instance replaces a constant buffer map per feature
+	_instance_packer.Pack(features, features_count);
+	if (_instance_packer.GetCount() == 0)
+		return;
+	auto count = static_cast<uint32_t>(_instance_packer.GetCount());
+	auto first = _commands.AppendTransient(RENDER_TRANSIENT_INSTANCES, _instance_packer.GetData(), count, sizeof(StaticFeatureInstance));
+
+	auto& cube = _models_manager.GetCube();
+	_commands.DrawIndexedInstanced(RenderLayer::StaticFeatures, _static_feature_pipeline, RenderTopology::TriangleList, _cube_vertices,
+		_cube_indices, cube.GetVertexCount(), RENDER_TRANSIENT_INSTANCES, first, count, RENDER_NO_OBJECT);
+}
 
-}
\ No newline at end of file
+void MapRenderer::Flush()
+{
+	_immediate.Flush();
+	_immediate_stats = _immediate.GetStats();
+	_immediate.Reset();
+	_commands.SortAndMerge();
+	_backend.SetCameraBuffer(_cam->GetConstantBuffer());
+	_backend.Execute(_commands);
+	_commands.Reset();
+}
@@ -5,6 +5,10 @@
 #include "Camera.h"
 #include "Models/Grid.h"
 #include "Models/Square.h"
+#include "InstancePacker.h"
+#include <Core/RenderCommandBuffer.h>
+#include <Core/ImmediateBatcher.h>
+#include <Core/D3D11RenderBackend.h>
 #include <TileEngine/Tile.h>
 #include <TileEngine/Models/Feature.h>
 #include <TileEngine/ModelsManager.h>
@@ -24,29 +28,49 @@ class MapRenderer
 	ID3D11InputLayout* _map_bounds_input_layout;
 	ID3D11Buffer* _map_bounds_buffer;
 
-	__declspec(align(16)) struct ModelPerObjectBuffer
-	{
-		XMFLOAT4X4 world_matrix;
-		XMFLOAT4 color;
-	};
-
-	ID3D11Buffer* m_perObjectBuffer;
-
-	void _UploadPerObjectBuffer(ID3D11DeviceContext* context, const ModelPerObjectBuffer& perObject);
+	// Line list outlining the visible tiles, replaced by SetTileBorders when they change
+	ID3D11Buffer* _tile_border_buffer;
+	uint32_t _tile_border_vertex_count;
 
 	std::shared_ptr<Camera> _cam;
 
 	Shader _static_feature_shader;
 	ID3D11InputLayout* _static_feature_input_layout;
 
-	ID3D11Buffer* _immediate_mode_buffer;
+	// Draws are recorded here and run by the backend in Flush()
+	RenderCommandBuffer _commands;
+	D3D11RenderBackend _backend;
+	PipelineID _grid_pipeline;
+	PipelineID _square_pipeline;
+	PipelineID _map_bounds_pipeline;
+	PipelineID _static_feature_pipeline;
+	BufferID _grid_vertices;
+	BufferID _square_vertices;
+	BufferID _map_bounds_vertices;
+	BufferID _tile_border_vertices;
+	BufferID _cube_vertices;
+	BufferID _cube_indices;
+	BufferID _vertex_pool_vertices;
+
+	// Points, lines, strips and triangles, one draw per topology and colour
+	ImmediateBatcher _immediate;
+	ImmediateBatcher::Stats _immediate_stats;
+
+	// Static features are drawn with one instanced call per frame
+	InstancePacker _instance_packer;
 
-	
+	// Dynamic features are line strips in the tile engine's VertexPool, joined with cut indices
+	// into one indexed draw per colour
+	std::vector<uint32_t> _strip_indices;
+	int _dynamic_feature_draw_calls;
 
 public:
 	MapRenderer(std::shared_ptr<Camera> camera);
 	~MapRenderer();
 	void DrawTile(const Tile& tile, unsigned color);
+	// Takes a line list built by TileBorders::Build and keeps it on the GPU for DrawTileBorders
+	void SetTileBorders(const std::vector<XMFLOAT2>& lines);
+	void DrawTileBorders(unsigned color);
 	void DrawGrid();
 	void DrawSquare(float x, float y, float width, float rotation, unsigned color);
 	void DrawPoints(const std::vector<XMFLOAT2>& points, unsigned color);
@@ -55,5 +79,13 @@ public:
 	void DrawTriangle(const XMFLOAT2& a, const XMFLOAT2& b, const XMFLOAT2& c, unsigned color);
 	void DrawMapBounds();
 	void DrawStaticFeaturesBulk(StaticFeature* features_ptr, size_t features_count);
-	void DrawDynamicFeaturesBulk(std::vector<DynamicFeatureView>& draw_list, uint8_t zoom_level);
+	void DrawDynamicFeaturesBulk(std::vector<DynamicFeatureView>& draw_list, VertexPool& vertex_pool, uint8_t zoom_level);
+	// Draws recorded by the last DrawDynamicFeaturesBulk, one per colour in the draw list
+	int GetDynamicFeatureDrawCallCount() const { return _dynamic_feature_draw_calls; }
+	// Immediate draw calls and the batches they were drawn in, for the last flushed frame
+	const ImmediateBatcher::Stats& GetImmediateStats() const { return _immediate_stats; }
+	// Draw calls and device state binds made and skipped by the last flushed frame
+	const RenderFrameStats& GetFrameStats() const { return _backend.GetStats(); }
+	// Sorts and merges the draws recorded since the last flush and executes them
+	void Flush();
 };
@@ -20,5 +20,6 @@ public:
 
 	ID3D11Buffer*const* GetVertexBufferAddr() { return &m_vertexBuffer; }
 	ID3D11Buffer* GetIndexBuffer() const { return m_indexBuffer; }
+	ID3D11Buffer*const* GetIndexBufferAddr() const { return &m_indexBuffer; }
 	int GetVertexCount() const { return m_vertexCount; }
 };
\ No newline at end of file
@@ -22,6 +22,12 @@
 #include <TileEngine/DbInterface.h>
 #include <Game/Map.h>
 #include <Core/Db.h>
+#include <Core/RangeAllocator.h>
+#include <Core/RenderCommandBuffer.h>
+#include <Core/ImmediateBatcher.h>
+#include <Core/BoundsCuller.h>
+#include <TileEngine/LodPyramid.h>
+#include <TileEngine/TileBorders.h>
 #include "Shlwapi.h"
 #include <bitset>
 
@@ -76,6 +82,10 @@ int WINAPI MyMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine
 	{
 		DbInterface::CreateSaveGameDb(db_name, true);
 	}
+	else
+	{
+		DbInterface::UpgradeSaveGameDb(db_name);
+	}
 
 	auto map = std::make_unique<Map>(map_cam, db_name);
 	map->SetZoom(0, 0);
@@ -87,6 +97,23 @@ int WINAPI MyMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine
 	const FLOAT bg[4] = { 0.128f, 0.128f, 0.128f, 1.0f };
 	auto bg2 = ConvertColor(0x0094FFFF);
 	//RunTileTest();
+	//RunCoastlineBenchmark(MAP_WIDTH_MAX_ZOOM);
+	//RunNoiseBenchmark();
+	//RunChunkedGenerationBenchmark(MAP_WIDTH_MAX_ZOOM);
+	//RunMeshReloadBenchmark(MAP_WIDTH_MAX_ZOOM);
+	//RunCompactMeshBenchmark(MAP_WIDTH_MAX_ZOOM);
+	//RunLandGeneratorScalingBenchmark(MAP_WIDTH_MAX_ZOOM);
+	//RunOceanFloodFillBenchmark(MAP_WIDTH_MAX_ZOOM);
+	//RunDrainageBenchmark(MAP_WIDTH_MAX_ZOOM);
+	//RunInstancePackerBenchmark();
+	//RunRangeAllocatorBenchmark();
+	//RunRenderCommandBenchmark();
+	//RunObjectUploadBenchmark();
+	//RunImmediateBatcherBenchmark();
+	//RunBoundsCullingBenchmark();
+	//RunFeatureLodBenchmark();
+	//RunTileBordersBenchmark();
+	//RunCameraPickingBenchmark();
 
 	GraphicsWindow::Event windowEvent;
 	while (window->IsOpen())
@@ -0,0 +1,368 @@
+#include "ChunkedLandGenerator.h"
+#include <Core/DebugTools.h>
+#include <Core/Stopwatch.h>
+#include <Core/ParallelFor.h>
+#include <Core/Hash.h>
+#include <algorithm>
+
+namespace
+{
+	// Points stay within the middle 80% of their cell, so no two are closer than a fifth of a cell
+	const double jitter = 0.8;
+
+	int FindRoot(std::vector<int>& parent, int x)
+	{
+		while (parent[x] != x)
+		{
+			parent[x] = parent[parent[x]];
+			x = parent[x];
+		}
+		return x;
+	}
+
+	// The smaller index always becomes the root, so rebuilding a chunk gives the same roots
+	void Join(std::vector<int>& parent, int a, int b)
+	{
+		a = FindRoot(parent, a);
+		b = FindRoot(parent, b);
+		if (a != b)
+			parent[max(a, b)] = min(a, b);
+	}
+}
+
+ChunkedLandGenerator::Chunk::Chunk(std::vector<WidePoint>&& points, const WidePoint& max_bounds)
+	: mesh(std::move(points), max_bounds, 0, false)
+	, solid_regions(mesh.GetGhostIndexVerts())
+	, solid_sides(mesh.GetGhostIndexTris())
+{
+}
+
+ChunkedLandGenerator::ChunkedLandGenerator(uint32_t seed, double world_width, double spacing, int chunk_cells)
+	: _seed(seed)
+	, _world_width(world_width)
+	, _spacing(spacing)
+	, _cell_count(max(3, static_cast<int>(ceil(world_width / spacing))))
+	, _cell_width(world_width / _cell_count)
+	, _chunk_cells(max(1, chunk_cells))
+	, _chunk_count((_cell_count + _chunk_cells - 1) / _chunk_cells)
+	, _shape(seed, { world_width / 2.0, world_width / 2.0 })
+{
+}
+
+uint64_t ChunkedLandGenerator::_RegionCellID(const Chunk& chunk, int r) const
+{
+	auto width = chunk.Width();
+	return _CellID(chunk.cell_x0 + r % width, chunk.cell_y0 + r / width);
+}
+
+WidePoint ChunkedLandGenerator::_CellPoint(int x, int y) const
+{
+	auto hash = HashUint64(HashUint64(_seed) ^ _CellID(x, y));
+	auto jitter_x = HashToUnitDouble(hash) - 0.5;
+	auto jitter_y = HashToUnitDouble(HashUint64(hash)) - 0.5;
+	return { (x + 0.5 + jitter * jitter_x) * _cell_width, (y + 0.5 + jitter * jitter_y) * _cell_width };
+}
+
+bool ChunkedLandGenerator::_IsBorderCell(int x, int y) const
+{
+	return x == 0 || y == 0 || x == _cell_count - 1 || y == _cell_count - 1;
+}
+
+// The centroid is summed in cell order, so every chunk that meshes the triangle gets the same bits
+WidePoint ChunkedLandGenerator::_Centroid(const Chunk& chunk, int t) const
+{
+	int r[3] = { chunk.mesh.triangles[3 * t], chunk.mesh.triangles[3 * t + 1], chunk.mesh.triangles[3 * t + 2] };
+	std::sort(r, r + 3, [&](int i, int j) { return _RegionCellID(chunk, i) < _RegionCellID(chunk, j); });
+	auto& a = chunk.mesh.vertices[r[0]];
+	auto& b = chunk.mesh.vertices[r[1]];
+	auto& c = chunk.mesh.vertices[r[2]];
+	return { (a.x + b.x + c.x) / 3.0, (a.y + b.y + c.y) / 3.0 };
+}
+
+std::unique_ptr<ChunkedLandGenerator::Chunk> ChunkedLandGenerator::_BuildChunk(int chunk_x, int chunk_y)
+{
+	int core_x0 = chunk_x * _chunk_cells;
+	int core_y0 = chunk_y * _chunk_cells;
+	int core_x1 = min(_cell_count, core_x0 + _chunk_cells);
+	int core_y1 = min(_cell_count, core_y0 + _chunk_cells);
+	int x0 = max(0, core_x0 - CHUNK_MARGIN_CELLS);
+	int y0 = max(0, core_y0 - CHUNK_MARGIN_CELLS);
+	int x1 = min(_cell_count, core_x1 + CHUNK_MARGIN_CELLS);
+	int y1 = min(_cell_count, core_y1 + CHUNK_MARGIN_CELLS);
+
+	std::vector<WidePoint> points;
+	// One extra for the ghost region the mesh appends
+	points.reserve((x1 - x0) * (y1 - y0) + 1);
+	for (int y = y0; y < y1; y++)
+	{
+		for (int x = x0; x < x1; x++)
+			points.push_back(_CellPoint(x, y));
+	}
+
+	WidePoint max_bounds = { _world_width, _world_width };
+	auto chunk = std::make_unique<Chunk>(std::move(points), max_bounds);
+	chunk->cell_x0 = x0;
+	chunk->cell_y0 = y0;
+	chunk->cell_x1 = x1;
+	chunk->cell_y1 = y1;
+	chunk->core_x0 = core_x0;
+	chunk->core_y0 = core_y0;
+	chunk->core_x1 = core_x1;
+	chunk->core_y1 = core_y1;
+
+	auto& mesh = chunk->mesh;
+	chunk->water.resize(chunk->solid_regions);
+	ParallelFor(0, chunk->solid_regions, 4096, [&](int begin, int end)
+	{
+		_shape.ClassifyWater(&mesh.vertices[begin], end - begin, &chunk->water[begin]);
+	});
+
+	// The edge of the world is never land
+	for (int r = 0; r < chunk->solid_regions; r++)
+	{
+		if (_IsBorderCell(x0 + r % chunk->Width(), y0 + r / chunk->Width()))
+			chunk->water[r] = 1;
+	}
+
+	chunk->owned.resize(chunk->solid_sides / 3);
+	for (int t = 0; t < static_cast<int>(chunk->owned.size()); t++)
+	{
+		auto centroid = _Centroid(*chunk, t);
+		int x = max(0, min(_cell_count - 1, static_cast<int>(centroid.x / _cell_width)));
+		int y = max(0, min(_cell_count - 1, static_cast<int>(centroid.y / _cell_width)));
+		chunk->owned[t] = x >= core_x0 && x < core_x1 && y >= core_y0 && y < core_y1;
+	}
+
+	chunk->parent.resize(chunk->solid_regions);
+	for (int r = 0; r < chunk->solid_regions; r++)
+		chunk->parent[r] = r;
+	for (int s = 0; s < chunk->solid_sides; s++)
+	{
+		int r0, r1;
+		mesh.GetFlankingRegions(s, r0, r1);
+		if (r0 < r1 && chunk->owned[s_to_t(s)] && chunk->water[r0] && chunk->water[r1])
+			Join(chunk->parent, r0, r1);
+	}
+	return chunk;
+}
+
+int ChunkedLandGenerator::_FindComponent(int c)
+{
+	return FindRoot(_component_parent, c);
+}
+
+void ChunkedLandGenerator::_JoinComponents(int a, int b)
+{
+	a = _FindComponent(a);
+	b = _FindComponent(b);
+	if (a == b)
+		return;
+	if (b < a)
+		std::swap(a, b);
+	_component_parent[b] = a;
+	_component_ocean[a] |= _component_ocean[b];
+}
+
+/*
+Gives a component number to every local water component that touches the edge of the world or
+comes near the chunk's seams, and joins it with the components of other chunks that share one of
+its seam regions. A region can only be shared if it is a corner of triangles owned by both chunks,
+and such triangles are too small to reach more than CHUNK_SEAM_CELLS into either core. */
+void ChunkedLandGenerator::_LabelChunk(int chunk_x, int chunk_y, std::unordered_map<uint64_t, int>& seam_components)
+{
+	auto chunk = _BuildChunk(chunk_x, chunk_y);
+	auto& components = _chunk_components[chunk_y * _chunk_count + chunk_x];
+	std::vector<int> root_components(chunk->solid_regions, -1);
+	for (int s = 0; s < chunk->solid_sides; s++)
+	{
+		int r = chunk->mesh.triangles[s];
+		if (!chunk->owned[s_to_t(s)] || !chunk->water[r])
+			continue;
+
+		int x = chunk->cell_x0 + r % chunk->Width();
+		int y = chunk->cell_y0 + r / chunk->Width();
+		bool border = _IsBorderCell(x, y);
+		bool seam = x < chunk->core_x0 + CHUNK_SEAM_CELLS || x >= chunk->core_x1 - CHUNK_SEAM_CELLS ||
+			y < chunk->core_y0 + CHUNK_SEAM_CELLS || y >= chunk->core_y1 - CHUNK_SEAM_CELLS;
+		if (!border && !seam)
+			continue;
+
+		int root = FindRoot(chunk->parent, r);
+		if (root_components[root] < 0)
+		{
+			root_components[root] = static_cast<int>(_component_parent.size());
+			_component_parent.push_back(root_components[root]);
+			_component_ocean.push_back(0);
+			components.push_back({ root, root_components[root] });
+		}
+
+		int component = root_components[root];
+		if (border)
+			_component_ocean[_FindComponent(component)] = 1;
+		if (seam)
+		{
+			auto inserted = seam_components.emplace(_CellID(x, y), component);
+			if (!inserted.second)
+				_JoinComponents(inserted.first->second, component);
+		}
+	}
+	std::sort(components.begin(), components.end());
+}
+
+// Appends the noisy edge crossing side s, from the centroid of its triangle up to but not
+// including the centroid of the opposite one. The edge is built from whichever of s and its
+// opposite begins at the region of the lower cell, so both orientations share the same points.
+void ChunkedLandGenerator::_WriteNoisyEdge(const Chunk& chunk, int s, int lod, std::vector<WidePoint>& out) const
+{
+	auto& mesh = chunk.mesh;
+	int opposite = mesh.half_edges[s];
+	auto cell0 = _RegionCellID(chunk, mesh.triangles[s]);
+	auto cell1 = _RegionCellID(chunk, mesh.triangles[Next(s)]);
+	bool reversed = cell1 < cell0;
+	int canonical = reversed ? opposite : s;
+	auto a = _Centroid(chunk, s_to_t(canonical));
+	auto b = _Centroid(chunk, s_to_t(mesh.half_edges[canonical]));
+
+	int last = 1 << lod;
+	size_t base = out.size();
+	out.resize(base + last);
+	auto put = [&](int k, const WidePoint& point)
+	{
+		int i = reversed ? last - k : k;
+		if (i < last)
+			out[base + i] = point;
+	};
+
+	put(0, a);
+	put(last, b);
+	if (lod > 0)
+	{
+		SubdivideNoisyEdge(HashUint64(HashUint64(_seed ^ min(cell0, cell1)) + max(cell0, cell1)), lod, a, b,
+			mesh.vertices[mesh.triangles[canonical]],
+			mesh.vertices[mesh.triangles[Next(canonical)]],
+			put);
+	}
+}
+
+/*
+A coast side has ocean where it begins and land where it ends, and every coast triangle has
+exactly one. Coastlines are followed through owned triangles only: a piece starts at an owned
+coast triangle whose predecessor belongs to another chunk and ends at the centroid of the first
+triangle that is not owned, where the neighbouring chunk's piece begins. Whatever is left once
+the open pieces are traced are coastlines that close inside the chunk. */
+void ChunkedLandGenerator::_TraceChunk(int chunk_x, int chunk_y, int lod, const ChunkCallback& on_chunk)
+{
+	auto chunk = _BuildChunk(chunk_x, chunk_y);
+	auto& mesh = chunk->mesh;
+	auto& components = _chunk_components[chunk_y * _chunk_count + chunk_x];
+
+	std::vector<uint8_t> ocean_roots(chunk->solid_regions, 0);
+	for (auto& component : components)
+		ocean_roots[component.first] = _component_ocean[_FindComponent(component.second)];
+
+	std::vector<uint8_t> ocean(chunk->solid_regions, 0);
+	for (int r = 0; r < chunk->solid_regions; r++)
+		ocean[r] = chunk->water[r] && ocean_roots[FindRoot(chunk->parent, r)];
+
+	int triangle_count = static_cast<int>(chunk->owned.size());
+	std::vector<int> coast_sides(triangle_count, -1);
+	for (int s = 0; s < chunk->solid_sides; s++)
+	{
+		int r0, r1;
+		mesh.GetFlankingRegions(s, r0, r1);
+		if (chunk->owned[s_to_t(s)] && ocean[r0] && !ocean[r1])
+			coast_sides[s_to_t(s)] = s;
+	}
+
+	std::vector<uint8_t> has_predecessor(triangle_count, 0);
+	for (int t = 0; t < triangle_count; t++)
+	{
+		if (coast_sides[t] < 0)
+			continue;
+		auto next = s_to_t(mesh.half_edges[coast_sides[t]]);
+		ASSERT(next < triangle_count);
+		if (chunk->owned[next])
+			has_predecessor[next] = 1;
+	}
+
+	Polylines coastlines;
+	std::vector<uint8_t> visited(triangle_count, 0);
+	auto follow = [&](int t0)
+	{
+		std::vector<WidePoint> points;
+		int t = t0;
+		int next = t0;
+		do
+		{
+			visited[t] = 1;
+			_WriteNoisyEdge(*chunk, coast_sides[t], lod, points);
+			next = s_to_t(mesh.half_edges[coast_sides[t]]);
+			if (next == t0 || !chunk->owned[next])
+				break;
+			t = next;
+		} while (true);
+
+		points.push_back(next == t0 ? points.front() : _Centroid(*chunk, next));
+		coastlines.push_back(std::move(points));
+	};
+
+	for (int t = 0; t < triangle_count; t++)
+	{
+		if (coast_sides[t] >= 0 && !has_predecessor[t])
+			follow(t);
+	}
+	for (int t = 0; t < triangle_count; t++)
+	{
+		if (coast_sides[t] >= 0 && !visited[t])
+			follow(t);
+	}
+
+	on_chunk(chunk_x, chunk_y, coastlines);
+}
+
+void ChunkedLandGenerator::Generate(int noisy_edge_lod, const ChunkCallback& on_chunk)
+{
+	noisy_edge_lod = max(0, min(noisy_edge_lod, NOISY_EDGE_MAX_LOD));
+	_component_parent.clear();
+	_component_ocean.clear();
+	_chunk_components.assign(_chunk_count * _chunk_count, {});
+
+	Stopwatch stopwatch;
+	size_t peak_seam_regions = 0;
+	{
+		std::unordered_map<uint64_t, int> seam_components;
+		for (int chunk_y = 0; chunk_y < _chunk_count; chunk_y++)
+		{
+			for (int chunk_x = 0; chunk_x < _chunk_count; chunk_x++)
+			{
+				_LabelChunk(chunk_x, chunk_y, seam_components);
+				peak_seam_regions = max(peak_seam_regions, seam_components.size());
+			}
+
+			// Later rows only mesh cells from here down, so nothing above can be shared any more
+			auto first_live_row = static_cast<uint64_t>(max(0, (chunk_y + 1) * _chunk_cells - CHUNK_MARGIN_CELLS));
+			for (auto it = seam_components.begin(); it != seam_components.end();)
+			{
+				if (it->first / _cell_count < first_live_row)
+					it = seam_components.erase(it);
+				else
+					++it;
+			}
+		}
+	}
+	stopwatch.Lap(L"Chunked water components");
+	PRINTF(L"[CHUNKS] %d chunks, %d regions, %d seam components, at most %d seam regions held\n",
+		GetChunkCount(), GetRegionCount(), static_cast<int>(_component_parent.size()), static_cast<int>(peak_seam_regions));
+
+	for (int chunk_y = 0; chunk_y < _chunk_count; chunk_y++)
+	{
+		for (int chunk_x = 0; chunk_x < _chunk_count; chunk_x++)
+			_TraceChunk(chunk_x, chunk_y, noisy_edge_lod, on_chunk);
+	}
+	stopwatch.Lap(L"Chunked coastlines");
+}
+
+int ChunkedLandGenerator::GetNoisyEdgeLod(double world_units_per_pixel) const
+{
+	return ::GetNoisyEdgeLod(_cell_width, world_units_per_pixel);
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <Core/StdIncludes.h>
+#include "DualMesh.h"
+#include "WidePoint.h"
+#include "IslandShape.h"
+#include "NoisyEdge.h"
+#include <functional>
+#include <unordered_map>
+
+// Cells per chunk side. A chunk meshes (CHUNK_CELLS + 2 * CHUNK_MARGIN_CELLS)^2 points.
+#define CHUNK_DEFAULT_CELLS 256
+// Extra cells meshed around a chunk's core so the triangles of the core match the world's
+#define CHUNK_MARGIN_CELLS 8
+// Regions this close to the edge of a chunk's core may be shared with a neighbouring chunk
+#define CHUNK_SEAM_CELLS 6
+
+/*
+Generates the world one square chunk at a time so only one chunk's mesh is ever in memory.
+
+Points come from a jittered grid with one point per cell, each a pure function of the seed and
+the cell, so chunks that overlap see exactly the same points. Every chunk meshes its core cells
+plus a margin; away from the margin its triangles are the world's triangles. A triangle belongs
+to the chunk whose core holds its centroid and only owned triangles are used, so every coast
+edge is produced once and the pieces traced by neighbouring chunks meet at the same points.
+
+Ocean is water connected to the edge of the world, which needs connectivity across chunks, so
+Generate makes two passes. The first labels the water components of each chunk and joins the
+ones that share regions along a seam; only the seam regions of the current and previous chunk
+row are remembered. The second pass rebuilds each chunk, looks up which of its components reach
+the ocean, traces its coastlines and hands them to the caller before the chunk is freed. */
+class ChunkedLandGenerator
+{
+public:
+	typedef std::vector<std::vector<WidePoint>> Polylines;
+	// Receives the noisy coastline pieces of one chunk in world coordinates. A coastline that
+	// closes inside the chunk repeats its first point at the end; other pieces end on a seam
+	// at the first point of the matching piece from the neighbouring chunk.
+	typedef std::function<void(int chunk_x, int chunk_y, const Polylines& coastlines)> ChunkCallback;
+
+private:
+	struct Chunk
+	{
+		DualMesh mesh;
+		// Meshed cells, core plus margin, end exclusive. Region k is the point of cell
+		// (cell_x0 + k % width, cell_y0 + k / width); the ghost region comes last.
+		int cell_x0, cell_y0, cell_x1, cell_y1;
+		// Cells whose triangles this chunk owns
+		int core_x0, core_y0, core_x1, core_y1;
+		// Regions and sides before the ghost structure
+		int solid_regions;
+		int solid_sides;
+		std::vector<uint8_t> water;
+		// One byte per solid triangle
+		std::vector<uint8_t> owned;
+		// Union-find over water regions joined by the sides of owned triangles
+		std::vector<int> parent;
+
+		Chunk(std::vector<WidePoint>&& points, const WidePoint& max_bounds);
+		int Width() const { return cell_x1 - cell_x0; }
+	};
+
+	uint32_t _seed;
+	double _world_width;
+	double _spacing;
+	int _cell_count;
+	double _cell_width;
+	int _chunk_cells;
+	int _chunk_count;
+	IslandShape _shape;
+
+	// Water components that reach a seam or the edge of the world, joined across chunks
+	std::vector<int> _component_parent;
+	std::vector<uint8_t> _component_ocean;
+	// Per chunk: (local root, component) sorted by local root
+	std::vector<std::vector<std::pair<int, int>>> _chunk_components;
+
+	uint64_t _CellID(int x, int y) const { return static_cast<uint64_t>(y) * _cell_count + x; }
+	uint64_t _RegionCellID(const Chunk& chunk, int r) const;
+	WidePoint _CellPoint(int x, int y) const;
+	bool _IsBorderCell(int x, int y) const;
+	std::unique_ptr<Chunk> _BuildChunk(int chunk_x, int chunk_y);
+	WidePoint _Centroid(const Chunk& chunk, int t) const;
+	int _FindComponent(int c);
+	void _JoinComponents(int a, int b);
+	void _LabelChunk(int chunk_x, int chunk_y, std::unordered_map<uint64_t, int>& seam_components);
+	void _TraceChunk(int chunk_x, int chunk_y, int lod, const ChunkCallback& on_chunk);
+	void _WriteNoisyEdge(const Chunk& chunk, int s, int lod, std::vector<WidePoint>& out) const;
+
+public:
+	ChunkedLandGenerator(uint32_t seed, double world_width, double spacing, int chunk_cells = CHUNK_DEFAULT_CELLS);
+
+	void Generate(int noisy_edge_lod, const ChunkCallback& on_chunk);
+	int GetNoisyEdgeLod(double world_units_per_pixel) const;
+	int GetChunkCount() const { return _chunk_count * _chunk_count; }
+	int GetRegionCount() const { return _cell_count * _cell_count; }
+};
+
+void RunChunkedGenerationBenchmark(double world_width);
@@ -0,0 +1,30 @@
+#include "ChunkedLandGenerator.h"
+#include <Core/DebugTools.h>
+#include <Core/Stopwatch.h>
+#include <psapi.h>
+
+void RunChunkedGenerationBenchmark(double world_width)
+{
+	// The peak working set never goes down, so spacings run from coarse to fine and each
+	// line shows whether that spacing raised it
+	for (int divisions = 32; divisions <= 8192; divisions *= 2)
+	{
+		ChunkedLandGenerator generator(1, world_width, world_width / divisions);
+		size_t pieces = 0;
+		size_t points = 0;
+		Stopwatch stopwatch;
+		generator.Generate(generator.GetNoisyEdgeLod(1.0), [&](int, int, const ChunkedLandGenerator::Polylines& coastlines)
+		{
+			pieces += coastlines.size();
+			for (auto& coastline : coastlines)
+				points += coastline.size();
+		});
+		auto generate_ms = stopwatch.Lap(L"Chunked generation");
+
+		PROCESS_MEMORY_COUNTERS counters = {};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		PRINTF(L"spacing = width / %d, regions = %d, chunks = %d, coastline pieces = %d, points = %d, time = %.1f ms, peak working set = %.1f MB\n",
+			divisions, generator.GetRegionCount(), generator.GetChunkCount(), static_cast<int>(pieces), static_cast<int>(points),
+			generate_ms, counters.PeakWorkingSetSize / (1024.0 * 1024.0));
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <Core/StdIncludes.h>
+#include "WidePoint.h"
+
+// Half the size of a WidePoint. Meshes are always triangulated in double precision and can
+// keep their points in this form afterwards; at the scale of the whole map (2^22 units) a
+// float still resolves half a unit, which is half a pixel at max zoom.
+struct CompactPoint
+{
+	static const std::size_t size = 2;
+	typedef float value_type;
+	float x;
+	float y;
+	float& operator[](std::size_t i) { if (i == 0) return x; return y; }
+	const float& operator[](std::size_t i) const { if (i == 0) return x; return y; }
+
+	XMFLOAT2 Shrink() const { return XMFLOAT2(x, y); }
+};
+
+// Geometry is done in double precision whatever the points are stored as
+inline WidePoint Widen(const WidePoint& point) { return point; }
+inline WidePoint Widen(const CompactPoint& point) { return { point.x, point.y }; }
+
+inline void StorePoint(const WidePoint& point, WidePoint& out) { out = point; }
+inline void StorePoint(const WidePoint& point, CompactPoint& out) { out = { static_cast<float>(point.x), static_cast<float>(point.y) }; }
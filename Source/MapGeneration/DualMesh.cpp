@@ -2,24 +2,126 @@
 #include <thinks/poissondisksampling.hpp>
 #include "Triangulator.h"
 #include <Core/DebugTools.h>
+#include <Core/UniqueHandle.h>
 #include <sstream>
-#include <set>
 
+/*
+Mesh file layout, version 2. All values are little endian, as written by this machine.
 
-void DualMesh::_CheckTriangleInequality() 
+	MeshFileHeader
+	one section per MeshFileSection entry, each starting at a multiple of MESH_FILE_ALIGNMENT
+
+The sections are the raw arrays in the order of MeshSection. The adjacency sections are empty
+when the mesh was saved without adjacency. Nothing is compressed or encoded, so a loaded mesh
+points straight into the mapped file and loading costs a page fault per page actually touched. */
+#define MESH_FILE_VERSION 2
+#define MESH_FILE_ALIGNMENT 64
+
+namespace
+{
+	const char mesh_file_magic[4] = { 'D', 'M', 'S', 'H' };
+
+	enum MeshSection
+	{
+		MeshSectionVertices,
+		MeshSectionTriangles,
+		MeshSectionHalfEdges,
+		MeshSectionRegions,
+		MeshSectionRegionVertices,
+		MeshSectionRegionOffsets,
+		MeshSectionRegionSides,
+		MeshSectionRegionNeighbors,
+		MeshSectionRegionTriangles,
+		MeshSectionTriangleNeighbors,
+		MeshSectionCount
+	};
+
+	struct MeshFileSection
+	{
+		uint64_t offset;
+		// elements, not bytes
+		uint64_t count;
+	};
+
+	struct MeshFileHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t point_type;
+		uint32_t seed;
+		int32_t ghost_index_verts;
+		int32_t ghost_index_tris;
+		int32_t num_boundary_regions;
+		double max_bounds_x;
+		double max_bounds_y;
+		double point_spacing;
+		MeshFileSection sections[MeshSectionCount];
+	};
+
+	// Identifies the point type of a mesh file; a mesh only loads files of its own type
+	template<typename Point> struct MeshPointType;
+	template<> struct MeshPointType<WidePoint> { static const uint32_t value = 1; };
+	template<> struct MeshPointType<CompactPoint> { static const uint32_t value = 2; };
+
+	// Moves the double precision points a mesh is built with into its own point type
+	void StorePoints(std::vector<WidePoint>& wide, std::vector<WidePoint>& out)
+	{
+		out = std::move(wide);
+	}
+
+	template<typename Point>
+	void StorePoints(std::vector<WidePoint>& wide, std::vector<Point>& out)
+	{
+		out.resize(wide.size());
+		for (size_t i = 0; i < wide.size(); i++)
+			StorePoint(wide[i], out[i]);
+		std::vector<WidePoint>().swap(wide);
+	}
+
+	template<typename T>
+	Span<const T> MakeSpan(const std::vector<T>& v)
+	{
+		return Span<const T>(v.data(), v.size());
+	}
+
+	uint64_t AlignFileOffset(uint64_t offset)
+	{
+		return (offset + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT;
+	}
+
+	bool WriteBytes(HANDLE file, const void* data, uint64_t size)
+	{
+		auto bytes = static_cast<const char*>(data);
+		while (size > 0)
+		{
+			// WriteFile takes a 32 bit length
+			DWORD chunk = static_cast<DWORD>(min(size, static_cast<uint64_t>(1 << 30)));
+			DWORD written = 0;
+			if (!WriteFile(file, bytes, chunk, &written, nullptr) || written != chunk)
+				return false;
+			bytes += chunk;
+			size -= chunk;
+		}
+		return true;
+	}
+}
+
+
+template<typename Point>
+void BasicDualMesh<Point>::_CheckTriangleInequality() 
 {
 	// check for skinny triangles
 	auto badAngleLimit = 30;
 	auto summary = std::vector<int>(badAngleLimit, 0);
 	int count = 0;
-	for (int s = 0; s < triangles.size(); s++) 
-	{
-		auto r0 = triangles[s],
-			 r1 = triangles[Next(s)],
-			 r2 = triangles[Next(Next(s))];
-		auto p0 = vertices[r0],
-			 p1 = vertices[r1],
-			 p2 = vertices[r2];
+	for (int s = 0; s < _storage.triangles.size(); s++) 
+	{
+		auto r0 = _storage.triangles[s],
+			 r1 = _storage.triangles[Next(s)],
+			 r2 = _storage.triangles[Next(Next(s))];
+		auto p0 = _storage.wide_vertices[r0],
+			 p1 = _storage.wide_vertices[r1],
+			 p2 = _storage.wide_vertices[r2];
 		WidePoint d0 = { p0.x - p1.x, p0.y - p1.y };
 		WidePoint d2 = { p2.x - p1.x, p2.y - p1.y };
 		auto dotProduct = d0.x * d2.x + d0.y + d2.y;
@@ -48,34 +150,35 @@ void DualMesh::_CheckTriangleInequality()
 	//}
 }
 
-void DualMesh::_CheckMeshConnectivity()
+template<typename Point>
+void BasicDualMesh<Point>::_CheckMeshConnectivity()
 {
 	// 1. make sure each side's opposite is back to itself
 	// 2. make sure region-circulating starting from each side works
-	auto ghost_r = vertices.size() - 1;
+	auto ghost_r = _storage.wide_vertices.size() - 1;
 	std::vector<int> out_s;
-	for (int s0 = 0; s0 < triangles.size(); s0++) 
+	for (int s0 = 0; s0 < _storage.triangles.size(); s0++) 
 	{
-		if (half_edges[s0] == -1)
+		if (_storage.half_edges[s0] == -1)
 			continue;
-		if (half_edges[half_edges[s0]] != s0) 
+		if (_storage.half_edges[_storage.half_edges[s0]] != s0) 
 		{
-			PRINTF(L"FAIL half_edges[half_edges[%d]] != %d\n", half_edges[half_edges[s0]], s0);
+			PRINTF(L"FAIL half_edges[half_edges[%d]] != %d\n", _storage.half_edges[_storage.half_edges[s0]], s0);
 		}
 		int s = s0;
 		int count = 0;
 		do {
 			count++; 
 			out_s.push_back(s);
-			s = Next(half_edges[s]);
-			if (count > 100 && triangles[s0] != ghost_r) 
+			s = Next(_storage.half_edges[s]);
+			if (count > 100 && _storage.triangles[s0] != ghost_r) 
 			{
 				std::stringstream ss;
 				for (int i = 0; i < out_s.size(); ++i)
 					ss << out_s[i] << " ";
 
 				PRINTF(L"FAIL to circulate around region with start side = %d from region %d to %d, out_s = %S", 
-					s0, triangles[s0], triangles[Next(s0)], ss.str().c_str());
+					s0, _storage.triangles[s0], _storage.triangles[Next(s0)], ss.str().c_str());
 				break;
 			}
 
@@ -83,28 +186,29 @@ void DualMesh::_CheckMeshConnectivity()
 	}
 }
 
-void DualMesh::_AddGhostStructure()
+template<typename Point>
+void BasicDualMesh<Point>::_AddGhostStructure()
 {
-	int numSolidSides = triangles.size();
+	int numSolidSides = _storage.triangles.size();
 	_ghost_index_tris = numSolidSides;
-	int numVerts = vertices.size();
+	int numVerts = _storage.wide_vertices.size();
 	_ghost_index_verts = numVerts;
-	int numHalfEdges = half_edges.size();
+	int numHalfEdges = _storage.half_edges.size();
 	int numUnpairedSides = 0, firstUnpairedEdge = -1;
 	std::map<int, int> unpaired;
 	for (int s = 0; s < numSolidSides; s++)
 	{
-		if (half_edges[s] == -1)
+		if (_storage.half_edges[s] == -1)
 		{
 			numUnpairedSides++;
-			unpaired[triangles[s]] = s;
+			unpaired[_storage.triangles[s]] = s;
 			firstUnpairedEdge = s;
 		}
 	}
-	const int ghost_start = vertices.size();
-	vertices.push_back({ _max_bounds.x / 2.0, _max_bounds.y / 2.0 });
-	triangles.resize(numSolidSides + 3 * numUnpairedSides);
-	half_edges.resize(triangles.size());
+	const int ghost_start = _storage.wide_vertices.size();
+	_storage.wide_vertices.push_back({ _max_bounds.x / 2.0, _max_bounds.y / 2.0 });
+	_storage.triangles.resize(numSolidSides + 3 * numUnpairedSides);
+	_storage.half_edges.resize(_storage.triangles.size());
 	auto s = firstUnpairedEdge;
 	for (int i = 0;
 		i < numUnpairedSides;
@@ -113,51 +217,113 @@ void DualMesh::_AddGhostStructure()
 
 		// Construct a ghost side for s
 		int ghost_s = numSolidSides + 3 * i;
-		half_edges[s] = ghost_s;
-		half_edges[ghost_s] = s;
+		_storage.half_edges[s] = ghost_s;
+		_storage.half_edges[ghost_s] = s;
 		auto index = Next(s);
-		triangles[ghost_s] = triangles[index];
+		_storage.triangles[ghost_s] = _storage.triangles[index];
 
 		// Construct the rest of the ghost triangle
-		triangles[ghost_s + 1] = triangles[s];
-		triangles[ghost_s + 2] = ghost_start;
+		_storage.triangles[ghost_s + 1] = _storage.triangles[s];
+		_storage.triangles[ghost_s + 2] = ghost_start;
 		auto k = numSolidSides + (3 * i + 4) % (3 * numUnpairedSides);
-		half_edges[ghost_s + 2] = k;
-		half_edges[k] = ghost_s + 2;
+		_storage.half_edges[ghost_s + 2] = k;
+		_storage.half_edges[k] = ghost_s + 2;
 		auto next_s = Next(s);
 		//TODO: 76th entry should be 2. It is 68.
-		auto tri = triangles[next_s];
+		auto tri = _storage.triangles[next_s];
 		auto unpaired_half_edge = unpaired[tri];
-		s = unpaired[triangles[Next(s)]];
+		s = unpaired[_storage.triangles[Next(s)]];
 	}
 }
 
-DualMesh::DualMesh(uint32_t seed, const WidePoint& max_bounds, const double point_spacing)
+template<typename Point>
+void BasicDualMesh<Point>::_BuildAdjacency()
+{
+	const int region_count = static_cast<int>(_storage.regions.size());
+	_storage.region_offsets.assign(region_count + 1, 0);
+
+	// Every side starts exactly one region, so counting sides per region gives the row lengths
+	for (int s = 0; s < _storage.triangles.size(); s++)
+		_storage.region_offsets[_storage.triangles[s] + 1]++;
+	for (int r = 0; r < region_count; r++)
+		_storage.region_offsets[r + 1] += _storage.region_offsets[r];
+
+	_storage.region_sides.resize(_storage.triangles.size());
+	_storage.region_neighbors.resize(_storage.triangles.size());
+	_storage.region_triangles.resize(_storage.triangles.size());
+
+	// Fill each row in circulation order so the spans match the vector returning circulators
+	for (int r = 0; r < region_count; r++)
+	{
+		auto s = _storage.regions[r];
+		for (int i = _storage.region_offsets[r]; i < _storage.region_offsets[r + 1]; i++)
+		{
+			_storage.region_sides[i] = s;
+			_storage.region_neighbors[i] = _storage.triangles[Next(s)];
+			_storage.region_triangles[i] = s_to_t(s);
+			s = Next(_storage.half_edges[s]);
+		}
+	}
+
+	_storage.triangle_neighbors.resize(_storage.triangles.size());
+	for (int s = 0; s < _storage.triangles.size(); s++)
+		_storage.triangle_neighbors[s] = s_to_t(_storage.half_edges[s]);
+}
+
+template<typename Point>
+BasicDualMesh<Point>::BasicDualMesh()
+	: _max_bounds({ 0.0, 0.0 })
+	, _ghost_index_verts(0)
+	, _ghost_index_tris(0)
+	, _num_boundary_regions(0)
+	, _seed(0)
+	, _point_spacing(0.0)
+{
+}
+
+template<typename Point>
+BasicDualMesh<Point>::BasicDualMesh(uint32_t seed, const WidePoint& max_bounds, const double point_spacing, bool build_adjacency)
 	: _max_bounds(max_bounds)
+	, _seed(seed)
+	, _point_spacing(point_spacing)
 {
 	auto width = max_bounds.x;
 	const int n = ceil(width / point_spacing);
 	_num_boundary_regions = (n + 1) * 4;
-	vertices.resize(_num_boundary_regions);
+	_storage.wide_vertices.resize(_num_boundary_regions);
 	for (int i = 0; i <= n; i++)
 	{
 		auto t = (i + 0.5) / (n + 1.0);
 		auto w = width * t;
 		auto offset = pow(t - 0.5, 2);
-		vertices[4 * i] = WidePoint{ offset, w };
-		vertices[4 * i + 1] = WidePoint{ width - offset, w };
-		vertices[4 * i + 2] = WidePoint{ w, offset };
-		vertices[4 * i + 3] = WidePoint{ w, width - offset };
+		_storage.wide_vertices[4 * i] = WidePoint{ offset, w };
+		_storage.wide_vertices[4 * i + 1] = WidePoint{ width - offset, w };
+		_storage.wide_vertices[4 * i + 2] = WidePoint{ w, offset };
+		_storage.wide_vertices[4 * i + 3] = WidePoint{ w, width - offset };
 	}
 	
-	thinks::poissonDiskSampling(vertices, point_spacing, { 0.0, 0.0 }, max_bounds, 30, seed);
+	thinks::poissonDiskSampling(_storage.wide_vertices, point_spacing, { 0.0, 0.0 }, max_bounds, 30, seed);
+	_Build(build_adjacency);
+}
 
-	
+template<typename Point>
+BasicDualMesh<Point>::BasicDualMesh(std::vector<WidePoint>&& points, const WidePoint& max_bounds, int boundary_region_count, bool build_adjacency)
+	: _max_bounds(max_bounds)
+	, _num_boundary_regions(boundary_region_count)
+	, _seed(0)
+	, _point_spacing(0.0)
+{
+	_storage.wide_vertices = std::move(points);
+	_Build(build_adjacency);
+}
 
-	Triangulator triangulator(vertices);
-	triangles = triangulator.GetTriangles();
-	half_edges = triangulator.GetHalfEdges();
-	auto tri_count = triangles.size();
+template<typename Point>
+void BasicDualMesh<Point>::_Build(bool build_adjacency)
+{
+	Triangulator triangulator(_storage.wide_vertices);
+	_storage.triangles = triangulator.GetTriangles();
+	_storage.half_edges = triangulator.GetHalfEdges();
+	auto tri_count = _storage.triangles.size();
 	//PRINTF(L"VERTS\n---------------------\n");
 	//for (int i = 0; i < vertices.size(); ++i)
 	//{
@@ -181,42 +347,96 @@ DualMesh::DualMesh(uint32_t seed, const WidePoint& max_bounds, const double poin
 
 	//_CheckMeshConnectivity();
 
-	regions = std::vector<int>(vertices.size(), 0);
-	for (int s = 0; s < triangles.size(); s++) 
+	_storage.regions = std::vector<int>(_storage.wide_vertices.size(), 0);
+	for (int s = 0; s < _storage.triangles.size(); s++) 
 	{
-		if (regions[triangles[s]] == 0)
-			regions[triangles[s]] = s;
+		if (_storage.regions[_storage.triangles[s]] == 0)
+			_storage.regions[_storage.triangles[s]] = s;
 	}
 
-	region_vertices = std::vector<WidePoint>(triangles.size() / 3);
-	for (auto s = 0; s < triangles.size(); s += 3) 
+	_storage.region_vertices.resize(_storage.triangles.size() / 3);
+	for (auto s = 0; s < _storage.triangles.size(); s += 3) 
 	{
-		WidePoint a = vertices[triangles[s]];
-		WidePoint b = vertices[triangles[s + 1]];
-		WidePoint c = vertices[triangles[s + 2]];
+		WidePoint a = _storage.wide_vertices[_storage.triangles[s]];
+		WidePoint b = _storage.wide_vertices[_storage.triangles[s + 1]];
+		WidePoint c = _storage.wide_vertices[_storage.triangles[s + 2]];
 		if (s >= _ghost_index_tris) 
 		{
 			// ghost triangle center is just outside the unpaired side
 			auto dx = b.x - a.x;
 			auto dy = b.y - a.y;
-			region_vertices[s / 3] = { a.x + 0.5*(dx + dy), a.y + 0.5*(dy - dx) };
+			StorePoint({ a.x + 0.5*(dx + dy), a.y + 0.5*(dy - dx) }, _storage.region_vertices[s / 3]);
 		}
 		else 
 		{
 			// solid triangle center is at the centroid
-			region_vertices[s / 3] = { (a.x + b.x + c.x) / 3.0,
-				(a.y + b.y + c.y) / 3.0 };
+			StorePoint({ (a.x + b.x + c.x) / 3.0,
+				(a.y + b.y + c.y) / 3.0 }, _storage.region_vertices[s / 3]);
 		}
 	}
+
+	// The double precision points are released before the adjacency arrays are allocated
+	StorePoints(_storage.wide_vertices, _storage.vertices);
+	if (build_adjacency)
+		_BuildAdjacency();
+	_BindStorage();
 }
 
-bool DualMesh::IsBoundaryRegion(int region_index)
+template<typename Point>
+void BasicDualMesh<Point>::_BindStorage()
+{
+	vertices = MakeSpan(_storage.vertices);
+	triangles = MakeSpan(_storage.triangles);
+	half_edges = MakeSpan(_storage.half_edges);
+	regions = MakeSpan(_storage.regions);
+	region_vertices = MakeSpan(_storage.region_vertices);
+	_region_offsets = MakeSpan(_storage.region_offsets);
+	_region_sides = MakeSpan(_storage.region_sides);
+	_region_neighbors = MakeSpan(_storage.region_neighbors);
+	_region_triangles = MakeSpan(_storage.region_triangles);
+	_triangle_neighbors = MakeSpan(_storage.triangle_neighbors);
+}
+
+template<typename Point>
+bool BasicDualMesh<Point>::IsBoundaryRegion(int region_index)
 {
 	// easy check since we put all the boundary regions at the beginning of the vertex array
 	return region_index < _num_boundary_regions;
 }
 
-std::vector<int> DualMesh::GetRegionNeighbors(int region_index)
+template<typename Point>
+Span<const int> BasicDualMesh<Point>::GetRegionEdgeSpan(int region_index) const
+{
+	ASSERT(HasAdjacency());
+	const int begin = _region_offsets[region_index];
+	return Span<const int>(_region_sides.data + begin, _region_offsets[region_index + 1] - begin);
+}
+
+template<typename Point>
+Span<const int> BasicDualMesh<Point>::GetRegionNeighborSpan(int region_index) const
+{
+	ASSERT(HasAdjacency());
+	const int begin = _region_offsets[region_index];
+	return Span<const int>(_region_neighbors.data + begin, _region_offsets[region_index + 1] - begin);
+}
+
+template<typename Point>
+Span<const int> BasicDualMesh<Point>::GetRegionVertexSpan(int region_index) const
+{
+	ASSERT(HasAdjacency());
+	const int begin = _region_offsets[region_index];
+	return Span<const int>(_region_triangles.data + begin, _region_offsets[region_index + 1] - begin);
+}
+
+template<typename Point>
+Span<const int> BasicDualMesh<Point>::GetRegionVertexNeighborSpan(int t_index) const
+{
+	ASSERT(HasAdjacency());
+	return Span<const int>(_triangle_neighbors.data + 3 * t_index, 3);
+}
+
+template<typename Point>
+std::vector<int> BasicDualMesh<Point>::GetRegionNeighbors(int region_index)
 {
 	std::vector<int> output;
 	const int s0 = regions[region_index];
@@ -230,7 +450,8 @@ std::vector<int> DualMesh::GetRegionNeighbors(int region_index)
 	return output;
 }
 
-std::vector<int> DualMesh::GetRegionVertexNeighbors(int t_index)
+template<typename Point>
+std::vector<int> BasicDualMesh<Point>::GetRegionVertexNeighbors(int t_index)
 {
 	//t_circulate_t(out_t, t) { out_t.length = 3; for (let i = 0; i < 3; i++) { out_t[i] = this.s_outer_t(3*t+i); } return out_t; }
 	std::vector<int> output;
@@ -243,34 +464,25 @@ std::vector<int> DualMesh::GetRegionVertexNeighbors(int t_index)
 
 }
 
-void DualMesh::GetFlankingRegions(int t0, int t1, int& r1, int& r2)
+template<typename Point>
+void BasicDualMesh<Point>::GetFlankingRegions(int t0, int t1, int& r1, int& r2)
 {
-	std::set<int> t0_regions;
-	std::set<int> t1_regions;
-
-	for (int i = 0; i < 3; i++) 
-	{ 
-		t0_regions.insert(triangles[3 * t0 + i]);
-		t1_regions.insert(triangles[3 * t1 + i]);
-	}
-
-	std::vector<int> common_regions;
-	std::set_intersection(t0_regions.begin(), t0_regions.end(),
-		t1_regions.begin(), t1_regions.end(),
-		std::inserter(common_regions, common_regions.begin()));
-	if (common_regions.size() == 2)
+	// t0 and t1 share an edge when one of t0's sides has its opposite in t1.
+	// The flanking regions are then the endpoints of that side.
+	for (int s = 3 * t0; s < 3 * t0 + 3; s++)
 	{
-		r1 = common_regions[0];
-		r2 = common_regions[1];
-	}
-	else
-	{
-		r1 = -1;
-		r2 = -1;
+		if (half_edges[s] != -1 && s_to_t(half_edges[s]) == t1)
+		{
+			GetFlankingRegions(s, r1, r2);
+			return;
+		}
 	}
+	r1 = -1;
+	r2 = -1;
 }
 
-std::vector<int> DualMesh::GetRegionEdges(int region_index)
+template<typename Point>
+std::vector<int> BasicDualMesh<Point>::GetRegionEdges(int region_index)
 {
 	std::vector<int> output;
 	const int s0 = regions[region_index];
@@ -285,9 +497,10 @@ std::vector<int> DualMesh::GetRegionEdges(int region_index)
 
 }
 
-std::vector<WidePoint> DualMesh::GetRegionVertices(int region_index)
+template<typename Point>
+std::vector<Point> BasicDualMesh<Point>::GetRegionVertices(int region_index)
 {
-	std::vector<WidePoint> output;
+	std::vector<Point> output;
 	const int s0 = regions[region_index];
 	auto s = s0;
 	do 
@@ -300,7 +513,8 @@ std::vector<WidePoint> DualMesh::GetRegionVertices(int region_index)
 	
 }
 
-std::vector<int> DualMesh::GetRegionVerticesI(int region_index)
+template<typename Point>
+std::vector<int> BasicDualMesh<Point>::GetRegionVerticesI(int region_index)
 {
 	std::vector<int> output;
 	const int s0 = regions[region_index];
@@ -315,3 +529,169 @@ std::vector<int> DualMesh::GetRegionVerticesI(int region_index)
 
 }
 
+template<typename Point>
+bool BasicDualMesh<Point>::Save(const char* const filename) const
+{
+	struct Section
+	{
+		const void* data;
+		uint64_t count;
+		uint64_t element_size;
+	};
+	const Section sections[MeshSectionCount] =
+	{
+		{ vertices.data, vertices.size(), sizeof(Point) },
+		{ triangles.data, triangles.size(), sizeof(int) },
+		{ half_edges.data, half_edges.size(), sizeof(int) },
+		{ regions.data, regions.size(), sizeof(int) },
+		{ region_vertices.data, region_vertices.size(), sizeof(Point) },
+		{ _region_offsets.data, _region_offsets.size(), sizeof(int) },
+		{ _region_sides.data, _region_sides.size(), sizeof(int) },
+		{ _region_neighbors.data, _region_neighbors.size(), sizeof(int) },
+		{ _region_triangles.data, _region_triangles.size(), sizeof(int) },
+		{ _triangle_neighbors.data, _triangle_neighbors.size(), sizeof(int) },
+	};
+
+	MeshFileHeader header = {};
+	memcpy(header.magic, mesh_file_magic, sizeof(header.magic));
+	header.version = MESH_FILE_VERSION;
+	header.point_type = MeshPointType<Point>::value;
+	header.seed = _seed;
+	header.ghost_index_verts = _ghost_index_verts;
+	header.ghost_index_tris = _ghost_index_tris;
+	header.num_boundary_regions = _num_boundary_regions;
+	header.max_bounds_x = _max_bounds.x;
+	header.max_bounds_y = _max_bounds.y;
+	header.point_spacing = _point_spacing;
+	uint64_t offset = AlignFileOffset(sizeof(header));
+	for (int i = 0; i < MeshSectionCount; i++)
+	{
+		header.sections[i] = { offset, sections[i].count };
+		offset = AlignFileOffset(offset + sections[i].count * sections[i].element_size);
+	}
+
+	UniqueHandle<InvalidHandleTraits> file(CreateFileA(filename, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+	if (!file)
+	{
+		PRINTF(L"DualMesh::Save: could not create %S\n", filename);
+		return false;
+	}
+
+	const char padding[MESH_FILE_ALIGNMENT] = {};
+	bool ok = WriteBytes(file.Get(), &header, sizeof(header));
+	uint64_t written = sizeof(header);
+	for (int i = 0; i < MeshSectionCount && ok; i++)
+	{
+		ok = WriteBytes(file.Get(), padding, header.sections[i].offset - written) &&
+			WriteBytes(file.Get(), sections[i].data, sections[i].count * sections[i].element_size);
+		written = header.sections[i].offset + sections[i].count * sections[i].element_size;
+	}
+
+	if (!ok)
+		PRINTF(L"DualMesh::Save: could not write %S\n", filename);
+	return ok;
+}
+
+template<typename Point>
+std::unique_ptr<BasicDualMesh<Point>> BasicDualMesh<Point>::Load(const char* const filename)
+{
+	UniqueHandle<InvalidHandleTraits> file(CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+	if (!file)
+		return nullptr;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file.Get(), &file_size) || static_cast<uint64_t>(file_size.QuadPart) < sizeof(MeshFileHeader))
+	{
+		PRINTF(L"DualMesh::Load: %S is too small to be a mesh file\n", filename);
+		return nullptr;
+	}
+
+	// The view keeps the mapping alive, so both handles can close when this returns
+	UniqueHandle<NullHandleTraits> mapping(CreateFileMappingA(file.Get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+	if (!mapping)
+		return nullptr;
+	std::unique_ptr<const char, MapViewDeleter> view(static_cast<const char*>(MapViewOfFile(mapping.Get(), FILE_MAP_READ, 0, 0, 0)));
+	if (!view)
+		return nullptr;
+
+	// Only the layout is checked. Checking every index would touch the whole file and cost
+	// as much as the copy this format exists to avoid.
+	auto& header = *reinterpret_cast<const MeshFileHeader*>(view.get());
+	if (memcmp(header.magic, mesh_file_magic, sizeof(header.magic)) != 0 || header.version != MESH_FILE_VERSION)
+	{
+		PRINTF(L"DualMesh::Load: %S is not a version %d mesh file\n", filename, MESH_FILE_VERSION);
+		return nullptr;
+	}
+	if (header.point_type != MeshPointType<Point>::value)
+	{
+		PRINTF(L"DualMesh::Load: %S holds a different point type\n", filename);
+		return nullptr;
+	}
+
+	const uint64_t element_sizes[MeshSectionCount] =
+	{
+		sizeof(Point), sizeof(int), sizeof(int), sizeof(int), sizeof(Point),
+		sizeof(int), sizeof(int), sizeof(int), sizeof(int), sizeof(int)
+	};
+	for (int i = 0; i < MeshSectionCount; i++)
+	{
+		auto& section = header.sections[i];
+		if (section.offset % MESH_FILE_ALIGNMENT != 0 ||
+			section.offset > static_cast<uint64_t>(file_size.QuadPart) ||
+			section.count > (file_size.QuadPart - section.offset) / element_sizes[i])
+		{
+			PRINTF(L"DualMesh::Load: section %d of %S is out of bounds\n", i, filename);
+			return nullptr;
+		}
+	}
+
+	auto count = [&](MeshSection section) { return header.sections[section].count; };
+	auto side_count = count(MeshSectionTriangles);
+	bool has_adjacency = count(MeshSectionRegionOffsets) != 0;
+	if (count(MeshSectionHalfEdges) != side_count || side_count % 3 != 0 ||
+		count(MeshSectionRegionVertices) != side_count / 3 ||
+		count(MeshSectionRegions) != count(MeshSectionVertices) ||
+		(has_adjacency && (count(MeshSectionRegionOffsets) != count(MeshSectionVertices) + 1 ||
+			count(MeshSectionRegionSides) != side_count || count(MeshSectionRegionNeighbors) != side_count ||
+			count(MeshSectionRegionTriangles) != side_count || count(MeshSectionTriangleNeighbors) != side_count)))
+	{
+		PRINTF(L"DualMesh::Load: the arrays of %S do not fit together\n", filename);
+		return nullptr;
+	}
+
+	std::unique_ptr<BasicDualMesh> mesh(new BasicDualMesh());
+	mesh->_max_bounds = { header.max_bounds_x, header.max_bounds_y };
+	mesh->_ghost_index_verts = header.ghost_index_verts;
+	mesh->_ghost_index_tris = header.ghost_index_tris;
+	mesh->_num_boundary_regions = header.num_boundary_regions;
+	mesh->_seed = header.seed;
+	mesh->_point_spacing = header.point_spacing;
+
+	auto base = view.get();
+	auto ints = [&](MeshSection section)
+	{
+		return Span<const int>(reinterpret_cast<const int*>(base + header.sections[section].offset), count(section));
+	};
+	auto points = [&](MeshSection section)
+	{
+		return Span<const Point>(reinterpret_cast<const Point*>(base + header.sections[section].offset), count(section));
+	};
+	mesh->vertices = points(MeshSectionVertices);
+	mesh->triangles = ints(MeshSectionTriangles);
+	mesh->half_edges = ints(MeshSectionHalfEdges);
+	mesh->regions = ints(MeshSectionRegions);
+	mesh->region_vertices = points(MeshSectionRegionVertices);
+	if (has_adjacency)
+	{
+		mesh->_region_offsets = ints(MeshSectionRegionOffsets);
+		mesh->_region_sides = ints(MeshSectionRegionSides);
+		mesh->_region_neighbors = ints(MeshSectionRegionNeighbors);
+		mesh->_region_triangles = ints(MeshSectionRegionTriangles);
+		mesh->_triangle_neighbors = ints(MeshSectionTriangleNeighbors);
+	}
+	mesh->_view = std::move(view);
+	return mesh;
+}
+
+template class BasicDualMesh<WidePoint>;
+template class BasicDualMesh<CompactPoint>;
@@ -1,39 +1,114 @@
 #pragma once
 #include <Core/StdIncludes.h>
+#include <Core/Span.h>
+#include <Core/UniqueHandle.h>
 #include "WidePoint.h"
+#include "CompactPoint.h"
 
 static int s_to_t(int s) { return (s / 3) | 0; }
 static int Previous(int s) { return (s % 3 == 0) ? s + 2 : s - 1; }
 static int Next(int s) { return (s % 3 == 2) ? s - 2 : s + 1; }
 
-class DualMesh
+/*
+Delaunay triangulation of the region points and its dual, stored as flat half-edge arrays.
+Triangulation and every point computed while building are done in double precision; the
+points are then kept as Point, so a CompactDualMesh holds its points in half the memory. */
+template<typename Point>
+class BasicDualMesh
 {
 	void _CheckTriangleInequality();
 	void _CheckMeshConnectivity();
 	void _AddGhostStructure();
+	void _BuildAdjacency();
+	void _Build(bool build_adjacency);
+	void _BindStorage();
+	BasicDualMesh();
 	WidePoint _max_bounds;
 	int _ghost_index_verts;
 	int _ghost_index_tris;
 	int _num_boundary_regions;
+	// What the points were sampled with; zero when the caller supplied them
+	uint32_t _seed;
+	double _point_spacing;
 
+	// The arrays below and the public ones are views. A generated mesh owns what they point
+	// into here; a loaded mesh points into the mapped file and leaves this empty.
+	struct Storage
+	{
+		// Points while triangulating, moved or converted into vertices once the mesh is built
+		std::vector<WidePoint> wide_vertices;
+		std::vector<Point> vertices;
+		std::vector<int> triangles;
+		std::vector<int> half_edges;
+		std::vector<int> regions;
+		std::vector<Point> region_vertices;
+		std::vector<int> region_offsets;
+		std::vector<int> region_sides;
+		std::vector<int> region_neighbors;
+		std::vector<int> region_triangles;
+		std::vector<int> triangle_neighbors;
+	} _storage;
+	std::unique_ptr<const char, MapViewDeleter> _view;
+
+	// Compressed sparse row adjacency, built once in the constructor and read only afterwards,
+	// so the span accessors below are safe to call from any number of threads.
+	// The sides circulating region r are _region_sides[_region_offsets[r] .. _region_offsets[r + 1]).
+	Span<const int> _region_offsets;
+	Span<const int> _region_sides;
+	Span<const int> _region_neighbors;
+	Span<const int> _region_triangles;
+	Span<const int> _triangle_neighbors;
 
 public:
-	std::vector<WidePoint> vertices;
-	std::vector<int> triangles;
-	std::vector<int> half_edges;
-	std::vector<WidePoint> region_vertices;
-	std::vector<int> regions;
+	Span<const Point> vertices;
+	Span<const int> triangles;
+	Span<const int> half_edges;
+	Span<const Point> region_vertices;
+	Span<const int> regions;
 	
-	std::vector<WidePoint> GetRegionVertices(int region_index);
+	std::vector<Point> GetRegionVertices(int region_index);
 	std::vector<int> GetRegionVerticesI(int region_index);
 	std::vector<int> GetRegionEdges(int region_index);
 	void GetFlankingRegions(int t0, int t1, int& r1, int& r2);
+	// The two regions on either side of the dual edge crossing side s: r0 is where s begins, r1 where it ends
+	void GetFlankingRegions(int s, int& r0, int& r1) const { r0 = triangles[s]; r1 = triangles[Next(s)]; }
 	std::vector<int> GetRegionNeighbors(int region_index);
 	std::vector<int> GetRegionVertexNeighbors(int region_index);
+
+	// Allocation free versions of the circulators above. Only valid when HasAdjacency().
+	bool HasAdjacency() const { return !_region_offsets.empty(); }
+	Span<const int> GetRegionEdgeSpan(int region_index) const;
+	Span<const int> GetRegionNeighborSpan(int region_index) const;
+	Span<const int> GetRegionVertexSpan(int region_index) const;
+	Span<const int> GetRegionVertexNeighborSpan(int t_index) const;
+
 	int GetGhostIndexVerts() { return _ghost_index_verts; }
 	int GetGhostIndexTris() { return _ghost_index_tris; }
 	int GetRegionCount() { return vertices.size();  }
 	bool IsBoundaryRegion(int region_index);
+	// Boundary regions come first in the vertex array, so they are regions [0, count)
+	int GetBoundaryRegionCount() const { return _num_boundary_regions; }
 	WidePoint Center() { return { _max_bounds.x / 2.0, _max_bounds.y / 2.0 }; }
-	DualMesh(uint32_t seed, const WidePoint& max_bounds, const double point_spacing = 2.0);
-};
\ No newline at end of file
+	const WidePoint& GetMaxBounds() const { return _max_bounds; }
+	uint32_t GetSeed() const { return _seed; }
+	double GetPointSpacing() const { return _point_spacing; }
+	// Bytes held by the arrays, owned or mapped
+	size_t GetArrayBytes() const
+	{
+		return (vertices.size() + region_vertices.size()) * sizeof(Point) +
+			(triangles.size() + half_edges.size() + regions.size() + _region_offsets.size() + _region_sides.size() +
+			_region_neighbors.size() + _region_triangles.size() + _triangle_neighbors.size()) * sizeof(int);
+	}
+	BasicDualMesh(uint32_t seed, const WidePoint& max_bounds, const double point_spacing = 2.0, bool build_adjacency = true);
+	// Meshes caller supplied points. The first boundary_region_count of them are boundary regions.
+	BasicDualMesh(std::vector<WidePoint>&& points, const WidePoint& max_bounds, int boundary_region_count, bool build_adjacency = true);
+
+	// Writes the arrays in a versioned binary layout that Load can map without copying
+	bool Save(const char* const filename) const;
+	// Maps a file written by Save read only. The mesh reads straight from the mapping and
+	// keeps it open until destroyed. Returns null if the file is missing or malformed.
+	static std::unique_ptr<BasicDualMesh> Load(const char* const filename);
+};
+
+typedef BasicDualMesh<WidePoint> DualMesh;
+typedef BasicDualMesh<CompactPoint> CompactDualMesh;
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "IslandShape.h"
+
+namespace
+{
+	//shape: {round: 0.5, inflate: 0.4, amplitudes: [1/2, 1/4, 1/8, 1/16]},
+	const double amplitudes[] = { 0.5, 0.25, 0.125, 0.0625 };
+	const double roundness = 0.25;//0.5;
+	const double inflation = 0.4;
+
+	inline double mix(double a, double b, double t)
+	{
+		return a * (1.0 - t) + b * t;
+	}
+}
+
+IslandShape::IslandShape(uint32_t seed, const WidePoint& center)
+	: _noise(seed)
+	, _center(center)
+{
+}
+
+template<typename Point>
+void IslandShape::_ClassifyWater(const Point* points, int count, uint8_t* water) const
+{
+	// Work through the points in small structure-of-arrays batches. The falloff and the
+	// threshold test are straight line loops over the batch which the compiler can vectorise.
+	const int batch_size = 256;
+	double nx[batch_size], ny[batch_size], falloff[batch_size], n[batch_size];
+	for (int batch_begin = 0; batch_begin < count; batch_begin += batch_size)
+	{
+		const int batch_count = min(batch_size, count - batch_begin);
+		for (int i = 0; i < batch_count; i++)
+		{
+			auto& vertex = points[batch_begin + i];
+			nx[i] = (vertex.x - _center.x) / _center.x;
+			ny[i] = (vertex.y - _center.y) / _center.y;
+			auto distance = max(abs(nx[i]), abs(ny[i]));
+			falloff[i] = (1.0 - inflation) * distance * distance;
+		}
+
+		_noise.Fbm(nx, ny, n, batch_count, amplitudes, _countof(amplitudes));
+
+		for (int i = 0; i < batch_count; i++)
+			water[batch_begin + i] = mix(n[i], 0.5, roundness) - falloff[i] < 0;
+	}
+}
+
+void IslandShape::ClassifyWater(const WidePoint* points, int count, uint8_t* water) const
+{
+	_ClassifyWater(points, count, water);
+}
+
+void IslandShape::ClassifyWater(const CompactPoint* points, int count, uint8_t* water) const
+{
+	_ClassifyWater(points, count, water);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <Core/StdIncludes.h>
+#include <Core/Noise.h>
+#include "WidePoint.h"
+#include "CompactPoint.h"
+
+// Decides land and water as a pure function of position: fBm noise, flattened towards 0.5 by
+// the roundness and pushed under water towards the map's edges. Because it only depends on
+// the point, generators that see the world in pieces still agree on every point they share.
+class IslandShape
+{
+	BatchNoise _noise;
+	WidePoint _center;
+
+	template<typename Point>
+	void _ClassifyWater(const Point* points, int count, uint8_t* water) const;
+
+public:
+	IslandShape(uint32_t seed, const WidePoint& center);
+
+	// Writes 1 for points under water and 0 for land
+	void ClassifyWater(const WidePoint* points, int count, uint8_t* water) const;
+	void ClassifyWater(const CompactPoint* points, int count, uint8_t* water) const;
+};
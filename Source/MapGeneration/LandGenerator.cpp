@@ -1,8 +1,10 @@
 #include "LandGenerator.h"
 #include "Triangulator.h"
 #include <Core/DebugTools.h>
-#include <set>
-#include <stack>
+#include <Core/ParallelFor.h>
+#include <Core/TaskGraph.h>
+#include <Core/FrontierSearch.h>
+#include <algorithm>
 
 
 //TODO: New plan to trace coastlines:
@@ -76,46 +78,73 @@ namespace
 
 
 
-LandGenerator::LandGenerator(uint32_t seed, const WidePoint& max_bounds, double spacing)
-	: _seed(seed)
-	, _max_bounds(max_bounds)
-	, _mesh(seed, _max_bounds, spacing)
-	, _water_regions(_mesh.GetRegionCount(), true)
-	, _coastal_regions(_mesh.GetRegionCount(), false)
-	, _ocean_regions(_mesh.GetRegionCount(), false)
-	, _perlin(seed)
-	, _randomizer(seed)
+template<typename Point>
+BasicLandGenerator<Point>::BasicLandGenerator(uint32_t seed, const WidePoint& max_bounds, double spacing)
+	: BasicLandGenerator(BasicDualMesh<Point>(seed, max_bounds, spacing))
 {
-	//_CreateNoisyEdges();
-	_AssignWaterRegions();
-	_AssignOceanRegions();
-	_AssignCoastalRegions();
-	_StoreCoastlineVertices();
 }
 
-
-void LandGenerator::_RecursiveSubdivide(std::vector<WidePoint>& points, double length, double amplitude, const WidePoint& a, const WidePoint& b, const WidePoint& p, const WidePoint& q)
+template<typename Point>
+BasicLandGenerator<Point>::BasicLandGenerator(BasicDualMesh<Point>&& mesh)
+	: _seed(mesh.GetSeed())
+	, _max_bounds(mesh.GetMaxBounds())
+	, _spacing(mesh.GetPointSpacing())
+	, _shape(mesh.GetSeed(), { mesh.GetMaxBounds().x / 2.0, mesh.GetMaxBounds().y / 2.0 })
+	, _mesh(std::move(mesh))
+	, _water_regions(_mesh.GetRegionCount(), 1)
+	, _coastal_regions(_mesh.GetRegionCount(), 0)
+	, _ocean_regions(_mesh.GetRegionCount(), 0)
 {
-	const int divisor = 0x10000000;
-	double dx = a.x - b.x;
-	double dy = a.y - b.y;
-	if (dx*dx + dy*dy < length*length)
-	{
-		points.push_back(b);
-		return;
-	}
+	// Ocean and coastal regions both only need water; coastline vertices and drainage need ocean
+	TaskGraph pipeline;
+	auto water = pipeline.AddStage(L"_AssignWaterRegions", [this] { _AssignWaterRegions(); });
+	auto ocean = pipeline.AddStage(L"_AssignOceanRegions", [this] { _AssignOceanRegions(); }, { water });
+	pipeline.AddStage(L"_AssignCoastalRegions", [this] { _AssignCoastalRegions(); }, { water });
+	pipeline.AddStage(L"_StoreCoastlineVertices", [this] { _StoreCoastlineVertices(); }, { ocean });
+	auto elevation = pipeline.AddStage(L"_AssignElevation", [this] { _AssignElevation(); }, { ocean });
+	auto downslope = pipeline.AddStage(L"_AssignDownslopeSides", [this] { _AssignDownslopeSides(); }, { elevation });
+	pipeline.AddStage(L"_AccumulateFlow", [this] { _AccumulateFlow(); }, { downslope });
+	pipeline.Run();
+	pipeline.PrintTimings();
+}
 
-	auto ap = mixp(a, p, 0.5);
-	auto bp = mixp(b, p, 0.5);
-	auto aq = mixp(a, q, 0.5);
-	auto bq = mixp(b, q, 0.5);
 
-	auto division = 0.5 * (1 - amplitude) + _randomizer(divisor) / divisor * amplitude;
-	auto center = mixp(p, q, division);
+template<typename Point>
+int BasicLandGenerator<Point>::_NoisyEdgePointCount(int s, int lod)
+{
+	int canonical = min(s, _mesh.half_edges[s]);
+	if (_mesh.half_edges[canonical] >= _mesh.GetGhostIndexTris())
+		return 2;
+	return (1 << lod) + 1;
+}
 
-	_RecursiveSubdivide(points, length, amplitude, a, center, ap, aq);
-	_RecursiveSubdivide(points, length, amplitude, center, b, bp, bq);
-};
+// Writes every point of the noisy edge of side s except the last one, which is the
+// first point of the edge that follows it around a triangle or a coastline
+template<typename Point>
+void BasicLandGenerator<Point>::_WriteNoisyEdge(WidePoint* out, int s, int lod)
+{
+	int canonical = min(s, _mesh.half_edges[s]);
+	int last = _NoisyEdgePointCount(s, lod) - 1;
+	bool reversed = canonical != s;
+	auto put = [=](int k, const WidePoint& point)
+	{
+		int i = reversed ? last - k : k;
+		if (i < last)
+			out[i] = point;
+	};
+
+	auto a = Widen(_mesh.region_vertices[s_to_t(canonical)]);
+	auto b = Widen(_mesh.region_vertices[s_to_t(_mesh.half_edges[canonical])]);
+	put(0, a);
+	put(last, b);
+	if (last > 1)
+	{
+		SubdivideNoisyEdge(HashUint64(_seed ^ (static_cast<uint64_t>(canonical) << 32)), lod, a, b,
+			Widen(_mesh.vertices[_mesh.triangles[canonical]]),
+			Widen(_mesh.vertices[_mesh.triangles[Next(canonical)]]),
+			put);
+	}
+}
 
 
 /*
@@ -123,192 +152,330 @@ a region is ocean if it is a water region connected to the ghost region,
 which is outside the boundary of the map; this could be any seed set but
 for islands, the ghost region is a good seed  */
 
-void LandGenerator::_AssignOceanRegions()
+template<typename Point>
+void BasicLandGenerator<Point>::_AssignOceanRegions()
 {
-	std::stack<int> unchecked_regions;
-	unchecked_regions.push(_mesh.GetGhostIndexVerts());
+	const int ghost_region = _mesh.GetGhostIndexVerts();
+	_search.Run(&ghost_region, 1, _mesh.GetRegionCount(),
+		[this](int r) { return _mesh.GetRegionNeighborSpan(r); },
+		[this](int r) { return _water_regions[r] != 0; },
+		[this](int r, int) { _ocean_regions[r] = 1; });
+}
 
-	while (!unchecked_regions.empty()) 
+template<typename Point>
+void BasicLandGenerator<Point>::_StoreCoastlineVertices()
+{
+	// Sides are scanned in fixed blocks on separate threads and merged in block order, so the
+	// coastline sides come out in the same order whatever the thread count
+	const int side_count = static_cast<int>(_mesh.triangles.size());
+	const int block_size = 65536;
+	std::vector<std::vector<int>> block_sides((side_count + block_size - 1) / block_size);
+	ParallelFor(0, static_cast<int>(block_sides.size()), 1, [&](int begin, int end)
 	{
-		auto r1 = unchecked_regions.top();
-		unchecked_regions.pop();
-		auto neighbors = _mesh.GetRegionNeighbors(r1);
-		for (auto& neighbor: neighbors) 
+		for (int block = begin; block < end; block++)
 		{
-			if (IsWater(neighbor) && !IsOcean(neighbor))
+			for (int s = block * block_size; s < min(side_count, (block + 1) * block_size); s++)
 			{
-				_ocean_regions[neighbor] = true;
-				unchecked_regions.push(neighbor);
+				auto r0 = _mesh.triangles[s];
+				auto r1 = _mesh.triangles[Next(s)];
+				if (IsOcean(r0) && !IsOcean(r1))
+					block_sides[block].push_back(s);
 			}
 		}
+	});
+
+	_coastline_vertices.Resize(side_count / 3);
+	for (auto& sides : block_sides)
+	{
+		for (auto s : sides)
+		{
+			_coastline_vertices.Set(s_to_t(_mesh.half_edges[s]));
+			_coastline_sides.push_back(s);
+		}
+	}
+}
+
+/*
+Triangles are ocean when all three of their regions are, land when none are and coast when
+they have both. Coast triangles are at elevation 0 and everything else is as high (or, out to
+sea, as deep) as the number of triangles to the nearest of them. Lakes are land for now. */
+template<typename Point>
+void BasicLandGenerator<Point>::_AssignElevation()
+{
+	const int triangle_count = _mesh.GetGhostIndexTris() / 3;
+	_triangle_elevation.assign(triangle_count, 0);
+
+	std::vector<int> coast_triangles;
+	for (int t = 0; t < triangle_count; t++)
+	{
+		int ocean_count = _ocean_regions[_mesh.triangles[3 * t]] + _ocean_regions[_mesh.triangles[3 * t + 1]] +
+			_ocean_regions[_mesh.triangles[3 * t + 2]];
+		if (ocean_count == 0)
+			_triangle_elevation[t] = 1;
+		else if (ocean_count == 3)
+			_triangle_elevation[t] = -1;
+		else
+			coast_triangles.push_back(t);
 	}
+
+	// Land and sea only meet through coast triangles, so one search measures both sides
+	_search.Run(coast_triangles.data(), static_cast<int>(coast_triangles.size()), triangle_count,
+		[this](int t) { return _mesh.GetRegionVertexNeighborSpan(t); },
+		[=](int t) { return t < triangle_count; },
+		[this](int t, int level) { _triangle_elevation[t] *= level; });
 }
 
-void LandGenerator::_StoreCoastlineVertices()
+/*
+Water leaves a land triangle through the side facing its lowest neighbour. The search that
+assigned elevation reached every land triangle from a neighbour one level lower, so water
+always finds its way down to the coast. Ties go to the lowest side so the result does not
+depend on the thread count. */
+template<typename Point>
+void BasicLandGenerator<Point>::_AssignDownslopeSides()
 {
-	for (int s = 0; s < _mesh.triangles.size(); s++)
+	const int triangle_count = static_cast<int>(_triangle_elevation.size());
+	_downslope_sides.assign(triangle_count, -1);
+	ParallelFor(0, triangle_count, 4096, [&](int begin, int end)
 	{
-		auto r0 = _mesh.triangles[s];
-		auto r1 = _mesh.triangles[Next(s)];
-		auto t0 = s_to_t(_mesh.half_edges[s]);
-		if (IsOcean(r0) && !IsOcean(r1))
+		for (int t = begin; t < end; t++)
 		{
-			_coastline_vertices.push_back(t0);
+			if (_triangle_elevation[t] <= 0)
+				continue;
+
+			int lowest = -1;
+			for (int s = 3 * t; s < 3 * t + 3; s++)
+			{
+				int neighbor = s_to_t(_mesh.half_edges[s]);
+				if (neighbor < triangle_count &&
+					(lowest == -1 || _triangle_elevation[neighbor] < _triangle_elevation[s_to_t(_mesh.half_edges[lowest])]))
+				{
+					lowest = s;
+				}
+			}
+			_downslope_sides[t] = lowest;
 		}
-	}
+	});
 }
 
-double LandGenerator::_Noise(double x, double y, const std::vector<double>& amplitudes)
+/*
+Every land triangle drains into a neighbour one level lower, so sorting land triangles by falling
+elevation is a topological order of the drainage graph. Elevations are small integers and a
+counting sort produces the order in two linear passes. Each triangle then passes everything that
+drained into it on to its downslope neighbour. */
+template<typename Point>
+void BasicLandGenerator<Point>::_AccumulateFlow()
 {
-	//shape: {round: 0.5, inflate: 0.4, amplitudes: [1/2, 1/4, 1/8, 1/16]},
-	double sum = 0.0;
-	double sumOfAmplitudes = 0.0;
-	for (size_t octave = 0; octave < amplitudes.size(); octave++) 
+	const int triangle_count = static_cast<int>(_triangle_elevation.size());
+	const int max_elevation = _search.GetLevelCount();
+
+	// first[e] is where triangles of elevation e start in the order, highest elevation first
+	std::vector<int> first(max_elevation + 2, 0);
+	for (int t = 0; t < triangle_count; t++)
+	{
+		if (_triangle_elevation[t] > 0)
+			first[max_elevation - _triangle_elevation[t] + 1]++;
+	}
+	for (int i = 1; i < first.size(); i++)
+		first[i] += first[i - 1];
+
+	_drainage_order.resize(first.back());
+	for (int t = 0; t < triangle_count; t++)
 	{
-		auto frequency = 1 << octave;
-		sum += amplitudes[octave] * _perlin.octaveNoise(x * frequency, y * frequency, octave);
-		sumOfAmplitudes += amplitudes[octave];
+		if (_triangle_elevation[t] > 0)
+			_drainage_order[first[max_elevation - _triangle_elevation[t]]++] = t;
 	}
-	return sum / sumOfAmplitudes;
+
+	_triangle_flow.assign(triangle_count, 0);
+	for (int t = 0; t < triangle_count; t++)
+		_triangle_flow[t] = _triangle_elevation[t] >= 0 ? 1 : 0;
+	for (auto t : _drainage_order)
+		_triangle_flow[s_to_t(_mesh.half_edges[_downslope_sides[t]])] += _triangle_flow[t];
 }
 
-std::vector<int> LandGenerator::_FollowCoastline(int t0, std::set<int>& visited)
+template<typename Point>
+std::vector<std::vector<WidePoint>> BasicLandGenerator<Point>::GetRivers(int min_flow)
 {
-	std::vector<int> output;
-	int t = t0;
-	int last = t;
-	do
+	const int triangle_count = static_cast<int>(_triangle_elevation.size());
+	auto is_river = [&](int t) { return _triangle_elevation[t] > 0 && _triangle_flow[t] >= min_flow; };
+
+	// A river starts at a river triangle that no other river triangle drains into
+	Bitset fed(triangle_count);
+	for (int t = 0; t < triangle_count; t++)
 	{
-		output.push_back(t);
-		auto neighbors = _mesh.GetRegionVertexNeighbors(t);
-		for (auto& neighbor : neighbors)
+		if (is_river(t))
+			fed.Set(s_to_t(_mesh.half_edges[_downslope_sides[t]]));
+	}
+
+	// Tributaries stop at the first point of the river they join
+	std::vector<std::vector<WidePoint>> rivers;
+	Bitset drawn(triangle_count);
+	for (auto source : _drainage_order)
+	{
+		if (!is_river(source) || fed.Test(source))
+			continue;
+
+		rivers.emplace_back();
+		auto& river = rivers.back();
+		int t = source;
+		while (true)
 		{
-			// If neighbor vertex borders ocean and this is the first visit or we reached home
-			if (IsCoastlineVertex(neighbor) && IsCoastEdge(t, neighbor) && (visited.insert(neighbor).second || (neighbor == t0 && t0 != last)))
-			{
-				last = t;
-				t = neighbor;
+			river.push_back(Widen(_mesh.region_vertices[t]));
+			if (_triangle_elevation[t] <= 0 || drawn.TestAndSet(t))
 				break;
-			}
+			t = s_to_t(_mesh.half_edges[_downslope_sides[t]]);
 		}
+	}
+	return rivers;
+}
+
+/*
+A coast side s has ocean where it begins and land where it ends. Every triangle
+on the coast has exactly one such side, so the coastline is traced by crossing
+to the opposite side and picking the coast side of the triangle on the other side. */
+
+template<typename Point>
+int BasicLandGenerator<Point>::_NextCoastSide(int s)
+{
+	const int opposite = _mesh.half_edges[s];
+	const int t = s_to_t(opposite);
+	for (int s1 = 3 * t; s1 < 3 * t + 3; s1++)
+	{
+		if (s1 != opposite && IsOcean(_mesh.triangles[s1]) && IsCoastEdge(s1))
+			return s1;
+	}
+	ASSERT(false);
+	return s;
+}
 
-	} while (t != t0);
+template<typename Point>
+std::vector<int> BasicLandGenerator<Point>::_FollowCoastline(int s0, Bitset& visited)
+{
+	std::vector<int> output;
+	int s = s0;
+	do
+	{
+		output.push_back(s);
+		visited.Set(s_to_t(s));
+		s = _NextCoastSide(s);
+	} while (s != s0);
 
 	return output;
 }
 
-bool LandGenerator::IsCoastEdge(int t1, int t2)
+template<typename Point>
+bool BasicLandGenerator<Point>::IsCoastEdge(int s)
 {
-	int r1, r2;
-	_mesh.GetFlankingRegions(t1, t2, r1, r2);
-	if (r1 == -1) return false;
-	return (IsOcean(r1) && !IsOcean(r2)) || (IsOcean(r2) && !IsOcean(r1));
+	int r0, r1;
+	_mesh.GetFlankingRegions(s, r0, r1);
+	return IsOcean(r0) != IsOcean(r1);
 }
 
-std::vector<std::vector<int>> LandGenerator::GetCoastlines()
+template<typename Point>
+std::vector<std::vector<int>> BasicLandGenerator<Point>::GetCoastlineSides()
 {
 	std::vector<std::vector<int>> output;
-	std::set<int> visited;
-	
-	for (int j = 0; j < _coastline_vertices.size(); ++j)
+	Bitset visited(_mesh.triangles.size() / 3);
+
+	// Single pass over the coast sides; each coast triangle is visited exactly once
+	for (auto s : _coastline_sides)
 	{
-		// if it has not been visited
-		if (visited.insert(_coastline_vertices[j]).second)
-		{
-			// Follow the coastline back to the start
-			std::vector<int> coastline = _FollowCoastline(_coastline_vertices[j], visited);
-			output.push_back(coastline);
-		}
+		// if it has not been visited, follow the coastline back to the start
+		if (!visited.Test(s_to_t(s)))
+			output.push_back(_FollowCoastline(s, visited));
 	}
 
 	return output;
+}
 
+template<typename Point>
+std::vector<std::vector<int>> BasicLandGenerator<Point>::GetCoastlines()
+{
+	auto output = GetCoastlineSides();
+	for (auto& coastline : output)
+	{
+		for (auto& s : coastline)
+			s = s_to_t(s);
+	}
+	return output;
 }
 
-void LandGenerator::_AssignCoastalRegions()
+template<typename Point>
+void BasicLandGenerator<Point>::_AssignCoastalRegions()
 {
-	for (int i = 0; i < _mesh.GetRegionCount(); ++i) 
+	// A land region is coastal if any of its neighbours is water. Each region only writes its
+	// own byte, so chunks of regions can be classified on separate threads.
+	ParallelFor(0, _mesh.GetRegionCount(), 4096, [&](int begin, int end)
 	{
-		auto neighbors = _mesh.GetRegionNeighbors(i);
-		if (!IsWater(i)) 
+		for (int r = begin; r < end; r++)
 		{
-			for(auto& neighbor: neighbors)
+			if (_water_regions[r])
+				continue;
+			for (auto neighbor : _mesh.GetRegionNeighborSpan(r))
 			{
-				if (IsWater(neighbor))
+				if (_water_regions[neighbor])
 				{
-					_coastal_regions[i] = true;
+					_coastal_regions[r] = 1;
 					break;
 				}
 			}
 		}
-	}
+	});
 }
 
-std::vector<WidePoint> LandGenerator::GetNoisyEdges(int edge_index)
+/*
+The noisy edge of side s runs from the center of its triangle to the center of the
+opposite triangle, wandering inside the quad formed with the two regions' points.
+Both directions are generated from the lower numbered side so they trace the same
+curve. Ghost edges stay straight. Nothing is cached: an edge is a pure function of
+(seed, side, lod), so a caller that needs one again regenerates it or keeps its copy. */
+template<typename Point>
+std::vector<WidePoint> BasicLandGenerator<Point>::GetNoisyEdge(int s, int lod)
 {
-	return _noisy_edges[edge_index];
+	lod = max(0, min(lod, NOISY_EDGE_MAX_LOD));
+	std::vector<WidePoint> points(_NoisyEdgePointCount(s, lod));
+	_WriteNoisyEdge(points.data(), s, lod);
+	points.back() = Widen(_mesh.region_vertices[s_to_t(_mesh.half_edges[s])]);
+	return points;
 }
 
-void LandGenerator::_CreateNoisyEdges()
+// Joins the noisy edges of a closed loop of sides, as returned by GetCoastlineSides.
+// The first point is not repeated at the end. The edges are written straight into
+// the result from several threads.
+template<typename Point>
+std::vector<WidePoint> BasicLandGenerator<Point>::GetNoisyCoastline(const std::vector<int>& sides, int lod)
 {
-	auto ghost_index_tris = _mesh.GetGhostIndexTris();
-	Randomizer random_int(_seed);
-	double length = 4.0;
-	double amplitude = 0.2;
-	// numSides = triangles.size()
-	for (int s = 0; s < _mesh.triangles.size(); ++s)
-	{
-		int t0 = s_to_t(s);
-		int t1 = s_to_t(_mesh.half_edges[s]);
-		int r0 =  _mesh.triangles[s];
-		int r1 = _mesh.triangles[Next(s)];
+	lod = max(0, min(lod, NOISY_EDGE_MAX_LOD));
+	std::vector<size_t> offsets(sides.size() + 1, 0);
+	for (size_t i = 0; i < sides.size(); i++)
+		offsets[i + 1] = offsets[i] + _NoisyEdgePointCount(sides[i], lod) - 1;
 
-		if (r0 < r1) 
-		{
-			if (s >= ghost_index_tris)
-			{
-				_noisy_edges[s].push_back(_mesh.region_vertices[t1]);
-			}
-			else {
-				
-				_RecursiveSubdivide(_noisy_edges[s], length, amplitude,
-					_mesh.region_vertices[t0],
-					_mesh.region_vertices[t1],
-					_mesh.vertices[r0],
-					_mesh.vertices[r1]
-					);
-			}
-			// construct line going the other way; since the line is a
-			// half-open interval with [p1, p2, p3, ..., pn] but not
-			// p0, we want to reverse all but the last element, and
-			// then append p0
+	std::vector<WidePoint> result(offsets.back());
+	ParallelFor(0, static_cast<int>(sides.size()), 256, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			_WriteNoisyEdge(result.data() + offsets[i], sides[i], lod);
+	});
+	return result;
+}
 
-			_noisy_edges[_mesh.half_edges[s]] = std::vector<WidePoint>(_noisy_edges[s].rbegin()+1, _noisy_edges[s].rend());
-			_noisy_edges[_mesh.half_edges[s]].push_back(_mesh.region_vertices[t0]);
-		}
-	}
+template<typename Point>
+int BasicLandGenerator<Point>::GetNoisyEdgeLod(double world_units_per_pixel) const
+{
+	return ::GetNoisyEdgeLod(_spacing, world_units_per_pixel);
 }
 
-void LandGenerator::_AssignWaterRegions()
+template<typename Point>
+void BasicLandGenerator<Point>::_AssignWaterRegions()
 {
 	int ghost_index = _mesh.GetGhostIndexVerts();
-	auto center = _mesh.Center();
-	// 1/2, 1/4, 1/8, 1/16
-	std::vector<double> amplitudes { 0.5, 0.25, 0.125, 0.0625 };
-	double roundness = 0.25;//0.5;
-	double inflation = 0.4;
-
-	for (int r = 0; r < ghost_index; r++)
+	// Boundary regions are never land. They come first in the vertex array and keep the water
+	// they were initialized with, so the noise is only evaluated for the regions after them.
+	int boundary_count = min(_mesh.GetBoundaryRegionCount(), ghost_index);
+	ParallelFor(boundary_count, ghost_index, 4096, [&](int begin, int end)
 	{
-		if (!_mesh.IsBoundaryRegion(r)) 
-		{
-			auto nx = (_mesh.vertices[r].x - center.x) / center.x;
-			auto ny = (_mesh.vertices[r].y - center.y) / center.y;
-			auto distance = max(abs(nx), abs(ny));
-			auto n = _Noise(nx, ny, amplitudes);
-			n = mix(n, 0.5, roundness);
-			_water_regions[r] = n - (1.0 - inflation) * distance * distance < 0;
-		}
-	}
+		_shape.ClassifyWater(&_mesh.vertices[begin], end - begin, &_water_regions[begin]);
+	});
 }
 
+template class BasicLandGenerator<WidePoint>;
+template class BasicLandGenerator<CompactPoint>;
@@ -1,60 +1,91 @@
 #pragma once
 #include <Core/StdIncludes.h>
+#include <Core/Bitset.h>
+#include <Core/FrontierSearch.h>
 #include "DualMesh.h"
 #include "WidePoint.h"
-#include <PerlinNoise.hpp>
-#include <map>
-#include <algorithm>
-#include <set>
+#include "IslandShape.h"
+#include "NoisyEdge.h"
 
 //typedef std::vector<XMFLOAT2> Polyline;
 //typedef std::vector<Polyline> Polygon;
 
-struct Randomizer
-{
-	std::default_random_engine randomizer;
-
-	Randomizer(uint32_t seed)
-		: randomizer(seed) {}
-
-	int operator()(int n)
-	{
-		std::uniform_int_distribution<int> random_value(n);
-		return random_value(randomizer);
-	}
-};
+// Triangles that must drain through a triangle before a river is drawn through it
+#define RIVER_DEFAULT_MIN_FLOW 32
 
-class LandGenerator
+// Classifies regions and traces coastlines on a mesh of either point type. Noisy edges are
+// always computed and returned in double precision.
+template<typename Point>
+class BasicLandGenerator
 {
 	uint32_t _seed;
 	WidePoint _max_bounds;
-	siv::PerlinNoise _perlin;
-	DualMesh _mesh;
-	Randomizer _randomizer;
-	std::vector<bool> _water_regions;
-	std::vector<bool> _ocean_regions;
-	std::vector<bool> _coastal_regions;
-	std::vector<int> _coastline_vertices;
-	std::map<int, std::vector<WidePoint>> _noisy_edges;
+	double _spacing;
+	IslandShape _shape;
+	BasicDualMesh<Point> _mesh;
+	// One byte per region rather than std::vector<bool> so chunks can be written from separate threads
+	std::vector<uint8_t> _water_regions;
+	std::vector<uint8_t> _ocean_regions;
+	std::vector<uint8_t> _coastal_regions;
+	Bitset _coastline_vertices;
+	std::vector<int> _coastline_sides;
+	// Drainage runs over the solid triangles, the corners of the regions. Elevation is the number
+	// of triangles to the nearest coast triangle, counted negative out to sea.
+	std::vector<int> _triangle_elevation;
+	// Side each land triangle drains through, -1 for coast and ocean triangles
+	std::vector<int> _downslope_sides;
+	// Number of triangles draining through each triangle, itself included
+	std::vector<int> _triangle_flow;
+	// Land triangles from the highest to the lowest, an order in which every triangle comes
+	// before the one it drains into
+	std::vector<int> _drainage_order;
+	// Shared by the flood fill stages, which always run one after another
+	ParallelFrontierSearch _search;
 	void _AssignWaterRegions();
 	void _AssignCoastalRegions();
 	void _AssignOceanRegions();
-	void _CreateNoisyEdges();
 	void _StoreCoastlineVertices();
+	void _AssignElevation();
+	void _AssignDownslopeSides();
+	void _AccumulateFlow();
 	
-	double _Noise(double x, double y, const std::vector<double>& amplitudes);
-	void _RecursiveSubdivide(std::vector<WidePoint>& points, double length, double amplitude, 
-		const WidePoint& a, const WidePoint& b, const WidePoint& p, const WidePoint& q);
-	std::vector<int> _FollowCoastline(int t, std::set<int>& visited);
+	int _NoisyEdgePointCount(int s, int lod);
+	void _WriteNoisyEdge(WidePoint* out, int s, int lod);
+	int _NextCoastSide(int s);
+	std::vector<int> _FollowCoastline(int s0, Bitset& visited);
 public:
-	LandGenerator(uint32_t seed, const WidePoint& max_bounds, double spacing);
+	BasicLandGenerator(uint32_t seed, const WidePoint& max_bounds, double spacing);
+	// Classifies an existing mesh, such as one from DualMesh::Load, with the seed it was sampled with
+	explicit BasicLandGenerator(BasicDualMesh<Point>&& mesh);
 
 	std::vector<std::vector<int>> GetCoastlines();
-	std::vector<WidePoint> GetNoisyEdges(int edge_index);
-	bool IsWater(int region_index) { return _water_regions[region_index]; }
-	bool IsOcean(int region_index) { return _ocean_regions[region_index]; }
-	bool IsCoast(int region_index) { return _coastal_regions[region_index]; }
-	bool IsCoastlineVertex(int t) { return std::find(_coastline_vertices.begin(), _coastline_vertices.end(), t) != _coastline_vertices.end(); }
-	bool IsCoastEdge(int t0, int t1);
-	DualMesh& GetMesh() { return _mesh; }
+	std::vector<std::vector<int>> GetCoastlineSides();
+	std::vector<WidePoint> GetNoisyEdge(int s, int lod);
+	std::vector<WidePoint> GetNoisyCoastline(const std::vector<int>& sides, int lod);
+	int GetNoisyEdgeLod(double world_units_per_pixel) const;
+	bool IsWater(int region_index) { return _water_regions[region_index] != 0; }
+	bool IsOcean(int region_index) { return _ocean_regions[region_index] != 0; }
+	bool IsCoast(int region_index) { return _coastal_regions[region_index] != 0; }
+	bool IsCoastlineVertex(int t) { return _coastline_vertices.Test(t); }
+	bool IsCoastEdge(int s);
+	int GetElevation(int t) const { return _triangle_elevation[t]; }
+	int GetDownslopeSide(int t) const { return _downslope_sides[t]; }
+	int GetFlow(int t) const { return _triangle_flow[t]; }
+	// One polyline of triangle centers per river, from its source down to the coast or to the
+	// river it joins, through every triangle with at least min_flow triangles draining through it
+	std::vector<std::vector<WidePoint>> GetRivers(int min_flow = RIVER_DEFAULT_MIN_FLOW);
+	BasicDualMesh<Point>& GetMesh() { return _mesh; }
 };
+
+typedef BasicLandGenerator<WidePoint> LandGenerator;
+typedef BasicLandGenerator<CompactPoint> CompactLandGenerator;
+
+void RunCoastlineBenchmark(double world_width);
+void RunMeshReloadBenchmark(double world_width);
+void RunCompactMeshBenchmark(double world_width);
+// Runs the classification stages at 1, 2, 4, ... threads up to the hardware thread count
+void RunLandGeneratorScalingBenchmark(double world_width);
+// Ocean flood fill on meshes of about 100k, 1M and 10M regions
+void RunOceanFloodFillBenchmark(double world_width);
+// Elevation, drainage and river extraction on meshes of about 100k and 1M regions
+void RunDrainageBenchmark(double world_width);
@@ -0,0 +1,224 @@
+#include "LandGenerator.h"
+#include <Core/DebugTools.h>
+#include <Core/Stopwatch.h>
+#include <Core/ParallelFor.h>
+#include <Core/FrontierSearch.h>
+#include <algorithm>
+
+void RunCoastlineBenchmark(double world_width)
+{
+	// Start at the spacing used for new save games and halve it each step
+	for (int divisions = 32; divisions <= 1024; divisions *= 2)
+	{
+		Stopwatch stopwatch;
+		LandGenerator generator(1, { world_width, world_width }, world_width / divisions);
+		auto construction_ms = stopwatch.Lap(L"LandGenerator construction");
+		auto coastlines = generator.GetCoastlineSides();
+		auto coastline_ms = stopwatch.Lap(L"Coastline extraction");
+
+		size_t coast_sides = 0;
+		for (auto& coastline : coastlines)
+			coast_sides += coastline.size();
+
+		PRINTF(L"spacing = width / %d, regions = %d, coastlines = %d, coast sides = %d, construction = %.2f ms, coastlines = %.3f ms\n",
+			divisions, generator.GetMesh().GetRegionCount(), static_cast<int>(coastlines.size()), static_cast<int>(coast_sides),
+			construction_ms, coastline_ms);
+	}
+}
+
+void RunMeshReloadBenchmark(double world_width)
+{
+	// About a million regions
+	const double spacing = world_width / 1280.0;
+	const char* const filename = "Data/Benchmark.mesh";
+	const WidePoint max_bounds = { world_width, world_width };
+	Stopwatch stopwatch;
+	{
+		DualMesh generated(1, max_bounds, spacing);
+		auto generate_ms = stopwatch.Lap(L"DualMesh generation");
+		generated.Save(filename);
+		auto save_ms = stopwatch.Lap(L"DualMesh::Save");
+		auto loaded = DualMesh::Load(filename);
+		auto load_ms = stopwatch.Lap(L"DualMesh::Load");
+		ASSERT(loaded);
+
+		// The first pass over a mapped mesh pays for the page faults the load skipped
+		bool same = generated.triangles.size() == loaded->triangles.size() &&
+			generated.vertices.size() == loaded->vertices.size() &&
+			std::equal(generated.triangles.begin(), generated.triangles.end(), loaded->triangles.begin()) &&
+			std::equal(generated.half_edges.begin(), generated.half_edges.end(), loaded->half_edges.begin()) &&
+			memcmp(generated.vertices.data, loaded->vertices.data, generated.vertices.size() * sizeof(WidePoint)) == 0 &&
+			memcmp(generated.region_vertices.data, loaded->region_vertices.data, generated.region_vertices.size() * sizeof(WidePoint)) == 0;
+		auto touch_ms = stopwatch.Lap(L"First pass over the loaded mesh");
+
+		PRINTF(L"regions = %d, generate = %.1f ms, save = %.1f ms, load = %.3f ms, first pass = %.1f ms, identical = %d\n",
+			generated.GetRegionCount(), generate_ms, save_ms, load_ms, touch_ms, same ? 1 : 0);
+		ASSERT(same);
+	}
+
+	stopwatch.Lap(L"Free meshes");
+	{
+		LandGenerator generated(1, max_bounds, spacing);
+		auto generate_ms = stopwatch.Lap(L"LandGenerator from seed");
+		LandGenerator loaded(std::move(*DualMesh::Load(filename)));
+		auto load_ms = stopwatch.Lap(L"LandGenerator from mesh file");
+		PRINTF(L"LandGenerator startup: from seed = %.1f ms, from mesh file = %.1f ms\n", generate_ms, load_ms);
+	}
+	DeleteFileA(filename);
+}
+
+namespace
+{
+	template<typename Point>
+	void RunMeshPointBenchmark(const wchar_t* label, double world_width, double spacing)
+	{
+		Stopwatch stopwatch;
+		BasicDualMesh<Point> mesh(1, { world_width, world_width }, spacing);
+		auto mesh_ms = stopwatch.Lap(L"Mesh generation");
+		auto mesh_bytes = mesh.GetArrayBytes();
+		auto region_count = mesh.GetRegionCount();
+
+		BasicLandGenerator<Point> generator(std::move(mesh));
+		auto classify_ms = stopwatch.Lap(L"Classification");
+		size_t coastline_points = 0;
+		for (auto& coastline : generator.GetCoastlineSides())
+			coastline_points += generator.GetNoisyCoastline(coastline, 4).size();
+		auto coastline_ms = stopwatch.Lap(L"Coastlines");
+
+		PRINTF(L"%s points: regions = %d, mesh arrays = %.1f MB, mesh = %.0f ms, classification = %.1f ms, coastlines = %.1f ms (%d points)\n",
+			label, region_count, mesh_bytes / (1024.0 * 1024.0), mesh_ms, classify_ms, coastline_ms, static_cast<int>(coastline_points));
+	}
+}
+
+void RunCompactMeshBenchmark(double world_width)
+{
+	// About a million regions
+	const double spacing = world_width / 1280.0;
+	RunMeshPointBenchmark<WidePoint>(L"double", world_width, spacing);
+	RunMeshPointBenchmark<CompactPoint>(L"float", world_width, spacing);
+}
+
+void RunLandGeneratorScalingBenchmark(double world_width)
+{
+	// About a million regions. The mesh is generated once and reloaded for every thread count
+	// so each run classifies exactly the same regions.
+	const double spacing = world_width / 1280.0;
+	const char* const filename = "Data/Benchmark.mesh";
+	Stopwatch stopwatch;
+	{
+		DualMesh generated(1, { world_width, world_width }, spacing);
+		generated.Save(filename);
+	}
+	const double mesh_ms = stopwatch.Lap(L"DualMesh generation (serial)");
+
+	const int hardware_threads = max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	double single_thread_ms = 0.0;
+	for (int thread_count = 1; ; thread_count = min(thread_count * 2, hardware_threads))
+	{
+		SetWorkerThreadCount(thread_count);
+		auto mesh = DualMesh::Load(filename);
+		ASSERT(mesh);
+		// Every run pays the same page faults on the freshly mapped arrays
+		stopwatch.Lap(L"DualMesh::Load");
+		LandGenerator generator(std::move(*mesh));
+		auto pipeline_ms = stopwatch.Lap(L"LandGenerator pipeline");
+		if (thread_count == 1)
+			single_thread_ms = pipeline_ms;
+
+		PRINTF(L"threads = %d, regions = %d, coastlines = %d, pipeline = %.1f ms (%.2fx), with mesh generation = %.1f ms (%.2fx)\n",
+			thread_count, generator.GetMesh().GetRegionCount(), static_cast<int>(generator.GetCoastlineSides().size()), pipeline_ms,
+			single_thread_ms / pipeline_ms, mesh_ms + pipeline_ms, (mesh_ms + single_thread_ms) / (mesh_ms + pipeline_ms));
+		if (thread_count == hardware_threads)
+			break;
+	}
+	SetWorkerThreadCount(0);
+	DeleteFileA(filename);
+}
+
+void RunOceanFloodFillBenchmark(double world_width)
+{
+	// About 100k, 1M and 10M regions
+	const int divisions[] = { 400, 1280, 4000 };
+	const int hardware_threads = max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	for (auto division : divisions)
+	{
+		Stopwatch stopwatch;
+		DualMesh mesh(1, { world_width, world_width }, world_width / division);
+		stopwatch.Lap(L"DualMesh generation");
+
+		const int region_count = mesh.GetRegionCount();
+		const int ghost_region = mesh.GetGhostIndexVerts();
+		std::vector<uint8_t> water(region_count, 1);
+		IslandShape shape(1, { world_width / 2.0, world_width / 2.0 });
+		shape.ClassifyWater(mesh.vertices.data, ghost_region, water.data());
+		auto neighbors = [&](int r) { return mesh.GetRegionNeighborSpan(r); };
+		auto is_water = [&](int r) { return water[r] != 0; };
+
+		// The depth first fill this replaced
+		std::vector<uint8_t> ocean(region_count, 0);
+		std::vector<int> unchecked_regions(1, ghost_region);
+		while (!unchecked_regions.empty())
+		{
+			auto r = unchecked_regions.back();
+			unchecked_regions.pop_back();
+			for (auto neighbor : neighbors(r))
+			{
+				if (water[neighbor] && !ocean[neighbor])
+				{
+					ocean[neighbor] = 1;
+					unchecked_regions.push_back(neighbor);
+				}
+			}
+		}
+		auto dfs_ms = stopwatch.Lap(L"Serial depth first fill");
+
+		ParallelFrontierSearch search;
+		search.Run(&ghost_region, 1, region_count, neighbors, is_water, 1);
+		auto first_ms = stopwatch.Lap(L"Frontier search, 1 thread, first run");
+		search.Run(&ghost_region, 1, region_count, neighbors, is_water, 1);
+		auto single_ms = stopwatch.Lap(L"Frontier search, 1 thread, reused");
+		search.Run(&ghost_region, 1, region_count, neighbors, is_water, hardware_threads);
+		auto parallel_ms = stopwatch.Lap(L"Frontier search, all threads, reused");
+
+		bool same = true;
+		for (int r = 0; r < region_count; r++)
+			same = same && (ocean[r] != 0) == search.IsVisited(r);
+
+		PRINTF(L"regions = %d, ocean = %d, levels = %d, dfs = %.2f ms, bfs first run = %.2f ms, bfs 1 thread = %.2f ms, bfs %d threads = %.2f ms (%.2fx), same = %d\n",
+			region_count, search.GetVisitedCount(), search.GetLevelCount(), dfs_ms, first_ms, single_ms,
+			hardware_threads, parallel_ms, single_ms / parallel_ms, same ? 1 : 0);
+		ASSERT(same);
+	}
+}
+
+void RunDrainageBenchmark(double world_width)
+{
+	// About 100k and 1M regions. The stage timings are printed by the LandGenerator pipeline.
+	const int divisions[] = { 400, 1280 };
+	for (auto division : divisions)
+	{
+		Stopwatch stopwatch;
+		LandGenerator generator(1, { world_width, world_width }, world_width / division);
+		auto construction_ms = stopwatch.Lap(L"LandGenerator construction");
+		auto rivers = generator.GetRivers();
+		auto rivers_ms = stopwatch.Lap(L"GetRivers");
+
+		auto& mesh = generator.GetMesh();
+		int triangle_count = mesh.GetGhostIndexTris() / 3;
+		int highest = 0;
+		int largest_flow = 0;
+		for (int t = 0; t < triangle_count; t++)
+		{
+			highest = max(highest, generator.GetElevation(t));
+			if (generator.GetElevation(t) == 0)
+				largest_flow = max(largest_flow, generator.GetFlow(t));
+		}
+		size_t river_points = 0;
+		for (auto& river : rivers)
+			river_points += river.size();
+
+		PRINTF(L"regions = %d, triangles = %d, highest = %d, largest river mouth = %d, rivers = %d, river points = %d, construction = %.1f ms, rivers = %.2f ms\n",
+			mesh.GetRegionCount(), triangle_count, highest, largest_flow, static_cast<int>(rivers.size()),
+			static_cast<int>(river_points), construction_ms, rivers_ms);
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <Core/Hash.h>
+#include "WidePoint.h"
+
+// Noisy edges are subdivided this many times at most, giving 2^lod segments per edge
+#define NOISY_EDGE_MAX_LOD 10
+// Subdivision stops once segments would be shorter than this on screen
+#define NOISY_EDGE_MIN_SEGMENT_PIXELS 4.0
+
+/*
+Subdivides the edge from a to b exactly lod times, keeping every point inside the quad
+a, p, b, q where p and q are the points of the two regions the edge separates. Each split
+point is a function of (edge_hash, depth, index) only, so edges can be built in any order
+or in parallel, and the points of a coarser lod are a subset of the points of a finer one.
+put(k, point) receives the k-th point from a; the endpoints 0 and 2^lod are left to the caller. */
+template<typename Put>
+void SubdivideNoisyEdge(uint64_t edge_hash, int lod, const WidePoint& a, const WidePoint& b,
+	const WidePoint& p, const WidePoint& q, Put put)
+{
+	const double amplitude = 0.2;
+	auto mixp = [](const WidePoint& u, const WidePoint& v, double t)
+	{
+		return WidePoint{ u.x * (1.0 - t) + v.x * t, u.y * (1.0 - t) + v.y * t };
+	};
+
+	struct Frame
+	{
+		int depth;
+		int index;
+		WidePoint a, b, p, q;
+	};
+	// depth-first with the left child on top never holds more than lod + 1 frames
+	Frame stack[NOISY_EDGE_MAX_LOD + 1];
+	int top = 0;
+	stack[top++] = { 0, 0, a, b, p, q };
+
+	while (top > 0)
+	{
+		Frame f = stack[--top];
+		int span = 1 << (lod - f.depth);
+		auto random = HashToUnitDouble(HashUint64(edge_hash + (static_cast<uint64_t>(f.depth) << 16 | f.index)));
+		auto division = 0.5 * (1 - amplitude) + random * amplitude;
+		auto center = mixp(f.p, f.q, division);
+		put(f.index * span + span / 2, center);
+
+		if (f.depth + 1 < lod)
+		{
+			stack[top++] = { f.depth + 1, 2 * f.index + 1, center, f.b, mixp(f.b, f.p, 0.5), mixp(f.b, f.q, 0.5) };
+			stack[top++] = { f.depth + 1, 2 * f.index, f.a, center, mixp(f.a, f.p, 0.5), mixp(f.a, f.q, 0.5) };
+		}
+	}
+}
+
+// Picks the deepest subdivision of an edge about edge_length long whose segments are
+// still at least NOISY_EDGE_MIN_SEGMENT_PIXELS long when drawn at the given scale
+inline int GetNoisyEdgeLod(double edge_length, double world_units_per_pixel)
+{
+	int lod = 0;
+	double segment_length = edge_length;
+	while (lod < NOISY_EDGE_MAX_LOD && segment_length * 0.5 >= NOISY_EDGE_MIN_SEGMENT_PIXELS * world_units_per_pixel)
+	{
+		segment_length *= 0.5;
+		lod++;
+	}
+	return lod;
+}
@@ -0,0 +1,155 @@
+#include "RiverFitter.h"
+#include <algorithm>
+#include <cfloat>
+#include <set>
+
+namespace
+{
+	inline double Cross(double ax, double ay, double bx, double by)
+	{
+		return ax * by - ay * bx;
+	}
+}
+
+RiverFitter::RiverFitter(std::vector<std::vector<WidePoint>>&& rivers, double cell_width)
+	: _cell_width(cell_width)
+{
+	_rivers.reserve(rivers.size());
+	for (auto& points : rivers)
+	{
+		if (points.size() < 2)
+			continue;
+		_rivers.push_back({ std::move(points), -1, 0.0, {}, 0, {}, DBL_MAX });
+	}
+
+	for (int r = 0; r < static_cast<int>(_rivers.size()); ++r)
+	{
+		auto& points = _rivers[r].points;
+		_sources_by_y.push_back(std::make_pair(points.front().y, r));
+		for (int s = 0; s + 1 < static_cast<int>(points.size()); ++s)
+		{
+			auto& p = points[s];
+			auto& q = points[s + 1];
+			for (int y = _Cell(min(p.y, q.y)); y <= _Cell(max(p.y, q.y)); ++y)
+			{
+				for (int x = _Cell(min(p.x, q.x)); x <= _Cell(max(p.x, q.x)); ++x)
+					_segment_cells[_CellKey(x, y)].push_back(std::make_pair(r, s));
+			}
+		}
+	}
+	std::sort(_sources_by_y.begin(), _sources_by_y.end());
+}
+
+void RiverFitter::AddCoastlines(const std::vector<std::vector<WidePoint>>& coastlines)
+{
+	for (auto& coastline : coastlines)
+	{
+		for (size_t i = 0; i + 1 < coastline.size(); ++i)
+			_AddCoastSegment(coastline[i], coastline[i + 1]);
+	}
+}
+
+void RiverFitter::_AddCoastSegment(const WidePoint& a, const WidePoint& b)
+{
+	// Sources level with the segment, half open in y so a ray through a shared end point counts once
+	auto low = min(a.y, b.y);
+	auto high = max(a.y, b.y);
+	for (auto it = std::lower_bound(_sources_by_y.begin(), _sources_by_y.end(), std::make_pair(low, -1));
+		it != _sources_by_y.end() && it->first < high; ++it)
+	{
+		auto& source = _rivers[it->second].points.front();
+		auto x = a.x + (source.y - a.y) * (b.x - a.x) / (b.y - a.y);
+		if (x > source.x)
+			_rivers[it->second].source_ray_crossings++;
+	}
+
+	// Crossings with the river segments that share a grid cell with this one
+	const double ex = b.x - a.x;
+	const double ey = b.y - a.y;
+	for (int y = _Cell(low); y <= _Cell(high); ++y)
+	{
+		for (int x = _Cell(min(a.x, b.x)); x <= _Cell(max(a.x, b.x)); ++x)
+		{
+			auto cell = _segment_cells.find(_CellKey(x, y));
+			if (cell == _segment_cells.end())
+				continue;
+			for (auto& segment : cell->second)
+			{
+				auto& river = _rivers[segment.first];
+				if (river.crossing_segment >= 0 && river.crossing_segment < segment.second)
+					continue;
+				auto& p = river.points[segment.second];
+				auto& q = river.points[segment.second + 1];
+				const double dx = q.x - p.x;
+				const double dy = q.y - p.y;
+				const double denominator = Cross(dx, dy, ex, ey);
+				if (denominator == 0.0)
+					continue;
+				const double t = Cross(a.x - p.x, a.y - p.y, ex, ey) / denominator;
+				const double u = Cross(a.x - p.x, a.y - p.y, dx, dy) / denominator;
+				if (t < 0.0 || t > 1.0 || u < 0.0 || u > 1.0)
+					continue;
+				if (river.crossing_segment == segment.second && river.crossing_t <= t)
+					continue;
+				river.crossing_segment = segment.second;
+				river.crossing_t = t;
+				river.crossing_point = { p.x + dx * t, p.y + dy * t };
+			}
+		}
+	}
+
+	// The nearest point only matters for the last point of each river, and there are few rivers
+	const double length2 = ex * ex + ey * ey;
+	for (auto& river : _rivers)
+	{
+		auto& end = river.points.back();
+		double t = length2 > 0.0 ? ((end.x - a.x) * ex + (end.y - a.y) * ey) / length2 : 0.0;
+		t = max(0.0, min(1.0, t));
+		WidePoint nearest = { a.x + ex * t, a.y + ey * t };
+		double distance2 = (nearest.x - end.x) * (nearest.x - end.x) + (nearest.y - end.y) * (nearest.y - end.y);
+		if (distance2 < river.nearest_coast_distance2)
+		{
+			river.nearest_coast_distance2 = distance2;
+			river.nearest_coast_point = nearest;
+		}
+	}
+}
+
+std::vector<std::vector<WidePoint>> RiverFitter::Fit()
+{
+	std::vector<River*> kept;
+	for (auto& river : _rivers)
+	{
+		if (river.source_ray_crossings % 2 == 0)
+			continue; // the source is out at sea on this coastline
+		if (river.crossing_segment >= 0)
+		{
+			river.points.resize(river.crossing_segment + 1);
+			river.points.push_back(river.crossing_point);
+		}
+		kept.push_back(&river);
+	}
+
+	// Where a tributary ends on a point of a kept river it is a confluence, not a mouth
+	std::set<std::pair<double, double>> river_points;
+	for (auto* river : kept)
+	{
+		for (size_t i = 0; i + 1 < river->points.size(); ++i)
+			river_points.insert(std::make_pair(river->points[i].x, river->points[i].y));
+	}
+
+	std::vector<std::vector<WidePoint>> result;
+	result.reserve(kept.size());
+	for (auto* river : kept)
+	{
+		auto& end = river->points.back();
+		bool ends_at_coast = river->crossing_segment >= 0;
+		bool ends_at_confluence = river_points.count(std::make_pair(end.x, end.y)) == 1;
+		// The segment to the nearest coastline point cannot cross the coastline, or the crossing would be nearer
+		if (!ends_at_coast && !ends_at_confluence && river->nearest_coast_distance2 < DBL_MAX)
+			river->points.push_back(river->nearest_coast_point);
+		if (river->points.size() >= 2)
+			result.push_back(std::move(river->points));
+	}
+	return result;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <Core/StdIncludes.h>
+#include "WidePoint.h"
+#include <unordered_map>
+
+/*
+Fits rivers traced on one mesh to a coastline traced on another. Drainage needs the whole map at
+once, so save games take their rivers from a coarse LandGenerator over the whole map while the
+coastline comes chunk by chunk from a ChunkedLandGenerator with noisy edges, and the two coasts
+can be a few cells apart. AddCoastlines takes each chunk's coastline pieces as they are traced, so
+the coastline is never held whole. Fit() then drops rivers whose source is at sea, cuts every
+river where it first meets the coastline and runs a river that still ends inland on to the
+nearest point of the coastline, so every mouth lies on the coastline that is stored. A river
+that ends where it joins another one keeps its end. */
+class RiverFitter
+{
+	struct River
+	{
+		std::vector<WidePoint> points;
+		// First meeting with the coastline, ordered by river segment and then by distance along
+		// it. crossing_segment is -1 until one is found.
+		int crossing_segment;
+		double crossing_t;
+		WidePoint crossing_point;
+		// Coastline segments crossed by a ray from the source towards +x; odd for a source on land
+		int source_ray_crossings;
+		// Closest coastline point to the last point, used when the river never reaches the coast
+		WidePoint nearest_coast_point;
+		double nearest_coast_distance2;
+	};
+	std::vector<River> _rivers;
+	double _cell_width;
+	// (river, segment) pairs by the grid cells their bounding boxes overlap
+	std::unordered_map<uint64_t, std::vector<std::pair<int, int>>> _segment_cells;
+	// (source y, river) sorted by y, so a coastline segment only visits the sources level with it
+	std::vector<std::pair<double, int>> _sources_by_y;
+
+	uint64_t _CellKey(int x, int y) const { return (static_cast<uint64_t>(static_cast<uint32_t>(y)) << 32) | static_cast<uint32_t>(x); }
+	int _Cell(double coordinate) const { return static_cast<int>(floor(coordinate / _cell_width)); }
+	void _AddCoastSegment(const WidePoint& a, const WidePoint& b);
+
+public:
+	// cell_width sizes the grid the river segments are indexed in; the river mesh spacing suits it
+	RiverFitter(std::vector<std::vector<WidePoint>>&& rivers, double cell_width);
+
+	void AddCoastlines(const std::vector<std::vector<WidePoint>>& coastlines);
+	std::vector<std::vector<WidePoint>> Fit();
+};
@@ -1,8 +1,33 @@
 #include "DbInterface.h"
+#include <MapGeneration/ChunkedLandGenerator.h>
 #include <MapGeneration/LandGenerator.h>
+#include <MapGeneration/RiverFitter.h>
+#include <Core/Stopwatch.h>
+#include "LodPyramid.h"
+#include "TileClipper.h"
 //https://blog.mapbox.com/rendering-big-geodata-on-the-fly-with-geojson-vt-4e4d2a5dd1f2
+
+// Coastline levels are clipped to the tiles of their coarsest zoom, but no finer than this.
+// Finer tiles would multiply the row count while a viewport at max zoom only touches a few
+// tiles of this size anyway.
+#define COASTLINE_CLIP_ZOOM_MAX 8
+
+// Point spacing of the whole map mesh rivers are traced on, about 65k regions. Rivers follow
+// triangle centers, so this sets how fine they are before the LOD pyramid simplifies them.
+#define RIVER_MESH_SPACING (MAP_WIDTH_MAX_ZOOM / 256.0)
+
+// Stored in PRAGMA user_version, which is 0 in save games created before it was set.
+// Version 1 added the MinZoom and MaxZoom columns.
+#define SAVE_GAME_SCHEMA_VERSION 1
+
 namespace
 {
+	void _SetSchemaVersion(Db::Connection& connection, int version)
+	{
+		// Pragmas take no bound parameters
+		connection.Execute(("PRAGMA user_version = " + std::to_string(version)).c_str());
+	}
+
 	void _CreateFeatureTable(Db::Connection& connection)
 	{
 		connection.Execute(
@@ -14,50 +39,163 @@ namespace
 					`PosX`		REAL NOT NULL,
 					`PosY`		REAL NOT NULL,
 					`Rot`		REAL NOT NULL,
-					`Points`	BLOB NULL)
+					`Points`	BLOB NULL,
+					`MinZoom`	INTEGER NOT NULL DEFAULT 0,
+					`MaxZoom`	INTEGER NOT NULL DEFAULT 14)
 			)
 		);
 	}
+
+	// Stores one line as a feature per distinct simplification and tile it crosses.
+	// Returns the number of features written.
+	int _PutLodPolyline(Db::Connection& connection, const std::vector<XMFLOAT2>& vertices, size_t min_points,
+		const std::string& name, FeatureType type, size_t* vertices_per_zoom)
+	{
+		int feature_count = 0;
+		for (auto& level : LodPyramid::Build(vertices, min_points))
+		{
+			for (int zoom = level.min_zoom; zoom <= level.max_zoom; ++zoom)
+				vertices_per_zoom[zoom] += level.points.size();
+
+			// A level is only loaded at zoom levels >= min_zoom, so tiles of that zoom are
+			// always on the chain from a visible tile to the root
+			auto clip_zoom = min(level.min_zoom, static_cast<uint8_t>(COASTLINE_CLIP_ZOOM_MAX));
+			for (auto& piece : TileClipper::ClipPolyline(level.points, clip_zoom))
+			{
+				// One feature per run since each is drawn as its own line strip
+				for (auto& polyline : piece.polylines)
+				{
+					Feature feature(
+						name,
+						piece.tile.GetID(), // tileid
+						type, // type
+						XMFLOAT2(0.5f, 0.5f),
+						0.0f, // rot
+						polyline,
+						level.min_zoom,
+						level.max_zoom
+					);
+					DbInterface::PutFeature(connection, feature);
+					feature_count++;
+				}
+			}
+		}
+		return feature_count;
+	}
+
+	std::vector<XMFLOAT2> _ToMapVertices(const std::vector<WidePoint>& polyline)
+	{
+		std::vector<XMFLOAT2> vertices(polyline.size());
+		for (size_t v = 0; v < polyline.size(); ++v)
+		{
+			vertices[v] = XMFLOAT2(static_cast<float>(polyline[v].x - MAP_ABSOLUTE_CENTER),
+				static_cast<float>(polyline[v].y - MAP_ABSOLUTE_CENTER));
+		}
+		return vertices;
+	}
 }
 
 void DbInterface::CreateSaveGameDb(const char* const filename, bool create_test_data)
 {
 	auto connection = Db::Connection(filename);
 	_CreateFeatureTable(connection);
+	_SetSchemaVersion(connection, SAVE_GAME_SCHEMA_VERSION);
 	if (create_test_data)
 	{
-		double max_bounds = static_cast<double>(MAP_WIDTH_MAX_ZOOM);
-		LandGenerator generator(time(NULL), { max_bounds, max_bounds }, MAP_WIDTH_MAX_ZOOM / 32.0);
-		auto& mesh = generator.GetMesh();
-		auto coastlines = generator.GetCoastlines();
-		for (int i = 0; i < coastlines.size(); ++i)
+		Stopwatch stopwatch;
+		auto seed = static_cast<uint32_t>(time(NULL));
+		ChunkedLandGenerator generator(seed, MAP_WIDTH_MAX_ZOOM, MAP_WIDTH_MAX_ZOOM / 32.0);
+
+		// Coastlines are generated with enough noisy edge detail for max zoom, then stored
+		// as one feature per distinct simplification so each zoom loads only what it can show
+		int noisy_edge_lod = generator.GetNoisyEdgeLod(LodPyramid::GetTolerance(TILE_MAX_ZOOM));
+		size_t vertices_per_zoom[TILE_MAX_ZOOM + 1] = {};
+		int feature_count = 0;
+
+		// Drainage needs the whole map at once, so rivers come from a coarser single mesh. The
+		// same seed and world size give it the same island shape, but its coast is a few chunk
+		// cells off the chunked one, so the rivers are fitted to the coastline as it is traced.
+		RiverFitter river_fitter(LandGenerator(seed, { MAP_WIDTH_MAX_ZOOM, MAP_WIDTH_MAX_ZOOM }, RIVER_MESH_SPACING).GetRivers(),
+			RIVER_MESH_SPACING);
+		stopwatch.Lap(L"River generation");
+
+		// Clipping produces thousands of rows; one transaction avoids a sync per insert
+		connection.Execute("BEGIN TRANSACTION");
+		// Each chunk's coastline pieces are written as soon as the chunk is traced, so the
+		// whole world is never in memory at once
+		generator.Generate(noisy_edge_lod, [&](int, int, const ChunkedLandGenerator::Polylines& coastlines)
 		{
-			std::vector<XMFLOAT2> vertices(coastlines[i].size() + 1);
-			for (int v = 0; v < coastlines[i].size(); ++v)
+			river_fitter.AddCoastlines(coastlines);
+			for (auto& coastline : coastlines)
 			{
-				vertices[v] = XMFLOAT2(mesh.region_vertices[coastlines[i][v]].x - MAP_ABSOLUTE_CENTER, mesh.region_vertices[coastlines[i][v]].y - MAP_ABSOLUTE_CENTER);
+				// A piece that ends on a chunk seam is still worth drawing as a single segment
+				bool closed = coastline.front().x == coastline.back().x && coastline.front().y == coastline.back().y;
+				feature_count += _PutLodPolyline(connection, _ToMapVertices(coastline), closed ? 4 : 2,
+					std::string("Island"), FeatureType::Unknown, vertices_per_zoom);
 			}
-			vertices[coastlines[i].size()] = vertices[0];
-
-			Feature feature(
-				std::string("Island"),
-				Tile(0, 0, 0).GetID(), // tileid
-				FeatureType::Unknown, // type
-				XMFLOAT2(0.5f, 0.5f),
-				0.0f, // rot
-				vertices
-			);
-			DbInterface::PutFeature(connection, feature);
+		});
+		stopwatch.Lap(L"Chunked coastline generation and LOD pyramid");
+		PRINTF(L"[LOD] %d coastline features\n", feature_count);
+
+		int river_feature_count = PutRiverFeatures(connection, river_fitter.Fit());
+		connection.Execute("COMMIT");
+		stopwatch.Lap(L"River fitting and LOD pyramid");
+		PRINTF(L"[LOD] %d river features\n", river_feature_count);
+
+		for (int zoom = TILE_MIN_ZOOM; zoom <= TILE_MAX_ZOOM; ++zoom)
+			PRINTF(L"[LOD] zoom %d: %d coastline vertices\n", zoom, static_cast<int>(vertices_per_zoom[zoom]));
+	}
+}
+
+void DbInterface::UpgradeSaveGameDb(const char* const filename)
+{
+	auto connection = Db::Connection(filename);
+	int version = 0;
+	{
+		Db::Row row;
+		Db::Statement statement(connection, "PRAGMA user_version");
+		if (statement.GetSingle(row))
+			version = row.GetInt();
+	}
+	if (version >= SAVE_GAME_SCHEMA_VERSION)
+		return;
+
+	// Version 0 had no zoom range and drew every feature at every zoom, which is what the
+	// defaults give the existing rows
+	bool has_min_zoom = false;
+	bool has_max_zoom = false;
+	{
+		auto columns = Db::Statement(connection, "PRAGMA table_info(Feature)");
+		for (auto& column : columns)
+		{
+			std::string name(column.GetString(1), column.GetStringLength(1));
+			has_min_zoom |= name == "MinZoom";
+			has_max_zoom |= name == "MaxZoom";
 		}
 	}
+	if (!has_min_zoom)
+		connection.Execute("ALTER TABLE Feature ADD COLUMN `MinZoom` INTEGER NOT NULL DEFAULT 0");
+	if (!has_max_zoom)
+		connection.Execute("ALTER TABLE Feature ADD COLUMN `MaxZoom` INTEGER NOT NULL DEFAULT 14");
+	_SetSchemaVersion(connection, SAVE_GAME_SCHEMA_VERSION);
+	PRINTF(L"Upgraded %S from schema version %d to %d\n", filename, version, SAVE_GAME_SCHEMA_VERSION);
+}
+
+int DbInterface::PutRiverFeatures(Db::Connection& conn, const std::vector<std::vector<WidePoint>>& rivers)
+{
+	size_t vertices_per_zoom[TILE_MAX_ZOOM + 1] = {};
+	int feature_count = 0;
+	for (auto& river : rivers)
+		feature_count += _PutLodPolyline(conn, _ToMapVertices(river), 2, std::string("River"), FeatureType::River, vertices_per_zoom);
+	return feature_count;
 }
 
-std::vector<FeatureID> DbInterface::GetFeatureIDs(Db::Connection& conn, TileID tile_id)
+std::vector<FeatureID> DbInterface::GetFeatureIDs(Db::Connection& conn, TileID tile_id, uint8_t zoom)
 {
 	std::vector<FeatureID> result;
 
-	auto query = SQL(SELECT [rowid] FROM Feature WHERE TileID = ?);
-	auto rows = Db::Statement(conn, query, tile_id);
+	auto query = SQL(SELECT [rowid] FROM Feature WHERE TileID = ? AND MinZoom <= ? AND MaxZoom >= ?);
+	auto rows = Db::Statement(conn, query, tile_id, static_cast<int>(zoom), static_cast<int>(zoom));
 	
 	for (auto& row : rows)
 	{
@@ -71,7 +209,7 @@ void DbInterface::PutFeature(Db::Connection& conn, Feature& feature)
 {
 	if (feature.GetID() == 0)
 	{
-		auto query = "INSERT INTO Feature(Name, TileID, Type, PosX, PosY, Rot, Points) VALUES(?, ?, ?, ?, ?, ?, ?)";
+		auto query = "INSERT INTO Feature(Name, TileID, Type, PosX, PosY, Rot, Points, MinZoom, MaxZoom) VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)";
 		Db::Statement statement(conn, query);
 		int i = 1;
 		statement.Bind(i++, feature.GetName());
@@ -90,12 +228,14 @@ void DbInterface::PutFeature(Db::Connection& conn, Feature& feature)
 		{
 			statement.Bind(i++, static_cast<const void*>(nullptr), 0);
 		}
+		statement.Bind(i++, static_cast<int>(feature.GetMinZoom()));
+		statement.Bind(i++, static_cast<int>(feature.GetMaxZoom()));
 		statement.Execute();
 		feature.SetID(conn.RowId());
 	}
 	else
 	{
-		auto query = "UPDATE Feature SET Name=?, TileID=?, Type=?, PosX=?, PosY=?, Rot=?, Points=? WHERE [rowid]=?";
+		auto query = "UPDATE Feature SET Name=?, TileID=?, Type=?, PosX=?, PosY=?, Rot=?, Points=?, MinZoom=?, MaxZoom=? WHERE [rowid]=?";
 		Db::Statement statement(conn, query);
 		int i = 1;
 		statement.Bind(i++, feature.GetName());
@@ -114,7 +254,8 @@ void DbInterface::PutFeature(Db::Connection& conn, Feature& feature)
 		{
 			statement.Bind(i++, static_cast<const void*>(nullptr), 0);
 		}
-		
+		statement.Bind(i++, static_cast<int>(feature.GetMinZoom()));
+		statement.Bind(i++, static_cast<int>(feature.GetMaxZoom()));
 		statement.Bind(i++, feature.GetID());
 		statement.Execute();
 	}
@@ -122,7 +263,7 @@ void DbInterface::PutFeature(Db::Connection& conn, Feature& feature)
 
 Feature DbInterface::GetFeature(Db::Connection& conn, FeatureID id)
 {
-	auto query = "SELECT Name, TileID, Type, PosX, PosY, Rot, Points FROM Feature WHERE [rowid] = ? LIMIT 1";
+	auto query = "SELECT Name, TileID, Type, PosX, PosY, Rot, Points, MinZoom, MaxZoom FROM Feature WHERE [rowid] = ? LIMIT 1";
 	Db::Row row;
 	Db::Statement statement(conn, query, id);
 	if (statement.GetSingle(row))
@@ -136,8 +277,11 @@ Feature DbInterface::GetFeature(Db::Connection& conn, FeatureID id)
 		auto posy = row.GetFloat(i++);
 		auto rot = row.GetFloat(i++);
 		auto points = static_cast<const XMFLOAT2*>(row.GetBlob(i));
-		auto points_size = row.GetBlobSize(i);
-		return Feature(id, std::string(name, name_length), tile_id, type, XMFLOAT2(posx, posy), rot, points, (points_size / sizeof(XMFLOAT2)));
+		auto points_size = row.GetBlobSize(i++);
+		auto min_zoom = static_cast<uint8_t>(row.GetInt(i++));
+		auto max_zoom = static_cast<uint8_t>(row.GetInt(i++));
+		return Feature(id, std::string(name, name_length), tile_id, type, XMFLOAT2(posx, posy), rot, points, (points_size / sizeof(XMFLOAT2)),
+			min_zoom, max_zoom);
 	}
 	return Feature();
 }
\ No newline at end of file
@@ -1,13 +1,20 @@
 #pragma once
 #include <Core/StdIncludes.h>
 #include <Core/Db.h>
+#include <MapGeneration/WidePoint.h>
 #include "Tile.h"
 #include "Models/Feature.h"
 
 namespace DbInterface
 {
 	void CreateSaveGameDb(const char* const filename, bool create_test_data = false);
-	std::vector<FeatureID> GetFeatureIDs(Db::Connection& conn, TileID tile_id);
+	// Brings a save game created by an older build up to the current Feature schema
+	void UpgradeSaveGameDb(const char* const filename);
+	// Stores rivers, such as those from LandGenerator::GetRivers on a map sized mesh, as
+	// River features with the same LOD levels and tile clipping as coastlines. Run it inside the
+	// caller's transaction; CreateSaveGameDb does so for the rivers of a new save game.
+	int PutRiverFeatures(Db::Connection& conn, const std::vector<std::vector<WidePoint>>& rivers);
+	std::vector<FeatureID> GetFeatureIDs(Db::Connection& conn, TileID tile_id, uint8_t zoom);
 	void PutFeature(Db::Connection& conn, Feature& feature);
 	Feature GetFeature(Db::Connection& conn, FeatureID id);
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "LodPyramid.h"
+
+namespace
+{
+	// Squared distance from p to the segment ab
+	double SegmentDistanceSquared(const XMFLOAT2& p, const XMFLOAT2& a, const XMFLOAT2& b)
+	{
+		double dx = b.x - a.x;
+		double dy = b.y - a.y;
+		double px = p.x - a.x;
+		double py = p.y - a.y;
+		double length_squared = dx * dx + dy * dy;
+		if (length_squared > 0.0)
+		{
+			double t = (px * dx + py * dy) / length_squared;
+			t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+			px -= t * dx;
+			py -= t * dy;
+		}
+		return px * px + py * py;
+	}
+
+	bool SamePoints(const std::vector<XMFLOAT2>& a, const std::vector<XMFLOAT2>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			if (a[i].x != b[i].x || a[i].y != b[i].y)
+				return false;
+		}
+		return true;
+	}
+}
+
+float LodPyramid::GetTolerance(uint8_t zoom)
+{
+	return MAP_WIDTH_MAX_ZOOM / TILE_SPAN[zoom] / TILE_PIXEL_WIDTH;
+}
+
+std::vector<XMFLOAT2> LodPyramid::Simplify(const std::vector<XMFLOAT2>& points, float tolerance)
+{
+	if (points.size() < 3)
+		return points;
+
+	double tolerance_squared = static_cast<double>(tolerance) * tolerance;
+	std::vector<uint8_t> keep(points.size(), 0);
+	keep.front() = keep.back() = 1;
+
+	// Ranges still to be split, worked through with an explicit stack so long coastlines
+	// can't overflow the call stack
+	std::vector<std::pair<size_t, size_t>> ranges;
+	ranges.emplace_back(0, points.size() - 1);
+	while (!ranges.empty())
+	{
+		auto range = ranges.back();
+		ranges.pop_back();
+
+		double farthest = 0.0;
+		size_t split = range.first;
+		for (size_t i = range.first + 1; i < range.second; i++)
+		{
+			double d = SegmentDistanceSquared(points[i], points[range.first], points[range.second]);
+			if (d > farthest)
+			{
+				farthest = d;
+				split = i;
+			}
+		}
+
+		if (farthest > tolerance_squared)
+		{
+			keep[split] = 1;
+			ranges.emplace_back(range.first, split);
+			ranges.emplace_back(split, range.second);
+		}
+	}
+
+	std::vector<XMFLOAT2> result;
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		if (keep[i])
+			result.push_back(points[i]);
+	}
+	return result;
+}
+
+std::vector<LodPyramid::Level> LodPyramid::Build(const std::vector<XMFLOAT2>& points, size_t min_points)
+{
+	std::vector<Level> levels;
+	for (int zoom = TILE_MAX_ZOOM; zoom >= TILE_MIN_ZOOM; --zoom)
+	{
+		auto z = static_cast<uint8_t>(zoom);
+		auto simplified = Simplify(points, GetTolerance(z));
+		if (simplified.size() < min_points)
+			break;
+
+		// Neighbouring zoom levels often simplify to the same shape; share one level between them
+		if (!levels.empty() && SamePoints(levels.back().points, simplified))
+			levels.back().min_zoom = z;
+		else
+			levels.push_back(Level{ z, z, std::move(simplified) });
+	}
+	return levels;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <Core/StdIncludes.h>
+#include "Tile.h"
+
+// Simplified copies of a polyline for each zoom level. Features are stored in max zoom
+// pixels, so at zoom z one screen pixel covers 2^(TILE_MAX_ZOOM - z) units and every
+// vertex closer than that to the simplified line can be dropped without a visible change.
+namespace LodPyramid
+{
+	struct Level
+	{
+		uint8_t min_zoom;
+		uint8_t max_zoom;
+		std::vector<XMFLOAT2> points;
+	};
+
+	// Size of one screen pixel at the given zoom, in feature units
+	float GetTolerance(uint8_t zoom);
+
+	// Douglas-Peucker. Keeps both end points; a closed ring keeps its closing point.
+	std::vector<XMFLOAT2> Simplify(const std::vector<XMFLOAT2>& points, float tolerance);
+
+	// One level per distinct simplification, finest first. Zoom levels at which a closed
+	// ring collapses below min_points vertices get no level, so the shape is not drawn there.
+	std::vector<Level> Build(const std::vector<XMFLOAT2>& points, size_t min_points = 4);
+}
+
+// Vertices a frame of dynamic features submits at each zoom level, drawn at full resolution and
+// with views simplified for the zoom
+void RunFeatureLodBenchmark();
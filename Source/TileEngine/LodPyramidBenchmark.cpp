@@ -0,0 +1,76 @@
+#include "LodPyramid.h"
+#include <Core/DebugTools.h>
+#include <Core/Stopwatch.h>
+#include <random>
+
+void RunFeatureLodBenchmark()
+{
+	// Rough closed coastlines of a few hundred to a few thousand max zoom pixels across,
+	// stored at full resolution and clustered around the map center. A 1920x1080 screen at the
+	// center sees more of them the further out it zooms.
+	const int feature_count = 500;
+	const int ring_points = 2048;
+	const float spread = MAP_WIDTH_MAX_ZOOM / 256.0f;
+	std::mt19937 random(11);
+	std::normal_distribution<float> position(0.0f, spread);
+	std::uniform_real_distribution<float> radius(200.0f, 4000.0f);
+	std::uniform_real_distribution<float> roughness(-1.0f, 1.0f);
+
+	struct Shape
+	{
+		XMFLOAT2 center;
+		float radius;
+		std::vector<XMFLOAT2> points;
+	};
+	std::vector<Shape> shapes(feature_count);
+	for (auto& shape : shapes)
+	{
+		shape.center = XMFLOAT2(position(random), position(random));
+		shape.radius = radius(random);
+		std::vector<float> offsets(ring_points, 0.0f);
+		// Midpoint displacement around the ring. Detail shrinks slower than the step, like a coastline.
+		float amplitude = shape.radius * 0.25f;
+		for (int step = ring_points / 2; step > 0; step /= 2, amplitude *= 0.7f)
+		{
+			for (int i = step; i < ring_points; i += step * 2)
+				offsets[i] = (offsets[i - step] + offsets[(i + step) % ring_points]) * 0.5f + roughness(random) * amplitude;
+		}
+		for (int i = 0; i < ring_points; ++i)
+		{
+			float angle = 6.2831853f * i / ring_points;
+			float r = shape.radius + offsets[i];
+			shape.points.push_back(XMFLOAT2(cosf(angle) * r, sinf(angle) * r));
+		}
+		shape.points.push_back(shape.points.front());
+	}
+
+	Stopwatch stopwatch;
+	double simplify_ms = 0.0;
+	size_t total_full = 0, total_simplified = 0;
+	for (int zoom = TILE_MIN_ZOOM; zoom <= TILE_MAX_ZOOM; ++zoom)
+	{
+		auto z = static_cast<uint8_t>(zoom);
+		// One screen pixel covers 2^(TILE_MAX_ZOOM - zoom) feature units
+		float pixel = static_cast<float>(TILE_SPAN_MAX_ZOOM / TILE_SPAN[z]);
+		float half_width = 960.0f * pixel;
+		float half_height = 540.0f * pixel;
+		size_t visible = 0, full_vertices = 0, simplified_vertices = 0;
+		auto start_ms = stopwatch.GetElapsedMilliseconds();
+		for (auto& shape : shapes)
+		{
+			if (fabsf(shape.center.x) - shape.radius * 2.0f > half_width || fabsf(shape.center.y) - shape.radius * 2.0f > half_height)
+				continue;
+			visible++;
+			full_vertices += shape.points.size();
+			simplified_vertices += LodPyramid::Simplify(shape.points, LodPyramid::GetTolerance(z)).size();
+		}
+		simplify_ms += stopwatch.GetElapsedMilliseconds() - start_ms;
+		total_full += full_vertices;
+		total_simplified += simplified_vertices;
+		PRINTF(L"Zoom %2d: %3d features visible, %7d vertices at full resolution, %6d with zoom views (%.1f%%)\n",
+			zoom, static_cast<int>(visible), static_cast<int>(full_vertices), static_cast<int>(simplified_vertices),
+			full_vertices > 0 ? 100.0 * simplified_vertices / full_vertices : 100.0);
+	}
+	PRINTF(L"All zoom levels: %d vertices at full resolution, %d with zoom views, %.3f ms to simplify every visible feature once\n",
+		static_cast<int>(total_full), static_cast<int>(total_simplified), simplify_ms);
+}
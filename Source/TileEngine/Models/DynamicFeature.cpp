@@ -6,59 +6,64 @@
 DynamicFeature::DynamicFeature()
 	: color(0)
 	, tile_id(INVALID_TILE_ID)
+	, _vertex_pool(nullptr)
 {
 }
 
-DynamicFeature::DynamicFeature(Feature* feature)
-	: position(feature->GetMapPosition())
-	, color(0x33FF33FF)
+DynamicFeature::DynamicFeature(Feature* feature, VertexPool& vertex_pool)
+	: position(feature->GetMapOffset())
+	, color(feature->GetType() == FeatureType::River ? DYNAMIC_FEATURE_RIVER_COLOR : DYNAMIC_FEATURE_DEFAULT_COLOR)
 	, tile_id(feature->GetTileID())
+	, _vertex_pool(&vertex_pool)
+	, _points(std::make_shared<const std::vector<XMFLOAT2>>(feature->GetPointsRef()))
 {
 	ASSERT(feature->IsDynamic());
-	_views[feature->GetTileID()] = DynamicFeatureView(this, feature->GetPointsRef());
-	
+	_full_view = DynamicFeatureView(this, vertex_pool, *_points);
 }
 
 DynamicFeature::~DynamicFeature()
 {
+	_ReleaseViews();
+}
+
+void DynamicFeature::_SetViewParents()
+{
+	_full_view.parent = this;
 	for (auto& view : _views)
 	{
-		if(view.second.vertex_buffer)
-			view.second.vertex_buffer->Release();
+		view.second.parent = this;
 	}
 }
 
-//TileID DynamicFeature::_FindViewRecursive(TileID good_)
-//{
-//	if (_views.count(tile_id) == 1)
-//	{
-//
-//	}
-//}
-
-void DynamicFeature::_BuildView(TileID tile_id)
+void DynamicFeature::_ReleaseViews()
 {
-
+	for (auto& view : _views)
+	{
+		if (view.second.allocation != RangeAllocator::InvalidID && view.second.allocation != _full_view.allocation)
+			_vertex_pool->Remove(view.second.allocation);
+	}
+	_views.clear();
+	if (_full_view.allocation != RangeAllocator::InvalidID)
+		_vertex_pool->Remove(_full_view.allocation);
+	_full_view = DynamicFeatureView();
 }
 
-auto DynamicFeature::GetParentView(TileID child_id) -> DynamicFeatureView
+void DynamicFeature::AddView(uint8_t zoom, const std::vector<XMFLOAT2>& points)
 {
-	TileID parent_id = Tile(child_id).GetParentID();
-	//std::lock_guard<std::mutex> guard(_views_mutex);
-	//There is guaranteed to be at least one view of this feature, it's own tile.
-	//If the requested tile
-	if (_views.count(parent_id) == 0)
-		_BuildView(parent_id);
-	return _views[parent_id];
+	if (HasView(zoom))
+		return;
+	if (points.size() == _points->size())
+		_views[zoom] = _full_view;
+	else
+		_views[zoom] = DynamicFeatureView(this, *_vertex_pool, points);
 }
 
-auto DynamicFeature::GetView(TileID requested_tile_id) -> DynamicFeatureView
+auto DynamicFeature::GetView(uint8_t zoom) -> DynamicFeatureView
 {
-
-	//std::lock_guard<std::mutex> guard(_views_mutex);
-	//There is guaranteed to be at least one view of this feature, it's own tile.
-	//If the requested tile
-	if (_views.count(requested_tile_id) == 0)
-		_BuildView(requested_tile_id);
-	return _views[0];
-}
\ No newline at end of file
+	// Views of higher zoom levels keep more vertices, so the next one up is never coarser
+	// than the pixel error asked for
+	auto view = _views.lower_bound(zoom);
+	if (view != _views.end())
+		return view->second;
+	return _full_view;
+}
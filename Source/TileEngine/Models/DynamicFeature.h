@@ -1,25 +1,36 @@
 #pragma once
 #include <Core/StdIncludes.h>
 #include <map>
-#include <mutex>
+#include <memory>
 #include "DynamicFeatureView.h"
 class Feature;
+
+#define DYNAMIC_FEATURE_DEFAULT_COLOR 0x33FF33FF
+#define DYNAMIC_FEATURE_RIVER_COLOR 0x3399FFFF
+
+/*
+The vertex pool views of one dynamic feature. The full resolution view is built with the feature;
+views simplified to one screen pixel at a zoom level (see LodPyramid) are built on the tile
+engine's worker threads and added with AddView, which ModelsManager does on the render thread.
+A zoom whose simplification drops no vertex shares the full resolution view. */
 class DynamicFeature
 {
 public:
-
-	typedef std::_Tree_const_iterator<std::_Tree_val<std::_Tree_simple_types<DynamicFeatureView>>> ViewIterator;
-
 	TileID tile_id;
-	XMFLOAT2 position;
+	XMFLOAT2 position; // relative to the map center in max zoom pixels, scaled to the current zoom when drawn
 	unsigned color;
-	
+
 	DynamicFeature();
-	DynamicFeature(Feature* feature);
+	DynamicFeature(Feature* feature, VertexPool& vertex_pool);
 	~DynamicFeature();
 
-	DynamicFeatureView GetView(TileID tile_id);
-	DynamicFeatureView GetParentView(TileID tile_id);
+	// The view simplified for this zoom if it has been built. Until then the closest finer view,
+	// which looks the same but costs more vertices.
+	DynamicFeatureView GetView(uint8_t zoom);
+	bool HasView(uint8_t zoom) const { return _views.count(zoom) == 1; }
+	void AddView(uint8_t zoom, const std::vector<XMFLOAT2>& points);
+	// Full resolution points relative to position, shared with the workers that simplify them
+	const std::shared_ptr<const std::vector<XMFLOAT2>>& GetPoints() const { return _points; }
 
 	// no copying for now.
 	DynamicFeature(DynamicFeature const&) = delete;
@@ -27,15 +38,16 @@ public:
 
 	// move ok
 	DynamicFeature(DynamicFeature&& other) noexcept
-		: _views(std::move(other._views))
+		: _points(std::move(other._points))
+		, _full_view(std::move(other._full_view))
+		, _views(std::move(other._views))
+		, _vertex_pool(other._vertex_pool)
 		, position(other.position)
 		, color(other.color)
 		, tile_id(other.tile_id)
 	{
-		for (auto& view : _views)
-		{
-			view.second.parent = this;
-		}
+		other._views.clear();
+		_SetViewParents();
 	}
 
 	inline DynamicFeature& operator=(DynamicFeature&& other) noexcept
@@ -43,21 +55,25 @@ public:
 		if (this == &other)
 			return *this;
 
+		_ReleaseViews();
+		_points = std::move(other._points);
+		_full_view = std::move(other._full_view);
 		_views = std::move(other._views);
+		other._views.clear();
+		_vertex_pool = other._vertex_pool;
 		position = other.position;
 		color = other.color;
 		tile_id = other.tile_id;
-		for (auto& view : _views)
-		{
-			view.second.parent = this;
-		}
+		_SetViewParents();
 		return *this;
 	}
 
 private:
-	void _BuildView(TileID tile_id);
-	std::mutex _views_mutex;
-	std::map<TileID, DynamicFeatureView> _views;
-	//TileID _FindViewRecursive(TileID tile_id);
-
-};
\ No newline at end of file
+	void _SetViewParents();
+	void _ReleaseViews();
+	VertexPool* _vertex_pool;
+	std::shared_ptr<const std::vector<XMFLOAT2>> _points;
+	DynamicFeatureView _full_view;
+	// Views by zoom level. Entries may share _full_view's allocation.
+	std::map<uint8_t, DynamicFeatureView> _views;
+};
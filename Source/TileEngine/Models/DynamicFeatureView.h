@@ -1,27 +1,30 @@
 #pragma once
 #include <Core/StdIncludes.h>
 #include <Core/GraphicsWindow.h>
+#include <TileEngine/VertexPool.h>
 
 class DynamicFeature;
 class DynamicFeatureView
 {
 public:
 	DynamicFeature* parent;
-	ID3D11Buffer* vertex_buffer;
+	// Range of the shared VertexPool holding this view's line strip, already moved to the
+	// feature's position
+	RangeAllocator::AllocationID allocation;
 	int vertex_count;
-	DynamicFeatureView() : vertex_buffer(nullptr), parent(nullptr), vertex_count(0) {}
+	DynamicFeatureView() : allocation(RangeAllocator::InvalidID), parent(nullptr), vertex_count(0) {}
 
-	DynamicFeatureView(DynamicFeature* parent, const std::vector<XMFLOAT2>& vertex_data);
+	DynamicFeatureView(DynamicFeature* parent, VertexPool& vertex_pool, const std::vector<XMFLOAT2>& vertex_data);
 
 	DynamicFeatureView(DynamicFeatureView const& other)
 	{
-		vertex_buffer = other.vertex_buffer;
+		allocation = other.allocation;
 		vertex_count = other.vertex_count;
 		parent = other.parent;
 	}
 	DynamicFeatureView& operator=(DynamicFeatureView const& other)
 	{
-		vertex_buffer = other.vertex_buffer;
+		allocation = other.allocation;
 		vertex_count = other.vertex_count;
 		parent = other.parent;
 		return *this;
@@ -29,17 +32,17 @@ public:
 
 	bool operator==(const DynamicFeatureView& other)
 	{
-		return other.vertex_buffer == vertex_buffer;
+		return other.allocation == allocation;
 	}
 
 	// moving ok
 	DynamicFeatureView(DynamicFeatureView&& other) noexcept
-		: vertex_buffer(other.vertex_buffer)
+		: allocation(other.allocation)
 		, vertex_count(other.vertex_count)
 		, parent(other.parent)
 	{
 		other.parent = nullptr;
-		other.vertex_buffer = nullptr;
+		other.allocation = RangeAllocator::InvalidID;
 		other.vertex_count = 0;
 	}
 
@@ -48,15 +51,13 @@ public:
 		if (this == &other)
 			return *this;
 
-		vertex_buffer = other.vertex_buffer;
+		allocation = other.allocation;
 		vertex_count = other.vertex_count;
 		parent = other.parent;
 		other.parent = nullptr;
-		other.vertex_buffer = nullptr;
+		other.allocation = RangeAllocator::InvalidID;
 		other.vertex_count = 0;
 		return *this;
 	}
 
-	void CreateBuffers(const std::vector<XMFLOAT2>& vertex_data);
-
 };
\ No newline at end of file
@@ -8,11 +8,14 @@ Feature::Feature()
 	, _pos(0.0f, 0.0f)
 	, _rot(0.0f)
 	, _points()
+	, _min_zoom(TILE_MIN_ZOOM)
+	, _max_zoom(TILE_MAX_ZOOM)
 {
 	PRINTF(L"Feature Empty CTOR\n");
 }
 
-Feature::Feature(FeatureID id, const std::string& name, TileID tile_id, FeatureType type, XMFLOAT2 pos, float rot, const XMFLOAT2* points, size_t size_points)
+Feature::Feature(FeatureID id, const std::string& name, TileID tile_id, FeatureType type, XMFLOAT2 pos, float rot, const XMFLOAT2* points, size_t size_points,
+	uint8_t min_zoom, uint8_t max_zoom)
 	: _id(id)
 	, _name(name)
 	, _tile(tile_id)
@@ -20,11 +23,14 @@ Feature::Feature(FeatureID id, const std::string& name, TileID tile_id, FeatureT
 	, _pos(pos)
 	, _rot(rot)
 	, _points(points, points + size_points)
+	, _min_zoom(min_zoom)
+	, _max_zoom(max_zoom)
 {
 	PRINTF(L"Feature CTOR(%d)\n", _id);
 }
 
-Feature::Feature(const std::string& name, TileID tile_id, FeatureType type, XMFLOAT2 pos, float rot, const std::vector<XMFLOAT2>& points)
+Feature::Feature(const std::string& name, TileID tile_id, FeatureType type, XMFLOAT2 pos, float rot, const std::vector<XMFLOAT2>& points,
+	uint8_t min_zoom, uint8_t max_zoom)
 	: _id(0)
 	, _name(name)
 	, _tile(tile_id)
@@ -32,6 +38,22 @@ Feature::Feature(const std::string& name, TileID tile_id, FeatureType type, XMFL
 	, _pos(pos)
 	, _rot(rot)
 	, _points(points)
+	, _min_zoom(min_zoom)
+	, _max_zoom(max_zoom)
 {
 	PRINTF(L"Feature CTOR(%d)\n", _id);
-}
\ No newline at end of file
+}
+
+void Feature::GetBounds(XMFLOAT2& min, XMFLOAT2& max) const
+{
+	auto offset = GetMapOffset();
+	min = offset;
+	max = offset;
+	for (auto& point : _points)
+	{
+		min.x = fminf(min.x, offset.x + point.x);
+		min.y = fminf(min.y, offset.y + point.y);
+		max.x = fmaxf(max.x, offset.x + point.x);
+		max.y = fmaxf(max.y, offset.y + point.y);
+	}
+}
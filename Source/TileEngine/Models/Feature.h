@@ -23,7 +23,8 @@ enum class FeatureType : int
 	Unknown,
 	House,
 	Office,
-	Road
+	Road,
+	River
 };
 
 class Feature
@@ -35,11 +36,16 @@ class Feature
 	XMFLOAT2 _pos;
 	float _rot;
 	std::vector<XMFLOAT2> _points;
+	// Zoom levels this feature is drawn at. Simplified copies of one shape cover different ranges.
+	uint8_t _min_zoom;
+	uint8_t _max_zoom;
 
 public:
 	Feature();
-	Feature(FeatureID id, const std::string& name, TileID tile_id, FeatureType type, XMFLOAT2 pos, float rot, const XMFLOAT2* points, size_t size_points);
-	Feature(const std::string& name, TileID tile_id, FeatureType type, XMFLOAT2 pos, float rot, const std::vector<XMFLOAT2>& points = std::vector<XMFLOAT2>());
+	Feature(FeatureID id, const std::string& name, TileID tile_id, FeatureType type, XMFLOAT2 pos, float rot, const XMFLOAT2* points, size_t size_points,
+		uint8_t min_zoom = TILE_MIN_ZOOM, uint8_t max_zoom = TILE_MAX_ZOOM);
+	Feature(const std::string& name, TileID tile_id, FeatureType type, XMFLOAT2 pos, float rot, const std::vector<XMFLOAT2>& points = std::vector<XMFLOAT2>(),
+		uint8_t min_zoom = TILE_MIN_ZOOM, uint8_t max_zoom = TILE_MAX_ZOOM);
 
 	// no copying for now.
 	Feature(Feature const&) = delete;
@@ -54,6 +60,8 @@ public:
 		, _pos(other._pos)
 		, _rot(other._rot)
 		, _points(std::move(other._points))
+		, _min_zoom(other._min_zoom)
+		, _max_zoom(other._max_zoom)
 	{
 		other._id = 0;
 		other._tile = INVALID_TILE_ID;
@@ -73,6 +81,8 @@ public:
 		_pos = other._pos;
 		_rot = other._rot;
 		_points = std::move(other._points);
+		_min_zoom = other._min_zoom;
+		_max_zoom = other._max_zoom;
 
 		other._id = 0;
 		other._tile = INVALID_TILE_ID;
@@ -82,6 +92,7 @@ public:
 	XMFLOAT2 GetPosition() const { return _pos; }
 	float GetRotation() const { return _rot; }
 	XMFLOAT2 GetMapPosition() const { return Tile(_tile).GetFeaturePosition(_pos); }
+	XMFLOAT2 GetMapOffset() const { return Tile(_tile).GetFeatureOffset(_pos); }
 	FeatureType GetType() const { return _type; }
 	int GetTypeInt() const { return static_cast<int>(_type);  }
 	TileID GetTileID() const { return _tile;  }
@@ -91,5 +102,10 @@ public:
 	bool IsDynamic() const { return _points.size() > 0; }
 	bool IsLoaded() const { return _tile != INVALID_TILE_ID; }
 	const std::string& GetName() const { return _name; }
+	uint8_t GetMinZoom() const { return _min_zoom; }
+	uint8_t GetMaxZoom() const { return _max_zoom; }
+	// Box around the feature's points relative to the map center in max zoom pixels, like
+	// GetMapOffset. A feature without points is a single point.
+	void GetBounds(XMFLOAT2& min, XMFLOAT2& max) const;
 };
 
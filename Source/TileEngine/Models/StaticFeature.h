@@ -9,5 +9,14 @@ struct StaticFeature
 	float rotation;
 	float scale;
 
+	// Inline so the instance packing can be built and tested without the tile and device headers
+	StaticFeature()
+		: model_id(0)
+		, position(0.0f, 0.0f)
+		, color(0)
+		, rotation(0.0f)
+		, scale(1.0f)
+	{
+	}
 	StaticFeature(const Feature* const feature, uint8_t zoom_level);
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "ModelsManager.h"
+#include "LodPyramid.h"
 
 ModelsManager::ModelsManager()
 {
@@ -9,14 +10,76 @@ Cube& ModelsManager::GetCube()
 	return _cube;
 }
 
-DynamicFeatureView ModelsManager::GetDynamicFeatureView(Feature* feature, TileID tile_id)
+DynamicFeatureView ModelsManager::GetDynamicFeatureView(Feature* feature, uint8_t zoom)
 {
 	auto id = feature->GetID();
 
 	if (_dynamic_features.count(id) == 0)
 	{
-		_dynamic_features[id] = DynamicFeature(feature);
+		_dynamic_features[id] = DynamicFeature(feature, _vertex_pool);
+		std::lock_guard<std::mutex> guard(_view_builds_mutex);
+		_view_sources[id] = _dynamic_features[id].GetPoints();
 	}
-	
-	return _dynamic_features[id].GetView(tile_id);
-}
\ No newline at end of file
+
+	auto& dynamic_feature = _dynamic_features[id];
+	if (!dynamic_feature.HasView(zoom) && _requested_views.insert(std::make_pair(id, zoom)).second)
+		_view_requests.push_back(ViewRequest{ feature->GetTileID(), id, zoom });
+	return dynamic_feature.GetView(zoom);
+}
+
+std::vector<ModelsManager::ViewRequest> ModelsManager::TakeViewRequests()
+{
+	std::vector<ViewRequest> requests;
+	requests.swap(_view_requests);
+	return requests;
+}
+
+void ModelsManager::BuildView(FeatureID feature_id, uint8_t zoom)
+{
+	std::shared_ptr<const std::vector<XMFLOAT2>> points;
+	{
+		std::lock_guard<std::mutex> guard(_view_builds_mutex);
+		auto source = _view_sources.find(feature_id);
+		if (source == _view_sources.end())
+			return;
+		points = source->second;
+	}
+
+	auto simplified = LodPyramid::Simplify(*points, LodPyramid::GetTolerance(zoom));
+	std::lock_guard<std::mutex> guard(_view_builds_mutex);
+	_built_views.push_back(BuiltView{ feature_id, zoom, std::move(simplified) });
+}
+
+bool ModelsManager::AddBuiltViews()
+{
+	std::vector<BuiltView> built_views;
+	{
+		std::lock_guard<std::mutex> guard(_view_builds_mutex);
+		if (_built_views.empty())
+			return false;
+		built_views.swap(_built_views);
+	}
+
+	for (auto& built_view : built_views)
+	{
+		auto dynamic_feature = _dynamic_features.find(built_view.feature_id);
+		if (dynamic_feature != _dynamic_features.end())
+			dynamic_feature->second.AddView(built_view.zoom, built_view.points);
+	}
+	return true;
+}
+
+void ModelsManager::RemoveFeatures(const std::vector<FeatureID>& feature_ids)
+{
+	for (auto id : feature_ids)
+	{
+		_dynamic_features.erase(id);
+		_requested_views.erase(_requested_views.lower_bound(std::make_pair(id, static_cast<uint8_t>(0))),
+			_requested_views.upper_bound(std::make_pair(id, static_cast<uint8_t>(UINT8_MAX))));
+	}
+
+	// A view job already queued for one of them finds no source and builds nothing
+	std::lock_guard<std::mutex> guard(_view_builds_mutex);
+	for (auto id : feature_ids)
+		_view_sources.erase(id);
+}
@@ -2,15 +2,55 @@
 #include <Game/Models/Cube.h>
 #include "Models/Feature.h"
 #include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
 
 class ModelsManager
 {
+public:
+	// A view for (feature, zoom) that no worker has been asked to build yet
+	struct ViewRequest
+	{
+		TileID tile_id;
+		FeatureID feature_id;
+		uint8_t zoom;
+	};
+
+private:
+	struct BuiltView
+	{
+		FeatureID feature_id;
+		uint8_t zoom;
+		std::vector<XMFLOAT2> points;
+	};
+
 	Cube _cube;
+	// Declared before the features so it outlives the views they release into it
+	VertexPool _vertex_pool;
 	std::map<FeatureID, DynamicFeature> _dynamic_features;
+	// Views requested since the last TakeViewRequests, and every (feature, zoom) ever requested
+	std::vector<ViewRequest> _view_requests;
+	std::set<std::pair<FeatureID, uint8_t>> _requested_views;
+	// Shared with the workers; guarded by _view_builds_mutex like the finished builds
+	std::unordered_map<FeatureID, std::shared_ptr<const std::vector<XMFLOAT2>>> _view_sources;
+	std::vector<BuiltView> _built_views;
+	std::mutex _view_builds_mutex;
 public:
 	ModelsManager();
 	Cube& GetCube();
+	VertexPool& GetVertexPool() { return _vertex_pool; }
 
-	DynamicFeatureView GetDynamicFeatureView(Feature* feature, TileID tile_id);
+	// The feature's view for this zoom level. A view that has not been built yet is requested
+	// and a finer one is returned in the meantime.
+	DynamicFeatureView GetDynamicFeatureView(Feature* feature, uint8_t zoom);
+	std::vector<ViewRequest> TakeViewRequests();
 
-};
\ No newline at end of file
+	// Worker side: simplifies the feature to one pixel at the zoom level
+	void BuildView(FeatureID feature_id, uint8_t zoom);
+	// Render thread: moves finished views into the vertex pool. Returns whether there were any.
+	bool AddBuiltViews();
+	// Render thread: destroys the dynamic features of evicted features, which returns their views
+	// to the vertex pool, and forgets which of their views were requested
+	void RemoveFeatures(const std::vector<FeatureID>& feature_ids);
+};
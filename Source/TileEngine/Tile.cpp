@@ -195,6 +195,16 @@ auto Tile::GetFeaturePosition(const XMFLOAT2& feature_pos) const -> XMFLOAT2
 		(fy * TILE_PIXEL_WIDTH) + (feature_pos.y * TILE_PIXEL_WIDTH) };
 }
 
+// Position of a feature relative to the map center in max zoom pixels. Unlike GetFeaturePosition
+// this does not depend on the tile's zoom, so features from parent tiles can be scaled to the
+// zoom being drawn.
+auto Tile::GetFeatureOffset(const XMFLOAT2& feature_pos) const -> XMFLOAT2
+{
+	float tile_width = MAP_WIDTH_MAX_ZOOM / TILE_SPAN[z];
+	return XMFLOAT2{ (static_cast<float>(x) + feature_pos.x) * tile_width - MAP_ABSOLUTE_CENTER,
+		(static_cast<float>(y) + feature_pos.y) * tile_width - MAP_ABSOLUTE_CENTER };
+}
+
 auto Tile::GetLevelWidth(uint8_t zoom_level) -> float
 {
 	return pow(2, zoom_level) * TILE_PIXEL_WIDTH;
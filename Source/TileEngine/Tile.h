@@ -59,6 +59,7 @@ struct Tile
 
 	auto GetPosition() const -> XMFLOAT2;
 	auto GetFeaturePosition(const XMFLOAT2& feature_pos) const -> XMFLOAT2;
+	auto GetFeatureOffset(const XMFLOAT2& feature_pos) const -> XMFLOAT2;
 	auto IsValid() const -> bool;
 	auto Contains(XMFLOAT2 map_point) -> bool;
 
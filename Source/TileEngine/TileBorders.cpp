@@ -0,0 +1,66 @@
+#include "TileBorders.h"
+#include <algorithm>
+
+namespace
+{
+	// An edge of unit length on the tile grid of one zoom level: the grid line it lies on and
+	// where along that line it starts. Sorting puts the edges of one line next to each other in
+	// order, so runs can be joined in one pass.
+	uint64_t EdgeKey(uint8_t zoom, uint32_t line, uint32_t start)
+	{
+		return static_cast<uint64_t>(zoom) << 48 | static_cast<uint64_t>(line) << 24 | start;
+	}
+
+	void AddRuns(std::vector<uint64_t>& edges, bool horizontal, std::vector<XMFLOAT2>& lines)
+	{
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+		for (size_t i = 0; i < edges.size();)
+		{
+			// Extend the run while the next edge starts where this one ends on the same line
+			size_t end = i + 1;
+			while (end < edges.size() && edges[end] == edges[end - 1] + 1 && (edges[end] >> 24) == (edges[i] >> 24))
+				++end;
+
+			auto zoom = static_cast<uint8_t>(edges[i] >> 48);
+			auto line = static_cast<float>((edges[i] >> 24) & 0xFFFFFF);
+			auto start = static_cast<float>(edges[i] & 0xFFFFFF);
+			auto length = static_cast<float>(end - i);
+			// Same offset Tile::GetPosition centres a level's tiles on the map with
+			float offset = (TILE_SPAN_MAX - TILE_SPAN[zoom]) / 2.0f;
+			line = (line + offset) * TILE_PIXEL_WIDTH;
+			start = (start + offset) * TILE_PIXEL_WIDTH;
+			float finish = start + length * TILE_PIXEL_WIDTH;
+			if (horizontal)
+			{
+				lines.push_back(XMFLOAT2(start, line));
+				lines.push_back(XMFLOAT2(finish, line));
+			}
+			else
+			{
+				lines.push_back(XMFLOAT2(line, start));
+				lines.push_back(XMFLOAT2(line, finish));
+			}
+			i = end;
+		}
+	}
+}
+
+void TileBorders::Build(const std::set<TileID>& tiles, std::vector<XMFLOAT2>& lines)
+{
+	lines.clear();
+	std::vector<uint64_t> horizontal;
+	std::vector<uint64_t> vertical;
+	horizontal.reserve(tiles.size() * 2);
+	vertical.reserve(tiles.size() * 2);
+	for (auto id : tiles)
+	{
+		Tile tile(id);
+		horizontal.push_back(EdgeKey(tile.z, tile.y, tile.x));
+		horizontal.push_back(EdgeKey(tile.z, tile.y + 1, tile.x));
+		vertical.push_back(EdgeKey(tile.z, tile.x, tile.y));
+		vertical.push_back(EdgeKey(tile.z, tile.x + 1, tile.y));
+	}
+	AddRuns(horizontal, true, lines);
+	AddRuns(vertical, false, lines);
+}
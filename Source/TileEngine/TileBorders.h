@@ -0,0 +1,14 @@
+#pragma once
+#include <Core/StdIncludes.h>
+#include <set>
+#include "Tile.h"
+
+// Outline of a set of tiles as one line list in map pixels, for the tile border overlay. An edge
+// shared by two tiles is emitted once, and edges that continue each other along a grid line are
+// joined, so a rectangle of w x h tiles takes w + h + 2 lines however many tiles it holds.
+namespace TileBorders
+{
+	void Build(const std::set<TileID>& tiles, std::vector<XMFLOAT2>& lines);
+}
+
+void RunTileBordersBenchmark();
@@ -0,0 +1,30 @@
+#include "TileBorders.h"
+#include <Core/DebugTools.h>
+#include <Core/Stopwatch.h>
+
+void RunTileBordersBenchmark()
+{
+	// The visible tiles of a 4K screen with the one tile margin Map::_RefreshTiles adds, at max
+	// zoom where tiles are smallest on screen
+	const int frames = 200;
+	const int columns = 3840 / TILE_PIXEL_WIDTH + 3;
+	const int rows = 2160 / TILE_PIXEL_WIDTH + 3;
+	std::set<TileID> tiles;
+	for (int x = 0; x < columns; ++x)
+	{
+		for (int y = 0; y < rows; ++y)
+			tiles.insert(Tile(8000 + x, 8000 + y, TILE_MAX_ZOOM).GetID());
+	}
+
+	std::vector<XMFLOAT2> lines;
+	Stopwatch stopwatch;
+	for (int frame = 0; frame < frames; ++frame)
+		TileBorders::Build(tiles, lines);
+	auto build_ms = stopwatch.Lap(L"Tile border line list") / frames;
+
+	// One square strip of 5 vertices per tile is what DrawTile recorded
+	PRINTF(L"%d tile borders: one strip per tile = %d draws and %d vertices, line list = 1 draw and %d vertices (%d lines, "
+		L"expected %d), built in %.3f ms\n", static_cast<int>(tiles.size()), static_cast<int>(tiles.size()),
+		static_cast<int>(tiles.size() * 5), static_cast<int>(lines.size()), static_cast<int>(lines.size() / 2),
+		columns + rows + 2, build_ms);
+}
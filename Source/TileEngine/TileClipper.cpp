@@ -0,0 +1,109 @@
+#include "TileClipper.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+	struct Run
+	{
+		std::vector<XMFLOAT2> points;
+		size_t last_segment; // segment that wrote the last point
+	};
+
+	inline XMFLOAT2 Interpolate(const XMFLOAT2& a, const XMFLOAT2& b, double t)
+	{
+		return XMFLOAT2(static_cast<float>(a.x + (b.x - a.x) * t), static_cast<float>(a.y + (b.y - a.y) * t));
+	}
+}
+
+std::vector<TileClipper::Piece> TileClipper::ClipPolyline(const std::vector<XMFLOAT2>& points, uint8_t zoom)
+{
+	const int span = TILE_SPAN[zoom];
+	const double tile_width = MAP_WIDTH_MAX_ZOOM / span;
+	auto tile_index = [&](double coordinate)
+	{
+		int index = static_cast<int>(floor((coordinate + MAP_ABSOLUTE_CENTER) / tile_width));
+		return max(0, min(index, span - 1));
+	};
+
+	// Runs are kept per tile index (y * span + x) in the order they were started
+	std::unordered_map<int, std::vector<Run>> runs;
+	std::vector<int> tile_order;
+	std::vector<double> cuts;
+	for (size_t s = 0; s + 1 < points.size(); s++)
+	{
+		auto& a = points[s];
+		auto& b = points[s + 1];
+
+		// Parameters along the segment where it crosses a vertical or horizontal grid line
+		cuts.clear();
+		cuts.push_back(0.0);
+		int x0 = tile_index(a.x), x1 = tile_index(b.x);
+		for (int x = min(x0, x1) + 1; x <= max(x0, x1); x++)
+			cuts.push_back((x * tile_width - MAP_ABSOLUTE_CENTER - a.x) / (static_cast<double>(b.x) - a.x));
+		int y0 = tile_index(a.y), y1 = tile_index(b.y);
+		for (int y = min(y0, y1) + 1; y <= max(y0, y1); y++)
+			cuts.push_back((y * tile_width - MAP_ABSOLUTE_CENTER - a.y) / (static_cast<double>(b.y) - a.y));
+		cuts.push_back(1.0);
+		std::sort(cuts.begin(), cuts.end());
+
+		for (size_t c = 0; c + 1 < cuts.size(); c++)
+		{
+			if (cuts[c + 1] <= cuts[c])
+				continue;
+
+			// The part between two cuts lies in a single tile; its midpoint says which
+			auto middle = Interpolate(a, b, 0.5 * (cuts[c] + cuts[c + 1]));
+			int index = tile_index(middle.y) * span + tile_index(middle.x);
+			auto start = c == 0 ? a : Interpolate(a, b, cuts[c]);
+			auto end = c + 2 == cuts.size() ? b : Interpolate(a, b, cuts[c + 1]);
+
+			auto& tile_runs = runs[index];
+			if (tile_runs.empty())
+				tile_order.push_back(index);
+			// Continue the tile's current run if it was left off at the end of the previous part
+			bool continues = !tile_runs.empty() && c == 0 && tile_runs.back().last_segment + 1 == s
+				&& tile_runs.back().points.back().x == a.x && tile_runs.back().points.back().y == a.y;
+			if (!continues)
+				tile_runs.push_back(Run{ { start }, s });
+			tile_runs.back().points.push_back(end);
+			tile_runs.back().last_segment = s;
+		}
+	}
+
+	bool closed = points.size() > 2 && points.front().x == points.back().x && points.front().y == points.back().y;
+
+	std::vector<Piece> pieces;
+	pieces.reserve(tile_order.size());
+	for (auto index : tile_order)
+	{
+		auto& tile_runs = runs[index];
+		// A ring that starts inside this tile: its last run flows straight into its first
+		auto& first_point = tile_runs.front().points.front();
+		auto& last_point = tile_runs.back().points.back();
+		if (closed && tile_runs.size() > 1
+			&& first_point.x == points.front().x && first_point.y == points.front().y
+			&& last_point.x == points.back().x && last_point.y == points.back().y)
+		{
+			auto& last = tile_runs.back().points;
+			last.insert(last.end(), tile_runs.front().points.begin() + 1, tile_runs.front().points.end());
+			tile_runs.front().points = std::move(last);
+			tile_runs.pop_back();
+		}
+
+		Piece piece;
+		piece.tile = Tile(static_cast<uint16_t>(index % span), static_cast<uint16_t>(index / span), zoom);
+		auto center = piece.tile.GetFeatureOffset(XMFLOAT2(0.5f, 0.5f));
+		for (auto& run : tile_runs)
+		{
+			for (auto& point : run.points)
+			{
+				point.x -= center.x;
+				point.y -= center.y;
+			}
+			piece.polylines.push_back(std::move(run.points));
+		}
+		pieces.push_back(std::move(piece));
+	}
+	return pieces;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <Core/StdIncludes.h>
+#include "Tile.h"
+
+// Splits features that span many tiles into one piece per tile of a chosen zoom level,
+// so loading a viewport only pulls in the geometry that is actually on screen.
+namespace TileClipper
+{
+	struct Piece
+	{
+		Tile tile;
+		// Relative to the tile's center, in max zoom pixels
+		std::vector<std::vector<XMFLOAT2>> polylines;
+	};
+
+	// points are relative to the map center in max zoom pixels. Each segment is cut where it
+	// crosses the tile grid of the given zoom and the parts are joined into runs per tile.
+	// A closed ring (first point == last point) that starts and ends inside the same tile
+	// is rejoined there rather than split at its start.
+	std::vector<Piece> ClipPolyline(const std::vector<XMFLOAT2>& points, uint8_t zoom);
+}
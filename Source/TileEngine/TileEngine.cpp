@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <iterator>
 #include "DbInterface.h"
+#include <Game/InstancePacker.h>
 #include <sstream>
 
 namespace
@@ -41,7 +42,8 @@ namespace
 				break;
 
 			// Process Job
-			// If zoom level is max zoom + 1, this is feature id.
+			else if (work.build_view)
+				tile_engine->ProcessViewJob(work);
 			else if (work.feature_id > 0)
 				tile_engine->ProcessFeatureJob(db_connection, work, name);
 			else
@@ -60,6 +62,9 @@ TileEngine::TileEngine(const char* const db_filename)
 	, _db_filename(db_filename)
 	, _build_draw_lists(true)
 	, _zoom(0)
+	, _dynamic_vertex_count(0)
+	, _visible_feature_count(0)
+	, _culled_feature_count(0)
 {
 	// spawn 4 worker threads
 	_worker_threads.push_back(_threadpool.SubmitWork(WorkerThread, this));
@@ -71,7 +76,7 @@ TileEngine::TileEngine(const char* const db_filename)
 TileEngine::~TileEngine()
 {
 	// shutdown the worker threads by sending N invalid tile ids where N = num worker threads
-	std::vector<WorkItem> invalid_tiles(_worker_threads.size(), { INVALID_TILE_ID, 0 });
+	std::vector<WorkItem> invalid_tiles(_worker_threads.size(), { INVALID_TILE_ID, 0, 0 });
 	_job_count.fetch_add(invalid_tiles.size(), std::memory_order::memory_order_release);
 	_job_queue.enqueue_bulk(invalid_tiles.begin(), invalid_tiles.size());
 	for (auto& worker_thread : _worker_threads)
@@ -80,11 +85,12 @@ TileEngine::~TileEngine()
 
 void TileEngine::ProcessTileJob(Db::Connection& conn, const WorkItem& work, const char* thread_name)
 {
-	if (_InitialLoad(work.tile_id, thread_name))
+	auto load_key = GetLoadKey(work.tile_id, work.zoom);
+	if (_InitialLoad(load_key, thread_name))
 	{
 		std::string tile = Tile(work.tile_id).ToString();
-		PRINTF(L"[%S] LOADING TILE %S\n", thread_name, tile.c_str());
-		auto feature_ids = DbInterface::GetFeatureIDs(conn, work.tile_id);
+		PRINTF(L"[%S] LOADING TILE %S AT ZOOM %d\n", thread_name, tile.c_str(), work.zoom);
+		auto feature_ids = DbInterface::GetFeatureIDs(conn, work.tile_id, work.zoom);
 
 		if (feature_ids.size() > 0)
 		{
@@ -92,25 +98,33 @@ void TileEngine::ProcessTileJob(Db::Connection& conn, const WorkItem& work, cons
 			size_t i = 0;
 			for (auto& feature_id : feature_ids)
 			{
-				new_work[i++] = WorkItem{ work.tile_id, feature_id };
+				new_work[i++] = WorkItem{ work.tile_id, feature_id, work.zoom };
 			}
 
+			// Listed before the features load, so an eviction in between keeps them
+			{
+				std::lock_guard<std::mutex> guard(_tile_features_mutex);
+				_tile_features[load_key].insert(feature_ids.begin(), feature_ids.end());
+			}
 			_job_count.fetch_add(new_work.size(), std::memory_order::memory_order_release);
 			_job_queue.enqueue_bulk(new_work.begin(), new_work.size());
-			std::lock_guard<std::mutex> guard(_tile_features_mutex);
-			_tile_features[work.tile_id].insert(feature_ids.begin(), feature_ids.end());
 		}
 	}
 }
 
-bool TileEngine::_InitialLoad(const TileID tile_id, const char* thread_name)
+void TileEngine::ProcessViewJob(const WorkItem& work)
+{
+	_models_manager.BuildView(work.feature_id, work.zoom);
+}
+
+bool TileEngine::_InitialLoad(const LoadKey load_key, const char* thread_name)
 {
 	bool is_initial_load = false;
 	{
 		std::lock_guard<std::mutex> guard(_tile_features_mutex);
-		is_initial_load = _tile_features.count(tile_id) == 0;
+		is_initial_load = _tile_features.count(load_key) == 0;
 		if(is_initial_load)
-			_tile_features[tile_id] = std::unordered_set<FeatureID>();
+			_tile_features[load_key] = std::unordered_set<FeatureID>();
 	}
 	return is_initial_load;
 }
@@ -125,6 +139,9 @@ void TileEngine::ProcessFeatureJob(Db::Connection& conn, const WorkItem& work, c
 		// Assert that the feature was found in the database. Otherwise where the f did the feature id come from?
 		ASSERT(feature.GetID() == work.feature_id);
 
+		XMFLOAT2 bounds_min, bounds_max;
+		feature.GetBounds(bounds_min, bounds_max);
+		_feature_bounds_slots[work.feature_id] = _feature_bounds.Add(bounds_min, bounds_max);
 		_features[work.feature_id] = std::move(feature);
 		_build_draw_lists = true;
 	}
@@ -151,27 +168,92 @@ void TileEngine::Refresh(BoundingRect visible_area, uint8_t zoom_level)
 		for (int y = bottom; y <= top; ++y)
 			visible_tiles.insert(Tile(x, y, zoom_level).GetID());
 
-	std::vector<TileID> new_tiles;
-	std::set_difference(visible_tiles.begin(), visible_tiles.end(),
-		_visible_tiles.begin(), _visible_tiles.end(),
-		std::inserter(new_tiles, new_tiles.begin()));
-
-	if (new_tiles.size() > 0)
+	// Parent tiles hold features that span several visible tiles, so the whole chain
+	// up to the root is loaded at this zoom's level of detail as well
+	std::vector<WorkItem> new_work;
+	std::set<LoadKey> needed_loads;
+	for (auto& visible_tile : visible_tiles)
 	{
-		std::vector<WorkItem> new_work(new_tiles.size());
-		size_t i = 0;
-		for (auto& new_tile : new_tiles)
+		Tile tile(visible_tile);
+		for (;;)
 		{
-			new_work[i++] = WorkItem{ new_tile, 0 };
+			auto tile_id = tile.GetID();
+			auto load_key = GetLoadKey(tile_id, zoom_level);
+			if (!needed_loads.insert(load_key).second)
+				break; // this tile and its parents were already visited
+			if (_requested_loads.insert(load_key).second)
+				new_work.push_back(WorkItem{ tile_id, 0, zoom_level });
+			if (tile.z == 0)
+				break;
+			tile = Tile(tile.GetParentID());
 		}
+	}
+
+	if (new_work.size() > 0)
+	{
 		_ExecuteTileLoader(new_work);
 	}
 
+	if (_requested_loads.size() > TILE_LOADS_MAX)
+		_EvictLoads(needed_loads);
+
 	_visible_tiles = visible_tiles;
 	_build_draw_lists = true;
 	_zoom = zoom_level;
 }
 
+void TileEngine::_EvictLoads(const std::set<LoadKey>& needed_loads)
+{
+	size_t before = _requested_loads.size();
+	for (auto it = _requested_loads.begin(); it != _requested_loads.end();)
+		it = needed_loads.count(*it) ? std::next(it) : _requested_loads.erase(it);
+
+	// A tile job still in flight for an evicted key may add its entry back after this. The entry
+	// is complete once the job is done, so a later request for the key just reuses it, and the
+	// next eviction removes it if it is still not needed. The same goes for a feature job that
+	// loads a feature of an evicted key.
+	std::lock_guard<std::mutex> features_guard(_features_mutex);
+	std::lock_guard<std::mutex> guard(_tile_features_mutex);
+	std::unordered_set<FeatureID> kept_features;
+	for (auto it = _tile_features.begin(); it != _tile_features.end();)
+	{
+		if (needed_loads.count(it->first) == 0)
+		{
+			it = _tile_features.erase(it);
+			continue;
+		}
+		kept_features.insert(it->second.begin(), it->second.end());
+		++it;
+	}
+
+	// A feature is listed by every tile and zoom it was clipped to, so it stays while any kept load lists it
+	std::vector<FeatureID> evicted_features;
+	for (auto it = _features.begin(); it != _features.end();)
+	{
+		if (kept_features.count(it->first) == 1)
+		{
+			++it;
+			continue;
+		}
+		evicted_features.push_back(it->first);
+		it = _features.erase(it);
+	}
+	for (auto feature_id : evicted_features)
+	{
+		auto slot = _feature_bounds_slots.find(feature_id);
+		if (slot != _feature_bounds_slots.end())
+		{
+			_feature_bounds.Remove(slot->second);
+			_feature_bounds_slots.erase(slot);
+		}
+	}
+	// The draw list holds views of the dynamic features removed here; it is rebuilt before the next draw
+	_models_manager.RemoveFeatures(evicted_features);
+	_dynamic_feature_draw_list.clear();
+	PRINTF(L"Evicted %d tile loads and %d features, %d loads kept\n", static_cast<int>(before - _requested_loads.size()),
+		static_cast<int>(evicted_features.size()), static_cast<int>(_requested_loads.size()));
+}
+
 Tile TileEngine::_ContainsRecursive(Tile tile, const XMFLOAT2& top_left, const XMFLOAT2& bottom_right)
 {
 	Tile result;
@@ -240,49 +322,68 @@ void TileEngine::WaitForBusyThreads()
 		continue;
 }
 
-Tile TileEngine::_GetChildTileContaining(Tile tile, const XMFLOAT2& top_left, const XMFLOAT2& bottom_right)
-{	
-	auto children = tile.GetChildren();
-	for (auto& child : children)
+// Features clipped to a coarser zoom live on parent tiles, so every tile on the way from a
+// visible tile up to the root can contribute features to the current view
+void TileEngine::_CollectVisibleFeaturesFromParentTiles(std::vector<Feature*>& visible_features)
+{
+	std::set<TileID> parent_tiles;
+	for (auto& visible_tile : _visible_tiles)
 	{
-		auto pos = child.GetPosition();
-		float minx, maxx, miny, maxy;
-		minx = pos.x - TILE_PIXEL_WIDTH_HALF;
-		miny = pos.y - TILE_PIXEL_WIDTH_HALF;
-		maxx = pos.x + TILE_PIXEL_WIDTH_HALF;
-		maxy = pos.y + TILE_PIXEL_WIDTH_HALF;
+		Tile tile(visible_tile);
+		while (tile.z > 0)
+		{
+			tile = Tile(tile.GetParentID());
+			if (!parent_tiles.insert(tile.GetID()).second)
+				break; // the rest of the chain was already collected
+		}
+	}
 
+	for (auto& tile_id : parent_tiles)
+	{
+		auto load_key = GetLoadKey(tile_id, _zoom);
 
-		if (top_left.x >= minx && bottom_right.x <= maxx && bottom_right.y >= miny && top_left.y <= maxy)
+		// Does this tile have any features at this zoom?
+		if (_tile_features.count(load_key) == 1)
 		{
-			return child;
+			auto& feature_ids = _tile_features[load_key];
+			for (auto& feature_id : feature_ids)
+			{
+				auto feature = _features.find(feature_id);
+				if (feature != _features.end() && feature->second.IsLoaded())
+					visible_features.push_back(&feature->second);
+			}
 		}
 	}
-
-	return tile;
 }
 
-void TileEngine::_CollectVisibleFeaturesFromParentTiles(Tile tile, const XMFLOAT2& top_left, const XMFLOAT2& bottom_right, std::vector<Feature*>& visible_features)
+void TileEngine::_CullFeatures()
 {
-	auto tile_id = tile.GetID();
+	XMFLOAT2 top_left, bottom_right;
+	_visible_area.GetCorners(top_left, bottom_right);
 
-	// Does this tile have any features?
-	if (_tile_features.count(tile_id) == 1)
-	{
-		auto feature_ids = _tile_features[tile_id];
-		for (auto& feature_id : feature_ids)
-		{
-			auto* feature = &_features[feature_id];
-			if(feature->IsLoaded())
-				visible_features.push_back(feature);
-		}
-	}
+	// Static features are drawn as models around their position, so widen the view by a model
+	// before moving it into the zoom independent space the bounds are kept in
+	float margin = STATIC_FEATURE_MODEL_SCALE;
+	float scale = div2(1.0f, TILE_MAX_ZOOM - _zoom);
+	XMFLOAT2 view_min((min(top_left.x, bottom_right.x) - margin - MAP_ABSOLUTE_CENTER) / scale,
+		(min(top_left.y, bottom_right.y) - margin - MAP_ABSOLUTE_CENTER) / scale);
+	XMFLOAT2 view_max((max(top_left.x, bottom_right.x) + margin - MAP_ABSOLUTE_CENTER) / scale,
+		(max(top_left.y, bottom_right.y) + margin - MAP_ABSOLUTE_CENTER) / scale);
+	_feature_bounds.Cull(view_min, view_max);
+	_visible_feature_count = 0;
+	_culled_feature_count = 0;
+}
 
-	auto next_tile = _GetChildTileContaining(tile, top_left, bottom_right);
-	if (next_tile != tile)
+bool TileEngine::_IsFeatureVisible(FeatureID feature_id)
+{
+	auto slot = _feature_bounds_slots.find(feature_id);
+	if (slot != _feature_bounds_slots.end() && !_feature_bounds.IsVisible(slot->second))
 	{
-		_CollectVisibleFeaturesFromParentTiles(next_tile, top_left, bottom_right, visible_features);
+		_culled_feature_count++;
+		return false;
 	}
+	_visible_feature_count++;
+	return true;
 }
 
 void TileEngine::_BuildDrawLists()
@@ -297,35 +398,38 @@ void TileEngine::_BuildDrawLists()
 	bool all_tiles_loaded = true;
 	_static_feature_draw_list.clear();
 	_dynamic_feature_draw_list.clear();
-	XMFLOAT2 top_left, bottom_right;
-	_visible_area.GetCorners(top_left, bottom_right);
 	
 	std::lock_guard<std::mutex> guard(_features_mutex);
 	std::lock_guard<std::mutex> guard2(_tile_features_mutex);
 
 	std::vector<Feature*> visible_features;
-	_CollectVisibleFeaturesFromParentTiles(Tile(0, 0, 0), top_left, bottom_right, visible_features);
+	_CollectVisibleFeaturesFromParentTiles(visible_features);
+	_CullFeatures();
 
 	// 1. Loop through visible tiles.
 	// 2. Check for features belonging to each visible tile and add them to draw queue
 	// 3. Loop through visible features from the parent tiles
-	// 4. Add view of feature for each visible tile.
+	// 4. Add a view of each parent feature.
 
 	for (auto& visible_tile : _visible_tiles)
 	{
 		// add features belonging to these visible tiles
-		if (_tile_features.count(visible_tile) == 1)
+		auto load_key = GetLoadKey(visible_tile, _zoom);
+		if (_tile_features.count(load_key) == 1)
 		{
-			auto feature_ids = _tile_features[visible_tile];
+			auto feature_ids = _tile_features[load_key];
 			for (auto& feature_id : feature_ids)
 			{
-				auto* feature = &_features[feature_id];
-				if (feature->IsLoaded())
+				auto found = _features.find(feature_id);
+				auto* feature = found != _features.end() ? &found->second : nullptr;
+				if (feature && feature->IsLoaded())
 				{
+					if (!_IsFeatureVisible(feature_id))
+						continue;
 					if (feature->IsDynamic())
 					{
-						auto view = _models_manager.GetDynamicFeatureView(feature, visible_tile);
-						if (std::find(_dynamic_feature_draw_list.begin(), _dynamic_feature_draw_list.end(), view) == _dynamic_feature_draw_list.end())
+						auto view = _models_manager.GetDynamicFeatureView(feature, _zoom);
+						if (view.vertex_count > 0 && std::find(_dynamic_feature_draw_list.begin(), _dynamic_feature_draw_list.end(), view) == _dynamic_feature_draw_list.end())
 							_dynamic_feature_draw_list.push_back(view);
 					}
 					else
@@ -340,21 +444,53 @@ void TileEngine::_BuildDrawLists()
 				
 			}
 		}
+	}
 
-		// add a view for each parent feature
-		for (auto* feature : visible_features)
-		{
-			auto view = _models_manager.GetDynamicFeatureView(feature, visible_tile);
-			if(std::find(_dynamic_feature_draw_list.begin(), _dynamic_feature_draw_list.end(), view) == _dynamic_feature_draw_list.end())
-				_dynamic_feature_draw_list.push_back(view);
-		}
+	// add a view for each parent feature
+	for (auto* feature : visible_features)
+	{
+		if (!_IsFeatureVisible(feature->GetID()))
+			continue;
+		auto view = _models_manager.GetDynamicFeatureView(feature, _zoom);
+		if(view.vertex_count > 0 && std::find(_dynamic_feature_draw_list.begin(), _dynamic_feature_draw_list.end(), view) == _dynamic_feature_draw_list.end())
+			_dynamic_feature_draw_list.push_back(view);
 	}
+	// Views of one colour are drawn together, so keep them next to each other
+	std::stable_sort(_dynamic_feature_draw_list.begin(), _dynamic_feature_draw_list.end(),
+		[](const DynamicFeatureView& a, const DynamicFeatureView& b) { return a.parent->color < b.parent->color; });
+
+	_dynamic_vertex_count = 0;
+	for (auto& view : _dynamic_feature_draw_list)
+		_dynamic_vertex_count += view.vertex_count;
+	auto pool_stats = GetVertexPool().GetStats();
+	PRINTF(L"Draw lists at zoom %d: %d features visible, %d culled, %d dynamic features, %d vertices, vertex pool %u/%u used (%u free blocks, fragmentation %.2f, %u compactions)\n",
+		_zoom, static_cast<int>(_visible_feature_count), static_cast<int>(_culled_feature_count),
+		static_cast<int>(_dynamic_feature_draw_list.size()), static_cast<int>(_dynamic_vertex_count),
+		pool_stats.used, pool_stats.capacity, pool_stats.free_block_count, pool_stats.GetFragmentation(), pool_stats.compaction_count);
+
+	_RequestViews();
 	if(all_tiles_loaded)
 		_build_draw_lists = false;
 }
 
+void TileEngine::_RequestViews()
+{
+	auto requests = _models_manager.TakeViewRequests();
+	if (requests.empty())
+		return;
+	std::vector<WorkItem> new_work;
+	new_work.reserve(requests.size());
+	for (auto& request : requests)
+		new_work.push_back(WorkItem{ request.tile_id, request.feature_id, request.zoom, true });
+	_job_count.fetch_add(new_work.size(), std::memory_order::memory_order_release);
+	_job_queue.enqueue_bulk(new_work.begin(), new_work.size());
+}
+
 void TileEngine::PrepareDrawLists()
 {
+	// Views finished by the workers replace the finer ones drawn in the meantime
+	if (_models_manager.AddBuiltViews())
+		_build_draw_lists = true;
 	if(_build_draw_lists)
 		_BuildDrawLists();
 }
\ No newline at end of file
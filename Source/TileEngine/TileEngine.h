@@ -7,12 +7,17 @@
 #include <Core/StdIncludes.h>
 #include <Core/Threadpool.h>
 #include <Core/Db.h>
+#include <Core/BoundsCuller.h>
 #include "Tile.h"
 #include "Models/Feature.h"
 #include "Models/BoundingRect.h"
 #include "ModelsManager.h"
 using namespace moodycamel;
 
+// Tile loads kept after their tiles leave the view, so panning back does not query them again.
+// Beyond this the loads the current view does not need are forgotten.
+#define TILE_LOADS_MAX 4096
+
 
 
 class TileEngine
@@ -22,14 +27,26 @@ public:
 	{
 		TileID tile_id;
 		FeatureID feature_id;
+		uint8_t zoom; // zoom level the tile's features are loaded for
+		bool build_view; // simplify the dynamic feature's view for zoom instead of loading
 	};
 
+	// A tile's features differ per zoom level (see LodPyramid), so loads are tracked per (tile, zoom)
+	typedef uint64_t LoadKey;
+	static LoadKey GetLoadKey(TileID tile_id, uint8_t zoom) { return (static_cast<uint64_t>(tile_id) << 8) | zoom; }
+
 private:
 	BoundingRect _visible_area;
 	std::set<TileID> _visible_tiles;
+	std::set<LoadKey> _requested_loads;
 	std::map<FeatureID, Feature> _features;
 	std::mutex _features_mutex;
-	std::map<TileID, std::unordered_set<FeatureID>> _tile_features;
+	// Bounds of every loaded feature, computed once at load time. Guarded by _features_mutex.
+	BoundsCuller _feature_bounds;
+	std::unordered_map<FeatureID, uint32_t> _feature_bounds_slots;
+	size_t _visible_feature_count;
+	size_t _culled_feature_count;
+	std::map<LoadKey, std::unordered_set<FeatureID>> _tile_features;
 	std::mutex _tile_features_mutex;
 	Threadpool _threadpool;
 	BlockingConcurrentQueue<WorkItem> _job_queue;
@@ -39,14 +56,18 @@ private:
 	std::vector<StaticFeature> _static_feature_draw_list;
 	std::vector<DynamicFeatureView> _dynamic_feature_draw_list;
 	uint8_t _zoom;
+	size_t _dynamic_vertex_count;
 	void _ExecuteTileLoader(const std::vector<WorkItem>& work);
 	const char* const _db_filename;
-	bool _InitialLoad(const TileID tile_id, const char* thread_name);
+	bool _InitialLoad(const LoadKey load_key, const char* thread_name);
+	void _EvictLoads(const std::set<LoadKey>& needed_loads);
 	bool _build_draw_lists;
 	void _BuildDrawLists();
+	void _RequestViews();
+	void _CullFeatures();
+	bool _IsFeatureVisible(FeatureID feature_id);
 	Tile _ContainsRecursive(Tile tile, const XMFLOAT2& top_left, const XMFLOAT2& bottom_right);
-	void _CollectVisibleFeaturesFromParentTiles(Tile tile, const XMFLOAT2& top_left, const XMFLOAT2& bottom_right, std::vector<Feature*>& visible_features);
-	Tile _GetChildTileContaining(Tile tile, const XMFLOAT2& top_left, const XMFLOAT2& bottom_right);
+	void _CollectVisibleFeaturesFromParentTiles(std::vector<Feature*>& visible_features);
 public:
 	TileEngine(const char* const db_filename);
 	~TileEngine();
@@ -59,6 +80,7 @@ public:
 	void WaitForBusyThreads();
 	void ProcessTileJob(Db::Connection& conn, const WorkItem& work, const char* thread_name);
 	void ProcessFeatureJob(Db::Connection& conn, const WorkItem& work, const char* thread_name);
+	void ProcessViewJob(const WorkItem& work);
 	const char* const GetDatabaseFileName() const { return _db_filename; }
 	const std::set<TileID>& GetVisibleTiles() { return _visible_tiles; }
 
@@ -67,5 +89,12 @@ public:
 	std::vector<DynamicFeatureView>& GetDynamicFeatureDrawList() { return _dynamic_feature_draw_list; }
 	size_t StaticFeatureDrawListCount() { return _static_feature_draw_list.size(); }
 	size_t DynamicFeatureDrawListCount() { return _dynamic_feature_draw_list.size(); }
+	// Vertices in the dynamic feature draw list, i.e. uploaded by DrawDynamicFeaturesBulk each frame
+	size_t DynamicFeatureVertexCount() { return _dynamic_vertex_count; }
+	// Features of the visible and parent tiles that were drawn or culled by the last draw list build
+	size_t GetVisibleFeatureCount() const { return _visible_feature_count; }
+	size_t GetCulledFeatureCount() const { return _culled_feature_count; }
+	// Holds the vertices of every view in the dynamic feature draw list
+	VertexPool& GetVertexPool() { return _models_manager.GetVertexPool(); }
 
 };
\ No newline at end of file
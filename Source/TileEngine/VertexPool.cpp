@@ -0,0 +1,79 @@
+#include "VertexPool.h"
+#include <Core/DebugTools.h>
+
+VertexPool::VertexPool()
+	: _allocator(VERTEX_POOL_INITIAL_CAPACITY)
+	, _vertices(VERTEX_POOL_INITIAL_CAPACITY)
+	, _buffer(nullptr)
+	, _release_buffer(nullptr)
+	, _buffer_capacity(0)
+	, _dirty_begin(0)
+	, _dirty_end(0)
+	, _grow_count(0)
+{
+}
+
+VertexPool::~VertexPool()
+{
+	if (_buffer)
+		_release_buffer(_buffer);
+}
+
+void VertexPool::_MarkDirty(uint32_t begin, uint32_t end)
+{
+	if (_dirty_begin == _dirty_end)
+	{
+		_dirty_begin = begin;
+		_dirty_end = end;
+	}
+	else
+	{
+		_dirty_begin = min(_dirty_begin, begin);
+		_dirty_end = max(_dirty_end, end);
+	}
+}
+
+RangeAllocator::AllocationID VertexPool::Add(const XMFLOAT2* vertices, size_t vertex_count, const XMFLOAT2& offset)
+{
+	auto count = static_cast<uint32_t>(vertex_count);
+	auto allocation = _allocator.Allocate(count);
+	if (allocation == RangeAllocator::InvalidID)
+	{
+		// Compact when there is room in total, grow when there is not
+		auto stats = _allocator.GetStats();
+		if (stats.free >= count)
+		{
+			_allocator.Compact([this](uint32_t from, uint32_t to, uint32_t n)
+			{
+				memmove(&_vertices[to], &_vertices[from], n * sizeof(XMFLOAT2));
+			});
+			_MarkDirty(0, stats.used);
+		}
+		else
+		{
+			_allocator.Grow(max(stats.capacity * 2, stats.capacity + count));
+			_vertices.resize(_allocator.GetCapacity());
+			_grow_count++;
+		}
+		allocation = _allocator.Allocate(count);
+		ASSERT(allocation != RangeAllocator::InvalidID);
+	}
+
+	auto& range = _allocator.GetRange(allocation);
+	for (uint32_t i = 0; i < count; i++)
+		_vertices[range.offset + i] = XMFLOAT2(vertices[i].x + offset.x, vertices[i].y + offset.y);
+	_MarkDirty(range.offset, range.offset + count);
+	return allocation;
+}
+
+void VertexPool::Remove(RangeAllocator::AllocationID allocation)
+{
+	// The vertices stay in the buffer until the range is reused; nothing indexes them meanwhile
+	_allocator.Free(allocation);
+}
+
+void VertexPool::AppendStripIndices(std::vector<uint32_t>& indices, RangeAllocator::AllocationID allocation) const
+{
+	auto& range = _allocator.GetRange(allocation);
+	::AppendStripIndices(indices, range.offset, range.count);
+}
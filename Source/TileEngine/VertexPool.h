@@ -0,0 +1,54 @@
+#pragma once
+#include <Core/StdIncludes.h>
+#include <Core/RangeAllocator.h>
+
+struct ID3D11Buffer;
+struct ID3D11Device;
+struct ID3D11DeviceContext;
+
+#define VERTEX_POOL_INITIAL_CAPACITY 65536
+
+/*
+One vertex buffer shared by every dynamic feature view. Views own a range of it through a
+RangeAllocator and the whole pool is bound once per frame. A CPU copy of the vertices is kept so
+the pool can compact itself instead of growing when the free space is only fragmented, and so a
+grown buffer can be recreated with its contents. Only the span changed since the last Upload()
+is sent to the GPU. Upload() lives in VertexPoolUpload.cpp so the rest runs without a device. */
+class VertexPool
+{
+	RangeAllocator _allocator;
+	std::vector<XMFLOAT2> _vertices;
+	ID3D11Buffer* _buffer;
+	// Set by Upload() along with the buffer, so the pool can be destroyed without the D3D headers
+	void (*_release_buffer)(ID3D11Buffer* buffer);
+	uint32_t _buffer_capacity;
+	// Vertices changed since the last upload, end exclusive
+	uint32_t _dirty_begin;
+	uint32_t _dirty_end;
+	uint32_t _grow_count;
+
+	void _MarkDirty(uint32_t begin, uint32_t end);
+
+public:
+	VertexPool();
+	~VertexPool();
+
+	VertexPool(VertexPool const&) = delete;
+	VertexPool& operator=(VertexPool const&) = delete;
+
+	// Copies the vertices into the pool, each moved by offset
+	RangeAllocator::AllocationID Add(const XMFLOAT2* vertices, size_t vertex_count, const XMFLOAT2& offset);
+	void Remove(RangeAllocator::AllocationID allocation);
+	const RangeAllocator::Range& GetRange(RangeAllocator::AllocationID allocation) const { return _allocator.GetRange(allocation); }
+	// Appends the allocation's vertices as one strip of the pool's strip list
+	void AppendStripIndices(std::vector<uint32_t>& indices, RangeAllocator::AllocationID allocation) const;
+	// The CPU copy of the pool, indexed like the vertex buffer
+	const XMFLOAT2* GetVertices() const { return _vertices.data(); }
+
+	// Creates or updates the vertex buffer. Returns false if there is nothing to draw from.
+	bool Upload(ID3D11Device* device, ID3D11DeviceContext* context);
+	ID3D11Buffer* const* GetBufferAddr() const { return &_buffer; }
+
+	RangeAllocator::Stats GetStats() const { return _allocator.GetStats(); }
+	uint32_t GetGrowCount() const { return _grow_count; }
+};
@@ -0,0 +1,39 @@
+#include "VertexPool.h"
+#include <Core/GraphicsWindow.h>
+
+bool VertexPool::Upload(ID3D11Device* device, ID3D11DeviceContext* context)
+{
+	if (_buffer_capacity != _allocator.GetCapacity())
+	{
+		if (_buffer)
+			_buffer->Release();
+		_buffer = nullptr;
+		_buffer_capacity = 0;
+
+		D3D11_BUFFER_DESC desc;
+		ZeroMemory(&desc, sizeof(desc));
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.ByteWidth = static_cast<UINT>(sizeof(XMFLOAT2) * _vertices.size());
+		desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+		D3D11_SUBRESOURCE_DATA data;
+		ZeroMemory(&data, sizeof(data));
+		data.pSysMem = _vertices.data();
+
+		if (!D3DCheck(device->CreateBuffer(&desc, &data, &_buffer),
+			L"ID3D11Device::CreateBuffer (VertexPool)")) return false;
+		_release_buffer = [](ID3D11Buffer* buffer) { buffer->Release(); };
+		_buffer_capacity = _allocator.GetCapacity();
+		_dirty_begin = _dirty_end = 0;
+		return true;
+	}
+
+	if (_dirty_begin != _dirty_end)
+	{
+		D3D11_BOX box = { static_cast<UINT>(_dirty_begin * sizeof(XMFLOAT2)), 0, 0,
+			static_cast<UINT>(_dirty_end * sizeof(XMFLOAT2)), 1, 1 };
+		context->UpdateSubresource(_buffer, 0, &box, &_vertices[_dirty_begin], 0, 0);
+		_dirty_begin = _dirty_end = 0;
+	}
+	return _buffer != nullptr;
+}
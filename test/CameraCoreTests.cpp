@@ -0,0 +1,157 @@
+#include <Check.h>
+#include <Game/CameraCore.h>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+static const float Width = 1920.0f;
+static const float Height = 1080.0f;
+static const float FovY = 0.25f * XM_PI;
+
+// The map camera of Main: above the plane looking straight down
+static void SetUpMapCamera(CameraCore& camera, float width, float height, const XMFLOAT3& position)
+{
+	camera.SetLens(FovY, width / height, 1.0f, 100000.0f);
+	camera.SetViewport(width, height);
+	camera.SetPosition(position);
+	camera.Pitch(XMConvertToRadians(90.0f));
+}
+
+static XMFLOAT2 RayToPlane(const XMFLOAT3& origin, const XMFLOAT3& direction, float plane_y)
+{
+	auto t = (plane_y - origin.y) / direction.y;
+	return XMFLOAT2(origin.x + t * direction.x, origin.z + t * direction.z);
+}
+
+static void TestCentreHitsBelowTheCamera()
+{
+	CameraCore camera;
+	SetUpMapCamera(camera, Width, Height, XMFLOAT3(5000.0f, 1000.0f, 7000.0f));
+
+	XMFLOAT3 origin, direction;
+	camera.ComputeRay(XMFLOAT2(Width / 2.0f, Height / 2.0f), origin, direction);
+	CHECK(origin.x == 5000.0f && origin.y == 1000.0f && origin.z == 7000.0f);
+	CHECK_NEAR(direction.y, -1.0f, 1e-6f);
+
+	XMFLOAT2 screen_point(Width / 2.0f, Height / 2.0f);
+	XMFLOAT2 plane_point;
+	camera.UnprojectToPlane(&screen_point, 1, 0.0f, &plane_point);
+	CHECK_NEAR(plane_point.x, 5000.0f, 0.01f);
+	CHECK_NEAR(plane_point.y, 7000.0f, 0.01f);
+}
+
+static void TestEdgesFollowTheLens()
+{
+	// The middle of the right edge is height * tan(fov / 2) * aspect away along the camera's right
+	// axis, and the middle of the bottom edge height * tan(fov / 2) along its negative up axis
+	const float height = 1000.0f;
+	CameraCore camera;
+	SetUpMapCamera(camera, Width, Height, XMFLOAT3(0.0f, height, 0.0f));
+	auto half_height = height * tanf(FovY / 2.0f);
+	auto half_width = half_height * Width / Height;
+	auto& right = camera.GetRight();
+	auto& up = camera.GetUp();
+
+	XMFLOAT2 screen_points[2] = { XMFLOAT2(Width, Height / 2.0f), XMFLOAT2(Width / 2.0f, Height) };
+	XMFLOAT2 plane_points[2];
+	camera.UnprojectToPlane(screen_points, 2, 0.0f, plane_points);
+	CHECK_NEAR(plane_points[0].x, right.x * half_width, 0.05f);
+	CHECK_NEAR(plane_points[0].y, right.z * half_width, 0.05f);
+	CHECK_NEAR(plane_points[1].x, -up.x * half_height, 0.05f);
+	CHECK_NEAR(plane_points[1].y, -up.z * half_height, 0.05f);
+}
+
+static void TestBatchesMatchSingleRays()
+{
+	// A tilted and turned camera over a plane that is not at 0. The count is not a multiple of
+	// four so the partial last batch is covered too.
+	CameraCore camera;
+	camera.SetLens(FovY, Width / Height, 1.0f, 100000.0f);
+	camera.SetViewport(Width, Height);
+	camera.SetPosition(XMFLOAT3(2097152.0f, 800.0f, 2097152.0f));
+	camera.Yaw(XMConvertToRadians(30.0f));
+	camera.Pitch(XMConvertToRadians(70.0f));
+	const float plane_y = 10.0f;
+
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> x(0.0f, Width);
+	std::uniform_real_distribution<float> y(0.0f, Height);
+	std::vector<XMFLOAT2> screen_points(1003);
+	for (auto& point : screen_points)
+		point = XMFLOAT2(x(random), y(random));
+
+	std::vector<XMFLOAT2> plane_points(screen_points.size());
+	camera.UnprojectToPlane(screen_points.data(), screen_points.size(), plane_y, plane_points.data());
+	for (size_t i = 0; i < screen_points.size(); ++i)
+	{
+		XMFLOAT3 origin, direction;
+		camera.ComputeRay(screen_points[i], origin, direction);
+		auto expected = RayToPlane(origin, direction, plane_y);
+		// Within a map pixel, at map coordinates where a float step is a quarter pixel
+		CHECK_NEAR(plane_points[i].x, expected.x, 1.0f);
+		CHECK_NEAR(plane_points[i].y, expected.y, 1.0f);
+	}
+}
+
+static void TestMissesGiveNaN()
+{
+	// Looking at the horizon, the top half of the viewport never reaches the ground
+	CameraCore camera;
+	camera.SetLens(FovY, Width / Height, 1.0f, 100000.0f);
+	camera.SetViewport(Width, Height);
+	camera.SetPosition(XMFLOAT3(0.0f, 100.0f, 0.0f));
+
+	XMFLOAT2 screen_points[3] = { XMFLOAT2(Width / 2.0f, 0.0f), XMFLOAT2(Width / 2.0f, Height / 2.0f), XMFLOAT2(Width / 2.0f, Height) };
+	XMFLOAT2 plane_points[3];
+	camera.UnprojectToPlane(screen_points, 3, 0.0f, plane_points);
+	CHECK(std::isnan(plane_points[0].x) && std::isnan(plane_points[0].y));
+	// The centre ray is parallel to the ground
+	CHECK(std::isnan(plane_points[1].x) && std::isnan(plane_points[1].y));
+	CHECK(!std::isnan(plane_points[2].x) && plane_points[2].y > 0.0f);
+}
+
+static void TestFollowsViewportAndPosition()
+{
+	// After a resize the centre of the new viewport still hits below the camera, and after a move
+	// the cached matrices are rebuilt for the new position
+	CameraCore camera;
+	SetUpMapCamera(camera, 800.0f, 600.0f, XMFLOAT3(100.0f, 500.0f, 200.0f));
+	XMFLOAT2 screen_point(400.0f, 300.0f);
+	XMFLOAT2 plane_point;
+	camera.UnprojectToPlane(&screen_point, 1, 0.0f, &plane_point);
+	CHECK_NEAR(plane_point.x, 100.0f, 0.01f);
+
+	camera.SetLens(FovY, Width / Height, 1.0f, 100000.0f);
+	camera.SetViewport(Width, Height);
+	CHECK(camera.GetViewportWidth() == Width && camera.GetViewportHeight() == Height);
+	screen_point = XMFLOAT2(Width / 2.0f, Height / 2.0f);
+	camera.UnprojectToPlane(&screen_point, 1, 0.0f, &plane_point);
+	CHECK_NEAR(plane_point.x, 100.0f, 0.01f);
+	CHECK_NEAR(plane_point.y, 200.0f, 0.01f);
+
+	camera.SetPosition(XMFLOAT3(-300.0f, 500.0f, 900.0f));
+	camera.UnprojectToPlane(&screen_point, 1, 0.0f, &plane_point);
+	CHECK_NEAR(plane_point.x, -300.0f, 0.01f);
+	CHECK_NEAR(plane_point.y, 900.0f, 0.01f);
+
+	// The inverse view built from the axes undoes the view
+	auto product = XMLoadFloat4x4(&camera.GetView()) * XMLoadFloat4x4(&camera.GetInverseView());
+	XMFLOAT4X4 identity;
+	XMStoreFloat4x4(&identity, product);
+	for (int row = 0; row < 4; ++row)
+	{
+		for (int column = 0; column < 4; ++column)
+			CHECK_NEAR(identity(row, column), row == column ? 1.0f : 0.0f, 1e-4f);
+	}
+}
+
+int main()
+{
+	RUN_TEST(TestCentreHitsBelowTheCamera);
+	RUN_TEST(TestEdgesFollowTheLens);
+	RUN_TEST(TestBatchesMatchSingleRays);
+	RUN_TEST(TestMissesGiveNaN);
+	RUN_TEST(TestFollowsViewportAndPosition);
+	return 0;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// ASSERT compiles away in release builds, so the tests use their own check that always runs and
+// fails the test executable with the expression that did not hold.
+#define CHECK(expression) ((expression) ? (void)0 : CheckFailed(#expression, __FILE__, __LINE__))
+#define CHECK_NEAR(a, b, tolerance) CHECK(std::fabs((a) - (b)) <= (tolerance))
+
+inline void CheckFailed(const char* expression, const char* filename, int line)
+{
+	fprintf(stderr, "%s(%d): CHECK(%s) failed\n", filename, line, expression);
+	exit(1);
+}
+
+// Runs one test function and reports its name, so a failure can be found in the ctest log
+#define RUN_TEST(test) (printf("%s\n", #test), test())
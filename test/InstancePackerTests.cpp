@@ -0,0 +1,77 @@
+#include <Check.h>
+#include <Game/InstancePacker.h>
+
+static StaticFeature MakeFeature(float x, float y, unsigned color, float rotation, float scale)
+{
+	StaticFeature feature;
+	feature.position = XMFLOAT2(x, y);
+	feature.color = color;
+	feature.rotation = rotation;
+	feature.scale = scale;
+	return feature;
+}
+
+static void TestPacksEveryField()
+{
+	auto feature = MakeFeature(1024.0f, 2048.0f, 0xFF8000FF, 0.5f, 2.0f);
+	InstancePacker packer;
+	packer.Pack(&feature, 1);
+
+	CHECK(packer.GetCount() == 1);
+	auto& instance = packer.GetData()[0];
+	CHECK(instance.position.x == 1024.0f);
+	CHECK(instance.position.y == 2048.0f);
+	CHECK(instance.rotation == 0.5f);
+	CHECK(instance.scale == 2.0f * STATIC_FEATURE_MODEL_SCALE);
+	CHECK(instance.color.x == 1.0f);
+	CHECK_NEAR(instance.color.y, 128.0f / 255.0f, 1e-6f);
+	CHECK(instance.color.z == 0.0f);
+	CHECK(instance.color.w == 1.0f);
+}
+
+static void TestKeepsDrawListOrder()
+{
+	std::vector<StaticFeature> features;
+	for (int i = 0; i < 100; ++i)
+		features.push_back(MakeFeature(static_cast<float>(i), static_cast<float>(100 - i), static_cast<unsigned>(i), 0.0f, 1.0f));
+
+	InstancePacker packer;
+	packer.Pack(features.data(), features.size());
+
+	CHECK(packer.GetCount() == features.size());
+	CHECK(packer.GetByteSize() == features.size() * sizeof(StaticFeatureInstance));
+	for (int i = 0; i < 100; ++i)
+	{
+		auto& instance = packer.GetData()[i];
+		CHECK(instance.position.x == static_cast<float>(i));
+		CHECK(instance.position.y == static_cast<float>(100 - i));
+		CHECK_NEAR(instance.color.w, i / 255.0f, 1e-6f);
+	}
+}
+
+static void TestRepackShrinksToTheNewList()
+{
+	std::vector<StaticFeature> features(10, MakeFeature(1.0f, 1.0f, 0xFFFFFFFF, 0.0f, 1.0f));
+	InstancePacker packer;
+	packer.Pack(features.data(), features.size());
+	CHECK(packer.GetCount() == 10);
+
+	auto last = MakeFeature(7.0f, 8.0f, 0x000000FF, 0.0f, 0.5f);
+	packer.Pack(&last, 1);
+	CHECK(packer.GetCount() == 1);
+	CHECK(packer.GetByteSize() == sizeof(StaticFeatureInstance));
+	CHECK(packer.GetData()[0].position.x == 7.0f);
+	CHECK(packer.GetData()[0].scale == 0.5f * STATIC_FEATURE_MODEL_SCALE);
+
+	packer.Pack(nullptr, 0);
+	CHECK(packer.GetCount() == 0);
+	CHECK(packer.GetByteSize() == 0);
+}
+
+int main()
+{
+	RUN_TEST(TestPacksEveryField);
+	RUN_TEST(TestKeepsDrawListOrder);
+	RUN_TEST(TestRepackShrinksToTheNewList);
+	return 0;
+}
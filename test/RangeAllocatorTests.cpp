@@ -0,0 +1,107 @@
+#include <Check.h>
+#include <Core/RangeAllocator.h>
+
+static void TestFreeMergesWithBothNeighbours()
+{
+	RangeAllocator allocator(100);
+	auto a = allocator.Allocate(10);
+	auto b = allocator.Allocate(20);
+	auto c = allocator.Allocate(30);
+	CHECK(allocator.GetRange(a).offset == 0);
+	CHECK(allocator.GetRange(b).offset == 10);
+	CHECK(allocator.GetRange(c).offset == 30);
+	CHECK(allocator.GetStats().free_block_count == 1);
+
+	// a and c leave two holes that the tail does not touch
+	allocator.Free(a);
+	allocator.Free(c);
+	auto stats = allocator.GetStats();
+	CHECK(stats.free_block_count == 2);
+	CHECK(stats.largest_free_block == 70);
+	CHECK(stats.free == 80);
+
+	// Freeing b joins the hole before it, itself and the tail into one block
+	allocator.Free(b);
+	stats = allocator.GetStats();
+	CHECK(stats.free_block_count == 1);
+	CHECK(stats.largest_free_block == 100);
+	CHECK(stats.used == 0);
+	CHECK(stats.GetFragmentation() == 0.0f);
+	CHECK(allocator.GetRange(allocator.Allocate(100)).offset == 0);
+}
+
+static void TestFreeMergesWithOneNeighbour()
+{
+	RangeAllocator allocator(40);
+	auto a = allocator.Allocate(10);
+	auto b = allocator.Allocate(10);
+	auto c = allocator.Allocate(10);
+	auto d = allocator.Allocate(10);
+	allocator.Free(b);
+	allocator.Free(a);
+	CHECK(allocator.GetStats().free_block_count == 1);
+	CHECK(allocator.GetStats().largest_free_block == 20);
+
+	allocator.Free(c);
+	CHECK(allocator.GetStats().free_block_count == 1);
+	CHECK(allocator.GetStats().largest_free_block == 30);
+	CHECK(allocator.Contains(d));
+	CHECK(!allocator.Contains(c));
+}
+
+static void TestAllocateFailsWhenFull()
+{
+	RangeAllocator allocator(64);
+	auto a = allocator.Allocate(32);
+	auto b = allocator.Allocate(32);
+	CHECK(a != RangeAllocator::InvalidID);
+	CHECK(b != RangeAllocator::InvalidID);
+	CHECK(allocator.Allocate(1) == RangeAllocator::InvalidID);
+
+	// Free space split in two blocks is too fragmented for a request larger than either
+	RangeAllocator fragmented(30);
+	auto x = fragmented.Allocate(10);
+	fragmented.Allocate(10);
+	auto z = fragmented.Allocate(10);
+	fragmented.Free(x);
+	fragmented.Free(z);
+	CHECK(fragmented.GetStats().free == 20);
+	CHECK(fragmented.Allocate(15) == RangeAllocator::InvalidID);
+	CHECK(fragmented.GetStats().GetFragmentation() == 0.5f);
+
+	// Compacting leaves the free space in one block at the end, so the request fits
+	uint32_t moved = 0;
+	fragmented.Compact([&](uint32_t from, uint32_t to, uint32_t count)
+	{
+		CHECK(to < from);
+		moved += count;
+	});
+	CHECK(moved == 10);
+	auto w = fragmented.Allocate(15);
+	CHECK(w != RangeAllocator::InvalidID);
+	CHECK(fragmented.GetRange(w).offset == 10);
+
+	// Growing adds the new space to the free block at the end
+	CHECK(allocator.Allocate(16) == RangeAllocator::InvalidID);
+	allocator.Grow(80);
+	CHECK(allocator.GetStats().free_block_count == 1);
+	CHECK(allocator.GetRange(allocator.Allocate(16)).offset == 64);
+}
+
+static void TestStripIndices()
+{
+	std::vector<uint32_t> indices;
+	AppendStripIndices(indices, 5, 3);
+	AppendStripIndices(indices, 20, 2);
+	std::vector<uint32_t> expected = { 5, 6, 7, STRIP_CUT_INDEX, 20, 21, STRIP_CUT_INDEX };
+	CHECK(indices == expected);
+}
+
+int main()
+{
+	RUN_TEST(TestFreeMergesWithBothNeighbours);
+	RUN_TEST(TestFreeMergesWithOneNeighbour);
+	RUN_TEST(TestAllocateFailsWhenFull);
+	RUN_TEST(TestStripIndices);
+	return 0;
+}
@@ -0,0 +1,162 @@
+#include <Check.h>
+#include <Core/RenderCommandBuffer.h>
+
+using namespace DirectX;
+
+static const PipelineID LinePipeline = 0;
+static const PipelineID InstancedPipeline = 1;
+static const BufferID SquareBuffer = RENDER_TRANSIENT_BUFFER_COUNT;
+static const BufferID CubeVertices = RENDER_TRANSIENT_BUFFER_COUNT + 1;
+static const BufferID CubeIndices = RENDER_TRANSIENT_BUFFER_COUNT + 2;
+
+static void TestSortKeyOrder()
+{
+	// Each field outranks every field after it, whatever their values
+	CHECK(MakeRenderSortKey(RenderLayer::Background, 9, 9, 9) < MakeRenderSortKey(RenderLayer::TileBorders, 0, 0, 0));
+	CHECK(MakeRenderSortKey(RenderLayer::Overlay, 1, 0, 0) < MakeRenderSortKey(RenderLayer::Overlay, 2, 0, 0));
+	CHECK(MakeRenderSortKey(RenderLayer::Overlay, 1, 9, 0) < MakeRenderSortKey(RenderLayer::Overlay, 2, 0, 0));
+	CHECK(MakeRenderSortKey(RenderLayer::Overlay, 1, 1, 9) < MakeRenderSortKey(RenderLayer::Overlay, 1, 2, 0));
+	CHECK(MakeRenderSortKey(RenderLayer::Overlay, 1, 1, 1) < MakeRenderSortKey(RenderLayer::Overlay, 1, 1, 2));
+	// The sequence wraps inside its own bits instead of spilling into the buffer
+	CHECK(MakeRenderSortKey(RenderLayer::Overlay, 0, 0, RENDER_SORT_SEQUENCE_MASK + 1) == MakeRenderSortKey(RenderLayer::Overlay, 0, 0, 0));
+}
+
+static void TestSortsByLayerThenPipeline()
+{
+	RenderCommandBuffer commands;
+	auto object = commands.AddObject(XMMatrixIdentity(), 0xFFFFFFFF);
+	commands.Draw(RenderLayer::Overlay, LinePipeline, RenderTopology::LineList, RENDER_TRANSIENT_VERTICES, 0, 2, object);
+	commands.DrawIndexedInstanced(RenderLayer::StaticFeatures, InstancedPipeline, RenderTopology::TriangleList,
+		CubeVertices, CubeIndices, 36, RENDER_TRANSIENT_INSTANCES, 0, 10, RENDER_NO_OBJECT);
+	commands.Draw(RenderLayer::TileBorders, LinePipeline, RenderTopology::LineStrip, SquareBuffer, 0, 5, object);
+	commands.Draw(RenderLayer::Background, InstancedPipeline, RenderTopology::TriangleList, SquareBuffer, 0, 6, object);
+	commands.Draw(RenderLayer::Background, LinePipeline, RenderTopology::TriangleList, SquareBuffer, 0, 6, object);
+	CHECK(commands.GetSubmittedCount() == 5);
+
+	commands.SortAndMerge();
+	auto& sorted = commands.GetCommands();
+	CHECK(sorted.size() == 5);
+	for (size_t i = 1; i < sorted.size(); ++i)
+		CHECK(sorted[i - 1].sort_key < sorted[i].sort_key);
+	CHECK(sorted[0].pipeline == LinePipeline && sorted[0].count == 6);
+	CHECK(sorted[1].pipeline == InstancedPipeline && sorted[1].count == 6);
+	CHECK(sorted[2].topology == RenderTopology::LineStrip);
+	CHECK(sorted[3].instance_buffer == RENDER_TRANSIENT_INSTANCES);
+	CHECK(sorted[4].vertex_buffer == RENDER_TRANSIENT_VERTICES);
+}
+
+static void TestMergesAdjacentRanges()
+{
+	// Three line segments of one colour appended one after another become a single draw; a
+	// fourth with another colour cannot join them
+	RenderCommandBuffer commands;
+	auto white = commands.AddObject(XMMatrixIdentity(), 0xFFFFFFFF);
+	CHECK(commands.AddObject(XMMatrixIdentity(), 0xFFFFFFFF) == white);
+	for (uint32_t i = 0; i < 3; ++i)
+		commands.Draw(RenderLayer::Overlay, LinePipeline, RenderTopology::LineList, RENDER_TRANSIENT_VERTICES, i * 2, 2, white);
+	auto red = commands.AddObject(XMMatrixIdentity(), 0xFF0000FF);
+	CHECK(red == white + 1);
+	commands.Draw(RenderLayer::Overlay, LinePipeline, RenderTopology::LineList, RENDER_TRANSIENT_VERTICES, 6, 2, red);
+
+	commands.SortAndMerge();
+	auto& merged = commands.GetCommands();
+	CHECK(merged.size() == 2);
+	CHECK(merged[0].first == 0 && merged[0].count == 6 && merged[0].object == white);
+	CHECK(merged[1].first == 6 && merged[1].count == 2 && merged[1].object == red);
+
+	NullRenderBackend backend;
+	backend.Execute(commands);
+	CHECK(backend.GetStats().draw_calls == 2);
+	CHECK(backend.GetStats().elements == 8);
+	CHECK(backend.GetStats().pipeline_changes == 1);
+	CHECK(backend.GetStats().object_uploads == 1);
+}
+
+static void TestMergesConsecutiveObjectsIntoInstances()
+{
+	// Tile borders: the same five vertices drawn with a world matrix each
+	RenderCommandBuffer commands;
+	for (int i = 0; i < 4; ++i)
+	{
+		auto object = commands.AddObject(XMMatrixTranslation(256.0f * i, 1.0f, 0.0f), 0xFFFF77FF);
+		commands.Draw(RenderLayer::TileBorders, LinePipeline, RenderTopology::LineStrip, SquareBuffer, 0, 5, object);
+	}
+	// Not the next object, so it starts a draw of its own
+	commands.Draw(RenderLayer::TileBorders, LinePipeline, RenderTopology::LineStrip, SquareBuffer, 0, 5, 0);
+
+	commands.SortAndMerge();
+	auto& merged = commands.GetCommands();
+	CHECK(merged.size() == 2);
+	CHECK(merged[0].object == 0 && merged[0].instance_count == 4 && merged[0].count == 5);
+	CHECK(merged[1].object == 0 && merged[1].instance_count == 0);
+
+	NullRenderBackend backend;
+	backend.Execute(commands);
+	CHECK(backend.GetStats().draw_calls == 2);
+	CHECK(backend.GetStats().elements == 5 * 4 + 5);
+}
+
+static void TestKeepsStripsApart()
+{
+	// Joining two strips would draw a segment between them, so they stay separate draws
+	RenderCommandBuffer commands;
+	auto object = commands.AddObject(XMMatrixIdentity(), 0xFFFFFFFF);
+	commands.Draw(RenderLayer::DynamicFeatures, LinePipeline, RenderTopology::LineStrip, SquareBuffer, 0, 5, object);
+	commands.Draw(RenderLayer::DynamicFeatures, LinePipeline, RenderTopology::LineStrip, SquareBuffer, 5, 5, object);
+	commands.SortAndMerge();
+	CHECK(commands.GetCommands().size() == 2);
+}
+
+static void TestMergesInstanceRuns()
+{
+	RenderCommandBuffer commands;
+	uint8_t instances[32 * 30] = {};
+	auto first = commands.AppendTransient(RENDER_TRANSIENT_INSTANCES, instances, 10, 32);
+	auto second = commands.AppendTransient(RENDER_TRANSIENT_INSTANCES, instances, 20, 32);
+	CHECK(first == 0 && second == 10);
+	commands.DrawIndexedInstanced(RenderLayer::StaticFeatures, InstancedPipeline, RenderTopology::TriangleList,
+		CubeVertices, CubeIndices, 36, RENDER_TRANSIENT_INSTANCES, first, 10, RENDER_NO_OBJECT);
+	commands.DrawIndexedInstanced(RenderLayer::StaticFeatures, InstancedPipeline, RenderTopology::TriangleList,
+		CubeVertices, CubeIndices, 36, RENDER_TRANSIENT_INSTANCES, second, 20, RENDER_NO_OBJECT);
+
+	commands.SortAndMerge();
+	auto& merged = commands.GetCommands();
+	CHECK(merged.size() == 1);
+	CHECK(merged[0].first_instance == 0 && merged[0].instance_count == 30);
+
+	NullRenderBackend backend;
+	backend.Execute(commands);
+	CHECK(backend.GetStats().draw_calls == 1);
+	CHECK(backend.GetStats().elements == 36 * 30);
+	CHECK(backend.GetStats().object_uploads == 0);
+	CHECK(backend.GetStats().transient_bytes == sizeof(instances));
+}
+
+static void TestResetClearsTheFrame()
+{
+	RenderCommandBuffer commands;
+	uint32_t index = 7;
+	commands.AppendTransient(RENDER_TRANSIENT_INDICES, &index, 1, sizeof(index));
+	commands.Draw(RenderLayer::Overlay, LinePipeline, RenderTopology::LineList, RENDER_TRANSIENT_VERTICES, 0, 2,
+		commands.AddObject(XMMatrixIdentity(), 0xFFFFFFFF));
+	commands.Reset();
+	CHECK(commands.GetCommands().empty());
+	CHECK(commands.GetObjects().empty());
+	CHECK(commands.GetSubmittedCount() == 0);
+	CHECK(commands.GetTransientByteSize(RENDER_TRANSIENT_INDICES) == 0);
+	// A new frame may use another stride
+	commands.AppendTransient(RENDER_TRANSIENT_INDICES, &index, 1, sizeof(uint16_t));
+	CHECK(commands.GetTransientStride(RENDER_TRANSIENT_INDICES) == sizeof(uint16_t));
+}
+
+int main()
+{
+	RUN_TEST(TestSortKeyOrder);
+	RUN_TEST(TestSortsByLayerThenPipeline);
+	RUN_TEST(TestMergesAdjacentRanges);
+	RUN_TEST(TestMergesConsecutiveObjectsIntoInstances);
+	RUN_TEST(TestKeepsStripsApart);
+	RUN_TEST(TestMergesInstanceRuns);
+	RUN_TEST(TestResetClearsTheFrame);
+	return 0;
+}
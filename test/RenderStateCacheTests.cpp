@@ -0,0 +1,123 @@
+#include <Check.h>
+#include <Core/RenderStateCache.h>
+
+using namespace DirectX;
+
+static const PipelineID LinePipeline = 0;
+static const PipelineID TrianglePipeline = 1;
+static const BufferID SquareBuffer = RENDER_TRANSIENT_BUFFER_COUNT;
+
+static void TestSkipsRedundantBinds()
+{
+	int layout = 0;
+	int shader = 0;
+	RenderStateCache state;
+	CHECK(state.SetInputLayout(&layout));
+	CHECK(!state.SetInputLayout(&layout));
+	CHECK(state.SetVertexShader(&shader));
+	CHECK(!state.SetVertexShader(&shader));
+	// Nothing is bound yet, so even the first topology in the enum binds
+	CHECK(state.SetTopology(RenderTopology::PointList));
+	CHECK(!state.SetTopology(RenderTopology::PointList));
+	CHECK(state.SetTopology(RenderTopology::LineList));
+	CHECK(state.SetVertexBuffers(SquareBuffer, RENDER_NO_BUFFER));
+	CHECK(!state.SetVertexBuffers(SquareBuffer, RENDER_NO_BUFFER));
+	// Either stream changing rebinds both
+	CHECK(state.SetVertexBuffers(SquareBuffer, RENDER_TRANSIENT_INSTANCES));
+	CHECK(state.SetIndexBuffer(RENDER_TRANSIENT_INDICES));
+	CHECK(!state.SetIndexBuffer(RENDER_TRANSIENT_INDICES));
+	CHECK(state.GetBindCount() == 7);
+	CHECK(state.GetRedundantBindCount() == 5);
+}
+
+static void TestRebindsAfterInvalidate()
+{
+	int layout = 0;
+	int shader = 0;
+	RenderStateCache state;
+	auto bind_all = [&]()
+	{
+		int bound = 0;
+		bound += state.SetInputLayout(&layout);
+		bound += state.SetVertexShader(&shader);
+		bound += state.SetPixelShader(&shader);
+		bound += state.SetTopology(RenderTopology::LineList);
+		bound += state.SetVertexBuffers(SquareBuffer, RENDER_NO_BUFFER);
+		bound += state.SetIndexBuffer(RENDER_TRANSIENT_INDICES);
+		return bound;
+	};
+	CHECK(bind_all() == 6);
+	CHECK(bind_all() == 0);
+
+	// After a device reset nothing the cache remembers is bound any more
+	state.Invalidate();
+	CHECK(bind_all() == 6);
+	CHECK(state.GetBindCount() == 12);
+	CHECK(state.GetRedundantBindCount() == 6);
+
+	state.Reset();
+	CHECK(state.GetBindCount() == 0);
+	CHECK(state.GetRedundantBindCount() == 0);
+	CHECK(bind_all() == 6);
+}
+
+// Two pipelines drawing the same square, alternating, with an object each
+static void RecordAlternatingFrame(RenderCommandBuffer& commands)
+{
+	commands.Reset();
+	for (int i = 0; i < 4; ++i)
+	{
+		auto pipeline = i % 2 == 0 ? LinePipeline : TrianglePipeline;
+		auto topology = i % 2 == 0 ? RenderTopology::LineStrip : RenderTopology::TriangleList;
+		commands.Draw(RenderLayer::Background, pipeline, topology, SquareBuffer, 0, 5,
+			commands.AddObject(XMMatrixTranslation(static_cast<float>(i), 0.0f, 0.0f), 0xFFFFFFFF));
+	}
+}
+
+static void TestNullBackendSkipsRedundantBinds()
+{
+	// Per draw the backend sets the layout, topology, both shaders and the vertex streams. In
+	// submission order every draw changes pipeline, so only the shared vertex streams are kept.
+	RenderCommandBuffer commands;
+	NullRenderBackend backend;
+	RecordAlternatingFrame(commands);
+	backend.Execute(commands);
+	CHECK(backend.GetStats().draw_calls == 4);
+	CHECK(backend.GetStats().pipeline_changes == 4);
+	CHECK(backend.GetStats().state_binds == 5 + 3 * 4);
+	CHECK(backend.GetStats().redundant_binds == 3);
+
+	// Sorted, each pipeline's two draws are neighbours and the second binds nothing. They do not
+	// merge since their objects are not consecutive.
+	commands.SortAndMerge();
+	backend.Execute(commands);
+	CHECK(backend.GetStats().draw_calls == 4);
+	CHECK(backend.GetStats().pipeline_changes == 2);
+	CHECK(backend.GetStats().state_binds == 5 + 4);
+	CHECK(backend.GetStats().redundant_binds == 5 + 1 + 5);
+}
+
+static void TestNullBackendRebindsEachFrame()
+{
+	// Whatever another renderer or a device reset did between frames, the next frame binds its
+	// state again instead of trusting what the last one left bound
+	RenderCommandBuffer commands;
+	NullRenderBackend backend;
+	RecordAlternatingFrame(commands);
+	commands.SortAndMerge();
+	backend.Execute(commands);
+	auto first = backend.GetStats();
+	backend.Execute(commands);
+	CHECK(backend.GetStats().state_binds == first.state_binds);
+	CHECK(backend.GetStats().redundant_binds == first.redundant_binds);
+	CHECK(backend.GetStats().state_binds == 5 + 4);
+}
+
+int main()
+{
+	RUN_TEST(TestSkipsRedundantBinds);
+	RUN_TEST(TestRebindsAfterInvalidate);
+	RUN_TEST(TestNullBackendSkipsRedundantBinds);
+	RUN_TEST(TestNullBackendRebindsEachFrame);
+	return 0;
+}
@@ -0,0 +1,127 @@
+#include <Check.h>
+#include <TileEngine/TileBorders.h>
+#include <algorithm>
+#include <array>
+
+typedef std::array<float, 4> Segment;
+
+// Pairs up the line list, checking every line is a positive length along one axis. Each line
+// is returned as (x0, y0, x1, y1) in map pixels, sorted so the expected lines can be compared.
+static std::vector<Segment> ReadLines(const std::vector<XMFLOAT2>& lines)
+{
+	CHECK(lines.size() % 2 == 0);
+	std::vector<Segment> segments;
+	for (size_t i = 0; i < lines.size(); i += 2)
+	{
+		auto& a = lines[i];
+		auto& b = lines[i + 1];
+		CHECK((a.x == b.x && a.y < b.y) || (a.y == b.y && a.x < b.x));
+		segments.push_back({ a.x, a.y, b.x, b.y });
+	}
+	std::sort(segments.begin(), segments.end());
+	return segments;
+}
+
+// A line along the tile grid of the max zoom level, in tiles
+static Segment GridLine(float x0, float y0, float x1, float y1)
+{
+	return { x0 * TILE_PIXEL_WIDTH, y0 * TILE_PIXEL_WIDTH, x1 * TILE_PIXEL_WIDTH, y1 * TILE_PIXEL_WIDTH };
+}
+
+static void CheckLines(const std::set<TileID>& tiles, std::vector<Segment> expected)
+{
+	std::vector<XMFLOAT2> lines;
+	TileBorders::Build(tiles, lines);
+	CHECK(lines.size() == expected.size() * 2);
+	std::sort(expected.begin(), expected.end());
+	CHECK(ReadLines(lines) == expected);
+}
+
+static void TestOneTile()
+{
+	CheckLines({ Tile(100, 200, TILE_MAX_ZOOM).GetID() }, {
+		GridLine(100, 200, 101, 200),
+		GridLine(100, 201, 101, 201),
+		GridLine(100, 200, 100, 201),
+		GridLine(101, 200, 101, 201) });
+}
+
+static void TestSharedEdgeOnce()
+{
+	// The edge between the two tiles is drawn once, and their top and bottom edges become one
+	// line each: 5 lines instead of 8
+	CheckLines({ Tile(10, 20, TILE_MAX_ZOOM).GetID(), Tile(11, 20, TILE_MAX_ZOOM).GetID() }, {
+		GridLine(10, 20, 12, 20),
+		GridLine(10, 21, 12, 21),
+		GridLine(10, 20, 10, 21),
+		GridLine(11, 20, 11, 21),
+		GridLine(12, 20, 12, 21) });
+}
+
+static void TestRectangle()
+{
+	// w x h tiles take w + h + 2 lines, each spanning the rectangle
+	const int columns = 3;
+	const int rows = 2;
+	std::set<TileID> tiles;
+	for (int x = 0; x < columns; ++x)
+	{
+		for (int y = 0; y < rows; ++y)
+			tiles.insert(Tile(50 + x, 60 + y, TILE_MAX_ZOOM).GetID());
+	}
+	std::vector<Segment> expected;
+	for (int y = 0; y <= rows; ++y)
+		expected.push_back(GridLine(50, 60.0f + y, 50 + columns, 60.0f + y));
+	for (int x = 0; x <= columns; ++x)
+		expected.push_back(GridLine(50.0f + x, 60, 50.0f + x, 60 + rows));
+	CHECK(expected.size() == columns + rows + 2);
+	CheckLines(tiles, expected);
+}
+
+static void TestGapIsNotJoined()
+{
+	CheckLines({ Tile(0, 0, TILE_MAX_ZOOM).GetID(), Tile(2, 0, TILE_MAX_ZOOM).GetID() }, {
+		GridLine(0, 0, 1, 0),
+		GridLine(0, 1, 1, 1),
+		GridLine(2, 0, 3, 0),
+		GridLine(2, 1, 3, 1),
+		GridLine(0, 0, 0, 1),
+		GridLine(1, 0, 1, 1),
+		GridLine(2, 0, 2, 1),
+		GridLine(3, 0, 3, 1) });
+}
+
+static void TestLowerZoomLevel()
+{
+	// A zoom 13 tile covers two max zoom tiles per side, and its level is centred on the map
+	// with the offset Tile::GetPosition uses
+	const float offset = (TILE_SPAN_MAX - TILE_SPAN[TILE_MAX_ZOOM - 1]) / 2.0f;
+	auto scaled = [&](float x0, float y0, float x1, float y1)
+	{
+		return GridLine(x0 + offset, y0 + offset, x1 + offset, y1 + offset);
+	};
+	CheckLines({ Tile(3, 4, TILE_MAX_ZOOM - 1).GetID() }, {
+		scaled(3, 4, 4, 4),
+		scaled(3, 5, 4, 5),
+		scaled(3, 4, 3, 5),
+		scaled(4, 4, 4, 5) });
+	CHECK(offset == TILE_SPAN_MAX / 4);
+}
+
+static void TestEmptySet()
+{
+	std::vector<XMFLOAT2> lines(6);
+	TileBorders::Build({}, lines);
+	CHECK(lines.empty());
+}
+
+int main()
+{
+	RUN_TEST(TestOneTile);
+	RUN_TEST(TestSharedEdgeOnce);
+	RUN_TEST(TestRectangle);
+	RUN_TEST(TestGapIsNotJoined);
+	RUN_TEST(TestLowerZoomLevel);
+	RUN_TEST(TestEmptySet);
+	return 0;
+}
@@ -0,0 +1,87 @@
+#include <Check.h>
+#include <TileEngine/VertexPool.h>
+
+// Reads the strip list back through the pool's vertices, one vector of points per strip
+static std::vector<std::vector<XMFLOAT2>> ReadStrips(const VertexPool& pool, const std::vector<uint32_t>& indices)
+{
+	std::vector<std::vector<XMFLOAT2>> strips(1);
+	for (auto index : indices)
+	{
+		if (index == STRIP_CUT_INDEX)
+			strips.emplace_back();
+		else
+			strips.back().push_back(pool.GetVertices()[index]);
+	}
+	// Every strip ends with a cut, so the last one is always empty
+	CHECK(strips.back().empty());
+	strips.pop_back();
+	return strips;
+}
+
+static void TestStripListLayout()
+{
+	VertexPool pool;
+	XMFLOAT2 line[] = { XMFLOAT2(0.0f, 0.0f), XMFLOAT2(1.0f, 0.0f), XMFLOAT2(1.0f, 1.0f) };
+	XMFLOAT2 segment[] = { XMFLOAT2(2.0f, 2.0f), XMFLOAT2(3.0f, 3.0f) };
+	auto a = pool.Add(line, 3, XMFLOAT2(100.0f, 200.0f));
+	auto b = pool.Add(segment, 2, XMFLOAT2(0.0f, 0.0f));
+
+	std::vector<uint32_t> indices;
+	pool.AppendStripIndices(indices, a);
+	pool.AppendStripIndices(indices, b);
+
+	// Each view is its own strip, cut from the next with the primitive restart index
+	CHECK(indices.size() == 3 + 1 + 2 + 1);
+	CHECK(indices[3] == STRIP_CUT_INDEX);
+	CHECK(indices[6] == STRIP_CUT_INDEX);
+	auto strips = ReadStrips(pool, indices);
+	CHECK(strips.size() == 2);
+	CHECK(strips[0].size() == 3);
+	CHECK(strips[0][0].x == 100.0f && strips[0][0].y == 200.0f);
+	CHECK(strips[0][2].x == 101.0f && strips[0][2].y == 201.0f);
+	CHECK(strips[1].size() == 2);
+	CHECK(strips[1][1].x == 3.0f && strips[1][1].y == 3.0f);
+}
+
+static void TestCompactionKeepsStrips()
+{
+	// Half the pool for a, a quarter for b, then a is removed. The free space is in two blocks of
+	// a half and a quarter, so a range of just over half only fits after compacting.
+	VertexPool pool;
+	const uint32_t quarter = VERTEX_POOL_INITIAL_CAPACITY / 4;
+	std::vector<XMFLOAT2> first(2 * quarter, XMFLOAT2(1.0f, 1.0f));
+	std::vector<XMFLOAT2> second(quarter);
+	for (uint32_t i = 0; i < quarter; i++)
+		second[i] = XMFLOAT2(static_cast<float>(i), 0.0f);
+	auto a = pool.Add(first.data(), first.size(), XMFLOAT2(0.0f, 0.0f));
+	auto b = pool.Add(second.data(), second.size(), XMFLOAT2(0.0f, 0.0f));
+	CHECK(pool.GetRange(b).offset == 2 * quarter);
+	pool.Remove(a);
+	CHECK(pool.GetStats().free_block_count == 2);
+
+	std::vector<XMFLOAT2> large(2 * quarter + 1, XMFLOAT2(5.0f, 5.0f));
+	auto c = pool.Add(large.data(), large.size(), XMFLOAT2(0.0f, 0.0f));
+	CHECK(c != RangeAllocator::InvalidID);
+	CHECK(pool.GetStats().compaction_count == 1);
+	CHECK(pool.GetGrowCount() == 0);
+	CHECK(pool.GetRange(b).offset == 0);
+	CHECK(pool.GetRange(c).offset == quarter);
+
+	std::vector<uint32_t> indices;
+	pool.AppendStripIndices(indices, b);
+	pool.AppendStripIndices(indices, c);
+	auto strips = ReadStrips(pool, indices);
+	CHECK(strips.size() == 2);
+	CHECK(strips[0].size() == quarter);
+	for (uint32_t i = 0; i < quarter; i++)
+		CHECK(strips[0][i].x == static_cast<float>(i));
+	CHECK(strips[1].size() == large.size());
+	CHECK(strips[1][0].x == 5.0f && strips[1].back().x == 5.0f);
+}
+
+int main()
+{
+	RUN_TEST(TestStripListLayout);
+	RUN_TEST(TestCompactionKeepsStrips);
+	return 0;
+}